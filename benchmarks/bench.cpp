@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <loggerlib/executor.hpp>
+#include <loggerlib/logger.hpp>
+#include <loggerlib/profiler.hpp>
+#include <loggerlib/task.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace loggerlib;
+
+namespace {
+
+constexpr long ITERATIONS = 10'000'000;
+
+template <typename F>
+void run(const std::string &name, long iterations, F &&func) {
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        func(i);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double ns =
+        std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+
+    std::cout << std::left << std::setw(40) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(2) << ns
+              << " ns/op\n";
+}
+
+std::string dump(long value) {
+    return "{id: " + std::to_string(value) + ", state: running}";
+}
+
+// ERROR latency while other threads flood the DEBUG lane
+void error_latency_under_flood(const char *filename) {
+    std::cout << "== ERROR latency under DEBUG flood ==\n";
+
+    for (bool async : {false, true}) {
+        Logger logger(filename, LogLevel::DEBUG);
+        if (async) {
+            logger.enable_async();
+        }
+
+        std::atomic<bool> running{true};
+        std::vector<std::thread> flooders;
+        for (int t = 0; t < 4; ++t) {
+            flooders.emplace_back([&]() {
+                while (running.load(std::memory_order_relaxed)) {
+                    logger.log(std::string(200, 'd'), LogLevel::DEBUG);
+                }
+            });
+        }
+
+        std::vector<double> latencies;
+        for (int i = 0; i < 1000; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            logger.log("error " + std::to_string(i), LogLevel::ERROR);
+            latencies.push_back(std::chrono::duration<double, std::micro>(
+                                    std::chrono::steady_clock::now() - start
+            )
+                                    .count());
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+
+        running.store(false);
+        for (auto &thread : flooders) {
+            thread.join();
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << (async ? "async lanes" : "synchronous") << ": p50 "
+                  << latencies[latencies.size() / 2] << " us, p99 "
+                  << latencies[latencies.size() * 99 / 100] << " us\n";
+    }
+}
+
+// Messages per second with N producer threads
+void producer_scaling(const char *filename) {
+    std::cout << "== Producer scaling, 200k INFO messages per thread ==\n";
+
+    for (bool async : {false, true}) {
+        for (int threads_count : {1, 2, 4, 8}) {
+            Logger logger(filename, LogLevel::INFO);
+            if (async) {
+                AsyncOptions options;
+                options.lanes[1].capacity = 1 << 20;
+                logger.enable_async(options);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> producers;
+            for (int t = 0; t < threads_count; ++t) {
+                producers.emplace_back([&]() {
+                    for (int i = 0; i < 200'000; ++i) {
+                        logger.log("request handled", LogLevel::INFO);
+                    }
+                });
+            }
+            for (auto &thread : producers) {
+                thread.join();
+            }
+            double seconds = std::chrono::duration<double>(
+                                 std::chrono::steady_clock::now() - start
+            )
+                                 .count();
+
+            std::cout << (async ? "async staging" : "synchronous") << ", "
+                      << threads_count << " threads: "
+                      << static_cast<long>(threads_count * 200'000 / seconds)
+                      << " msg/s\n";
+        }
+        std::remove(filename);
+    }
+}
+
+Task coroutine_producer(Logger &logger, int messages, bool await, int &done) {
+    for (int i = 0; i < messages; ++i) {
+        if (await) {
+            co_await logger.log_async("request handled", LogLevel::INFO);
+        } else {
+            logger.log("request handled", LogLevel::INFO);
+        }
+    }
+    ++done;
+}
+
+// Coroutines on one event loop thread, small lanes so that backpressure hits
+void coroutine_producers(const char *filename) {
+    std::cout << "== 16 coroutines on one loop, 50k INFO messages each ==\n";
+
+    for (bool await : {false, true}) {
+        Logger logger(filename, LogLevel::INFO);
+        AsyncOptions options;
+        options.lanes[1].capacity = 1024;
+        options.batch_size = 256;
+        logger.enable_async(options);
+
+        EventLoop loop;
+        int done = 0;
+        constexpr int COROUTINES = 16;
+        constexpr int MESSAGES = 50'000;
+
+        // loop latency: how late a task posted every 100us runs
+        std::vector<double> delays;
+        std::atomic<bool> running{true};
+        std::thread ticker([&]() {
+            while (running.load()) {
+                auto posted = std::chrono::steady_clock::now();
+                loop.post([&, posted] {
+                    delays.push_back(std::chrono::duration<double, std::micro>(
+                                         std::chrono::steady_clock::now() - posted
+                    )
+                                         .count());
+                });
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        });
+
+        auto start = std::chrono::steady_clock::now();
+        for (int c = 0; c < COROUTINES; ++c) {
+            loop.post([&] { coroutine_producer(logger, MESSAGES, await, done); });
+        }
+        while (done < COROUTINES) {
+            loop.poll();
+        }
+        double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start
+        )
+                             .count();
+        running.store(false);
+        ticker.join();
+        loop.poll();
+
+        std::sort(delays.begin(), delays.end());
+        std::cout << (await ? "co_await log_async()" : "blocking log()")
+                  << ": "
+                  << static_cast<long>(COROUTINES * MESSAGES / seconds)
+                  << " msg/s, loop delay p99 "
+                  << (delays.empty() ? 0.0 : delays[delays.size() * 99 / 100])
+                  << " us\n";
+    }
+    std::remove(filename);
+}
+
+// Cost of per-call-site profiling on enabled and filtered calls
+void profiling_overhead(const char *filename) {
+    std::cout << "== Profiler overhead ==\n";
+    constexpr long MESSAGES = 1'000'000;
+
+    for (bool profiling : {false, true}) {
+        if (profiling) {
+            Profiler::reset();
+            Profiler::enable();
+        }
+        std::string suffix = profiling ? " (profiled)" : "";
+
+        Logger logger(filename, LogLevel::INFO);
+        AsyncOptions options;
+        options.lanes[1].capacity = 1 << 20;
+        logger.enable_async(options);
+        run("async INFO log()" + suffix, MESSAGES, [&](long) {
+            logger.log("request handled", LogLevel::INFO);
+        });
+        run("filtered LOGGERLIB_DEBUG" + suffix, ITERATIONS, [&](long i) {
+            LOGGERLIB_DEBUG(logger, "state=" + dump(i));
+        });
+        logger.disable_async();
+        std::remove(filename);
+    }
+
+    Profiler::disable();
+    Profiler::report(std::cout, 5);
+}
+
+}  // namespace
+
+int main() {
+    const char *filename = "loggerlib-bench.log";
+    error_latency_under_flood(filename);
+    std::remove(filename);
+
+    producer_scaling(filename);
+    std::remove(filename);
+
+    coroutine_producers(filename);
+
+    profiling_overhead(filename);
+    return 0;
+}
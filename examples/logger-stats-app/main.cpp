@@ -15,75 +15,351 @@
 #include <atomic>
 #include <chrono>
 #include <cstring>
+#include <ctime>
+#include <iomanip>
 #include <iostream>
+#include <loggerlib/io.hpp>
+#include <loggerlib/merge.hpp>
+#include <loggerlib/segment_store.hpp>
+#include <loggerlib/wire.hpp>
+#include <memory>
 #include <mutex>
-#include <numeric>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
 
 constexpr int BACKLOG = 10;
+constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(50);
+// How long a client that sent part of the handshake magic gets for the rest
+constexpr auto MAGIC_WAIT = std::chrono::milliseconds(100);
 
+std::int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch()
+    )
+        .count();
+}
+
+// Restored from the segment footers on start, then counted per message
 struct Stats {
-    std::atomic<std::size_t> total = 0;
-    std::array<std::atomic<std::size_t>, 3> messages_per_level;
-    mutable std::mutex length_mutex;
-    std::vector<std::size_t> lengths;
-    mutable std::mutex time_mutex;
-    std::vector<std::chrono::system_clock::time_point> timestamps;
+    mutable std::mutex mutex;
+    loggerlib::SegmentSummary summary;
 };
 
-void printStats(const Stats &stats) {
+std::string formatStats(const Stats &stats) {
     // get current stats
-    std::size_t total = stats.total.load();
-    std::size_t cnt_debug = stats.messages_per_level[0].load();
-    std::size_t cnt_info = stats.messages_per_level[1].load();
-    std::size_t cnt_error = stats.messages_per_level[2].load();
+    std::size_t total, cnt_debug, cnt_info, cnt_error, cnt_last_hr;
+    std::size_t min_len = 0;
+    std::size_t max_len = 0;
+    double avg_len = 0.0;
+    {
+        std::lock_guard lock(stats.mutex);
+        const auto &summary = stats.summary;
+        total = summary.records;
+        cnt_debug = summary.levels[0];
+        cnt_info = summary.levels[1];
+        cnt_error = summary.levels[2];
+        // counted by minute
+        cnt_last_hr = summary.since(nowMs() - 3600 * 1000);
+        if (total > 0) {
+            min_len = summary.min_length;
+            max_len = summary.max_length;
+            avg_len = static_cast<double>(summary.bytes) / total;
+        }
+    }
+
+    // format stats
+    std::ostringstream oss;
+    oss << "\n============ Statistics ============\n"
+        << "Total messages: " << total << "\n"
+        << "DEBUG: " << cnt_debug << ", INFO: " << cnt_info
+        << ", ERROR: " << cnt_error << "\n"
+        << "Last hour: " << cnt_last_hr << "\n"
+        << "Length - min: " << min_len << ", max: " << max_len
+        << ", avg: " << avg_len << "\n"
+        << "====================================\n";
+    return oss.str();
+}
 
-    std::vector<std::size_t> lens;
+// Lines of all clients in timestamp order, written by a single thread in
+// batches so that lines of different clients never interleave
+class Output {
+public:
+    Output(const Stats &stats, loggerlib::MergeOptions options)
+        : stats_(stats), merger_(options) {}
 
+    std::size_t addStream() {
+        std::lock_guard lock(mutex_);
+        return merger_.add_stream();
+    }
+
+    void
+    push(std::size_t stream, std::vector<loggerlib::merge::Entry> &entries) {
+        std::lock_guard lock(mutex_);
+        for (auto &entry : entries) {
+            merger_.push(stream, std::move(entry));
+        }
+        entries.clear();
+    }
+
+    void closeStream(std::size_t stream) {
+        std::lock_guard lock(mutex_);
+        merger_.close_stream(stream);
+    }
+
+    // Statistics are printed after the lines released next
+    void requestStats() {
+        stats_due_.store(true);
+    }
+
+    // Writer loop
+    void run(const std::atomic<bool> &running) {
+        std::string out;
+        loggerlib::merge::Entry entry;
+        while (running.load()) {
+            std::this_thread::sleep_for(FLUSH_INTERVAL);
+            {
+                std::lock_guard lock(mutex_);
+                merger_.advance(nowMs());
+                while (merger_.pop(entry)) {
+                    out += entry.text;
+                }
+            }
+            if (stats_due_.exchange(false)) {
+                out += formatStats(stats_);
+            }
+            if (!out.empty()) {
+                loggerlib::write_all(STDOUT_FILENO, out.data(), out.size());
+                out.clear();
+            }
+        }
+    }
+
+private:
+    const Stats &stats_;
+    std::mutex mutex_;
+    loggerlib::Merger merger_;
+    std::atomic<bool> stats_due_{false};
+};
+
+// Shared by the client threads
+struct Collector {
+    Stats &stats;
+    Output &output;
+    loggerlib::SegmentStore *store;  // nullptr if nothing is stored
+    size_t N;
+};
+
+// Count, store and print the messages of one read. Records hold the
+// messages, text lines outside the default layout are kept whole.
+void deliver(
+    Collector &collector,
+    std::size_t stream,
+    std::vector<loggerlib::wire::Record> &records,
+    std::vector<loggerlib::merge::Entry> &entries
+) {
+    if (records.empty()) {
+        return;
+    }
+
+    bool due = false;
     {
-        std::unique_lock lock(stats.length_mutex);
-        lens = stats.lengths;
-    }
-
-    // count min, max, avg
-    std::size_t min_len =
-        lens.empty() ? 0 : *std::min_element(lens.begin(), lens.end());
-    std::size_t max_len =
-        lens.empty() ? 0 : *std::max_element(lens.begin(), lens.end());
-    double avg_len =
-        lens.empty()
-            ? 0.0
-            : std::accumulate(lens.begin(), lens.end(), 0.0) / lens.size();
-
-    // count last hour msgs
-    auto now = std::chrono::system_clock::now();
-    size_t cnt_last_hr = 0;
-    {
-        std::unique_lock lock(stats.time_mutex);
-        for (auto &tp : stats.timestamps) {
-            if (std::chrono::duration_cast<std::chrono::hours>(now - tp).count(
-                ) < 1) {
-                ++cnt_last_hr;
+        std::lock_guard lock(collector.stats.mutex);
+        auto &summary = collector.stats.summary;
+        std::size_t before = summary.records;
+        for (const auto &record : records) {
+            summary.add(
+                record.level, record.timestamp_ms, record.message.size()
+            );
+        }
+        due = summary.records / collector.N != before / collector.N;
+    }
+    if (due) {
+        collector.output.requestStats();
+    }
+
+    if (collector.store) {
+        try {
+            collector.store->append(std::move(records));
+        } catch (const std::exception &e) {
+            std::cerr << "Cannot store messages: " << e.what() << "\n";
+        }
+    }
+    records.clear();
+    collector.output.push(stream, entries);
+}
+
+// same line layout as Logger::log(): "[YYYY-MM-DD HH:MM:SS] LEVEL: message"
+constexpr const char *TAGS[] = {"DEBUG: ", "INFO:  ", "ERROR: "};
+constexpr std::size_t TAG_POS = 22;
+constexpr std::size_t MESSAGE_POS = 29;
+
+std::string formatRecord(const loggerlib::wire::Record &record) {
+    std::time_t seconds = record.timestamp_ms / 1000;
+    std::tm buf;
+    localtime_r(&seconds, &buf);
+
+    std::ostringstream oss;
+    oss << "[" << std::put_time(&buf, "%Y-%m-%d %H:%M:%S") << "] "
+        << TAGS[static_cast<int>(record.level)] << record.message << "\n";
+    return oss.str();
+}
+
+loggerlib::wire::Record lineRecord(const loggerlib::merge::Entry &entry) {
+    loggerlib::wire::Record record;
+    record.level = loggerlib::LogLevel::INFO;
+    if (entry.text.find("DEBUG:") != std::string::npos) {
+        record.level = loggerlib::LogLevel::DEBUG;
+    } else if (entry.text.find("ERROR:") != std::string::npos) {
+        record.level = loggerlib::LogLevel::ERROR;
+    }
+
+    // lines without a timestamp count as received now
+    record.timestamp_ms = entry.timestamp_ms == loggerlib::merge::NO_TIMESTAMP
+                              ? nowMs()
+                              : entry.timestamp_ms;
+    record.message = entry.text;
+
+    // a line in the default layout counts and keeps only its message
+    std::string_view text = entry.text;
+    bool stamped = entry.timestamp_ms != loggerlib::merge::NO_TIMESTAMP &&
+                   text.size() >= MESSAGE_POS && text[0] == '[' &&
+                   text[TAG_POS - 2] == ']' && text[TAG_POS - 1] == ' ';
+    for (int i = 0; stamped && i < 3; ++i) {
+        if (text.substr(TAG_POS, MESSAGE_POS - TAG_POS) == TAGS[i]) {
+            record.level = static_cast<loggerlib::LogLevel>(i);
+            text.remove_prefix(MESSAGE_POS);
+            if (!text.empty() && text.back() == '\n') {
+                text.remove_suffix(1);
             }
+            record.message.assign(text);
+            break;
+        }
+    }
+    return record;
+}
+
+// Reassembles lines split between reads
+void handleTextClient(int client_fd, std::size_t stream, Collector &collector) {
+    loggerlib::merge::LineSplitter splitter;
+    loggerlib::merge::Entry entry;
+    std::vector<loggerlib::wire::Record> records;
+    std::vector<loggerlib::merge::Entry> entries;
+    char buffer[64 * 1024];
+    while (true) {
+        ssize_t len = recv(client_fd, buffer, sizeof(buffer), 0);
+        if (len <= 0) {
+            break;
+        }
+        splitter.feed(buffer, static_cast<std::size_t>(len));
+        while (splitter.next(entry)) {
+            records.push_back(lineRecord(entry));
+            entries.push_back(std::move(entry));
         }
+        deliver(collector, stream, records, entries);
     }
 
-    // print stats
-    std::cout << "\n============ Statistics ============\n"
-              << "Total messages: " << total << "\n"
-              << "DEBUG: " << cnt_debug << ", INFO: " << cnt_info
-              << ", ERROR: " << cnt_error << "\n"
-              << "Last hour: " << cnt_last_hr << "\n"
-              << "Length - min: " << min_len << ", max: " << max_len
-              << ", avg: " << avg_len << "\n"
-              << "====================================\n";
+    if (splitter.finish(entry)) {
+        records.push_back(lineRecord(entry));
+        entries.push_back(std::move(entry));
+        deliver(collector, stream, records, entries);
+    }
+}
+
+// Binary clients start with the handshake magic. A text client may send
+// fewer bytes and wait for nothing, so the peek doesn't wait for all of it.
+bool isBinaryClient(int client_fd) {
+    constexpr std::size_t size = sizeof(loggerlib::wire::MAGIC);
+    char magic[size];
+    auto deadline = std::chrono::steady_clock::now() + MAGIC_WAIT;
+    while (true) {
+        ssize_t len = recv(client_fd, magic, size, MSG_PEEK);
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (len <= 0 ||
+            std::memcmp(
+                magic, loggerlib::wire::MAGIC, static_cast<std::size_t>(len)
+            ) != 0) {
+            return false;
+        }
+        if (static_cast<std::size_t>(len) == size) {
+            return true;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// Answers the handshake and decodes framed records
+void handleBinaryClient(
+    int client_fd,
+    std::size_t stream,
+    Collector &collector
+) {
+    char hello[loggerlib::wire::HELLO_SIZE];
+    if (recv(client_fd, hello, sizeof(hello), MSG_WAITALL) !=
+        static_cast<ssize_t>(sizeof(hello))) {
+        return;
+    }
+
+    auto request =
+        loggerlib::wire::parse_hello(std::string_view(hello, sizeof(hello)));
+    if (!request) {
+        return;
+    }
+    loggerlib::wire::Hello answer{
+        std::min(request->version, loggerlib::wire::VERSION),
+        static_cast<std::uint8_t>(
+            request->flags & loggerlib::wire::FLAG_COMPRESSED
+        )
+    };
+    auto reply = loggerlib::wire::make_hello(answer);
+    if (send(client_fd, reply.data(), reply.size(), MSG_NOSIGNAL) < 0 ||
+        answer.version == 0) {
+        return;
+    }
+
+    loggerlib::wire::Decoder decoder;
+    loggerlib::wire::Record record;
+    std::vector<loggerlib::wire::Record> records;
+    std::vector<loggerlib::merge::Entry> entries;
+    std::vector<char> buffer(64 * 1024);
+    try {
+        while (true) {
+            ssize_t len = recv(client_fd, buffer.data(), buffer.size(), 0);
+            if (len <= 0) {
+                break;
+            }
+            decoder.feed(buffer.data(), static_cast<std::size_t>(len));
+
+            // stored as received, only the printed line is formatted
+            while (decoder.next(record)) {
+                entries.push_back(
+                    {record.timestamp_ms, record.seq, formatRecord(record)}
+                );
+                records.push_back(std::move(record));
+            }
+            deliver(collector, stream, records, entries);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Dropping client: " << e.what() << "\n";
+    }
 }
 
 int main(int argc, char *argv[]) {
+    const char *usage =
+        " <host> <port> <N> <T> [--window MS] [--store DIR]"
+        " [--fsync never|segment|commit]\n"
+        "Lines are printed in timestamp order, MS (1000 by default) after"
+        " they were logged. With --store messages are kept in DIR and the"
+        " statistics survive restarts.\n";
     if (argc < 5) {
-        std::cerr << "Usage: " << argv[0] << " <host> <port> <N> <T>\n";
+        std::cerr << "Usage: " << argv[0] << usage;
         return 1;
     }
 
@@ -91,8 +367,39 @@ int main(int argc, char *argv[]) {
     const char *port = argv[2];
     size_t N = std::stoul(argv[3]);
     int T = std::stoi(argv[4]);
+    loggerlib::MergeOptions options;
+    std::string store_dir;
+    loggerlib::SegmentStoreOptions store_options;
+    for (int i = 5; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string value = i + 1 < argc ? argv[i + 1] : "";
+        if (arg == "--window" && !value.empty()) {
+            options.window = std::chrono::milliseconds(std::stoi(value));
+        } else if (arg == "--store" && !value.empty()) {
+            store_dir = value;
+        } else if (arg == "--fsync" && value == "never") {
+            store_options.fsync = loggerlib::FsyncPolicy::NEVER;
+        } else if (arg == "--fsync" && value == "segment") {
+            store_options.fsync = loggerlib::FsyncPolicy::SEGMENT;
+        } else if (arg == "--fsync" && value == "commit") {
+            store_options.fsync = loggerlib::FsyncPolicy::COMMIT;
+        } else {
+            std::cerr << "Usage: " << argv[0] << usage;
+            return 1;
+        }
+        ++i;
+    }
 
     Stats stats{};
+    std::unique_ptr<loggerlib::SegmentStore> store;
+    if (!store_dir.empty()) {
+        store = std::make_unique<loggerlib::SegmentStore>(
+            store_dir, store_options
+        );
+        stats.summary = store->summary();
+    }
+    Output output(stats, options);
+    Collector collector{stats, output, store.get(), N};
     std::atomic<bool> running{true};
 
     // same as for socket in Logger::Logger(std::string, int, LogLevel)
@@ -161,14 +468,21 @@ int main(int argc, char *argv[]) {
         size_t last_total = 0;
         while (running.load()) {
             std::this_thread::sleep_for(std::chrono::seconds(T));
-            size_t curr = stats.total.load();
+            size_t curr;
+            {
+                std::lock_guard lock(stats.mutex);
+                curr = stats.summary.records;
+            }
             if (curr != last_total) {
-                printStats(stats);
+                output.requestStats();
                 last_total = curr;
             }
         }
     });
 
+    // thread for ordered output
+    std::thread writer_thread([&]() { output.run(running); });
+
     // cycle for clients to connect
     while (true) {
         int client_fd = accept(server_fd, nullptr, nullptr);
@@ -181,45 +495,20 @@ int main(int argc, char *argv[]) {
         }
 
         std::thread([&, client_fd]() {
-            char buffer[1024];
-            while (true) {
-                ssize_t len = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-                if (len <= 0) {
-                    break;
-                }
-                buffer[len] = '\0';
-                std::string line(buffer);
-
-                int lvl = 1;
-                if (line.find("DEBUG:") != std::string::npos) {
-                    lvl = 0;
-                } else if (line.find("ERROR:") != std::string::npos) {
-                    lvl = 2;
-                }
-
-                stats.total.fetch_add(1);
-                stats.messages_per_level[lvl].fetch_add(1);
-                {
-                    std::lock_guard lock(stats.length_mutex);
-                    stats.lengths.push_back(line.size());
-                }
-                {
-                    std::lock_guard lock(stats.time_mutex);
-                    stats.timestamps.push_back(std::chrono::system_clock::now()
-                    );
-                }
-
-                std::cout << line;
-                if (stats.total.load() % N == 0) {
-                    printStats(stats);
-                }
+            std::size_t stream = output.addStream();
+            if (isBinaryClient(client_fd)) {
+                handleBinaryClient(client_fd, stream, collector);
+            } else {
+                handleTextClient(client_fd, stream, collector);
             }
+            output.closeStream(stream);
             close(client_fd);
         }).detach();
     }
 
     running.store(false);
     timer_thread.join();
+    writer_thread.join();
     close(server_fd);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,160 @@
+#ifndef LOGGERLIB_ARCHIVE_HPP_
+#define LOGGERLIB_ARCHIVE_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <loggerlib/export.hpp>
+#include <loggerlib/merge.hpp>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Columnar archive of text logs in the default layout, see loggerlib-archive.
+//
+// File:
+//     "LGLA" | u8 version | 3 zero bytes
+// followed by blocks of up to block_records records. A record is a line
+// with its continuation lines. Block:
+//     u32 LE records | i64 LE min ts | i64 LE max ts | u8 level mask |
+//     u8 flags | 2 zero bytes | 4 x u32 LE count per level |
+//     4 x u32 LE column size | columns
+// Flags: NO_FINAL_NEWLINE - the last record of the block ends the input,
+// which had no '\n' after it.
+// Columns, in order:
+//     timestamps - varint zigzag(ts delta, ms), the first against 0
+//     levels     - 2 bits per record, 4 records per byte, low bits first
+//     templates  - varint dictionary size | dictionary x (varint length |
+//                  template) | varint template id per record
+//     arguments  - per record, the variable words its template leaves out:
+//                  varint length | bytes
+// Templates and arguments are compressed with wire::compress() when that
+// makes them smaller: u8 flag | [varint raw size] | data.
+//
+// A template is the message with every word holding a digit replaced by
+// TEMPLATE_ARG. Lines not in the default layout, or whose timestamp
+// doesn't format back to the same text, are kept whole as RAW records with
+// the timestamp of the record before them.
+
+namespace loggerlib {
+
+struct LOGGERLIB_EXPORT ArchiveOptions {
+    std::size_t block_records = 1 << 16;
+};
+
+namespace archive {
+
+constexpr char MAGIC[4] = {'L', 'G', 'L', 'A'};
+constexpr std::uint8_t VERSION = 1;
+constexpr std::size_t HEADER_SIZE = 8;
+constexpr std::size_t BLOCK_HEADER_SIZE = 56;
+constexpr std::uint8_t RAW = 3;  // level code after DEBUG, INFO, ERROR
+constexpr char TEMPLATE_ARG = '\0';
+constexpr std::uint8_t NO_FINAL_NEWLINE = 1;  // block flag
+
+enum Column { TIMESTAMPS = 0, LEVELS, TEMPLATES, ARGUMENTS };
+
+struct LOGGERLIB_EXPORT BlockInfo {
+    std::uint64_t offset = 0;  // of the first column
+    std::uint32_t records = 0;
+    std::int64_t min_ms = 0;
+    std::int64_t max_ms = 0;
+    std::uint8_t levels = 0;  // 1 << level code
+    std::uint8_t flags = 0;
+    std::array<std::uint32_t, 4> counts{};
+    std::array<std::uint32_t, 4> column_sizes{};
+};
+
+// Converts lines of text logs. Throws std::runtime_error on file errors.
+class LOGGERLIB_EXPORT Writer {
+public:
+    explicit Writer(
+        const std::string &path,
+        ArchiveOptions options = ArchiveOptions()
+    );
+    // Calls finish() if it wasn't, errors are lost
+    ~Writer();
+
+    Writer(const Writer &) = delete;
+    Writer &operator=(const Writer &) = delete;
+
+    // Add one line, '\n' included. Only the last line may lack it, it is
+    // then given back without one.
+    void add_line(std::string_view line);
+    // Write the last block and close the file
+    void finish();
+
+    std::uint64_t records() const {
+        return records_;
+    }
+
+private:
+    void end_record();
+    void flush_block();
+
+    ArchiveOptions options_;
+    int fd_ = -1;
+    merge::LineClock clock_;
+    std::string checked_hour_;  // formats back to the same text
+    std::uint64_t records_ = 0;
+    bool newline_ = true;  // the last line added had its '\n'
+
+    // Record being assembled
+    bool has_record_ = false;
+    std::uint8_t level_ = RAW;
+    std::int64_t timestamp_ms_ = 0;
+    std::string message_;
+
+    // Columns of the open block
+    BlockInfo block_;
+    std::int64_t last_ts_ = 0;  // of the previous record in the block
+    std::string timestamps_;
+    std::string levels_;
+    std::unordered_map<std::string, std::uint32_t> dictionary_;
+    std::vector<const std::string *> templates_;
+    std::string template_ids_;
+    std::string arguments_;
+};
+
+// Reads an archive through a read-only mapping, so a scan only touches the
+// pages of the blocks and columns it decodes. Throws std::runtime_error if
+// the file can't be mapped or is malformed.
+class LOGGERLIB_EXPORT Reader {
+public:
+    explicit Reader(const std::string &path);
+    ~Reader();
+
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+
+    const std::vector<BlockInfo> &blocks() const {
+        return blocks_;
+    }
+
+    std::vector<std::int64_t> timestamps(const BlockInfo &block) const;
+    // Level codes, RAW for raw records
+    std::vector<std::uint8_t> levels(const BlockInfo &block) const;
+    // Append the lines of the records of block, only of those set in keep
+    // if it is given
+    void text(
+        const BlockInfo &block,
+        std::string &out,
+        const std::vector<bool> *keep = nullptr
+    ) const;
+
+private:
+    void unmap();
+    std::string_view column(const BlockInfo &block, Column column) const;
+    // Column bytes, decompressed if they were compressed
+    std::string message_column(const BlockInfo &block, Column column) const;
+
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+    std::vector<BlockInfo> blocks_;
+};
+
+}  // namespace archive
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_ARCHIVE_HPP_
@@ -0,0 +1,107 @@
+#ifndef LOGGERLIB_BACKEND_HPP_
+#define LOGGERLIB_BACKEND_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <loggerlib/export.hpp>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace loggerlib {
+
+namespace detail {
+class Source;
+}  // namespace detail
+
+// Scheduling policy of the I/O threads, applied best-effort
+enum class LOGGERLIB_EXPORT SchedulingPolicy {
+    DEFAULT = 0,  // SCHED_OTHER
+    FIFO,         // SCHED_FIFO, needs privileges
+    ROUND_ROBIN,  // SCHED_RR, needs privileges
+    BATCH,        // SCHED_BATCH
+    IDLE          // SCHED_IDLE
+};
+
+struct LOGGERLIB_EXPORT BackendOptions {
+    // 0 - no threads: the loggers' queues are written only by flush(),
+    // disable_async() and their destruction, full BLOCK lanes wait for them
+    std::size_t threads = 1;
+    // Thread i is pinned to cpu_affinity[i % size], empty - no pinning
+    std::vector<int> cpu_affinity;
+    SchedulingPolicy policy = SchedulingPolicy::DEFAULT;
+    int priority = 0;  // for FIFO and ROUND_ROBIN
+    // How often idle threads look for loggers with aged messages
+    std::chrono::milliseconds tick{10};
+};
+
+// Pool of I/O threads writing the queued messages of many asynchronous
+// loggers. Every thread has its own task queue, idle threads steal tasks
+// from busy ones. Must outlive the loggers attached to it.
+class LOGGERLIB_EXPORT Backend {
+public:
+    LOGGERLIB_EXPORT explicit Backend(
+        const BackendOptions &options = BackendOptions()
+    );
+    LOGGERLIB_EXPORT ~Backend();
+
+    Backend(const Backend &) = delete;
+    Backend &operator=(const Backend &) = delete;
+
+    // Process-wide backend used by loggers without an explicit one
+    LOGGERLIB_EXPORT static Backend &instance();
+
+    // Write everything queued by the attached loggers and stop the threads,
+    // milliseconds::max() waits without a deadline. Returns false if
+    // messages were still queued when the deadline passed.
+    // Loggers stay attached and asynchronous: afterwards a full batch, a
+    // write-through message or a parked coroutine is written by the
+    // thread logging it, and what is below a batch waits for flush() or
+    // the logger's destruction.
+    LOGGERLIB_EXPORT bool shutdown(std::chrono::milliseconds deadline);
+
+    LOGGERLIB_EXPORT std::size_t threads() const;
+
+    // Used by Logger
+    void attach(const std::shared_ptr<detail::Source> &source);
+    void detach(const std::shared_ptr<detail::Source> &source);
+    void schedule(const std::shared_ptr<detail::Source> &source);
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<detail::Source>> tasks;
+        std::thread thread;
+    };
+
+    void run_worker(std::size_t index);
+    void setup_thread(std::size_t index);
+    std::shared_ptr<detail::Source> pop_task(std::size_t index);
+    void push_task(std::size_t index, std::shared_ptr<detail::Source> source);
+    void run_task(std::size_t index, const std::shared_ptr<detail::Source> &task);
+    void schedule_due();
+    // Drain on the calling thread, once there are no threads to do it
+    void drain_inline(const std::shared_ptr<detail::Source> &source);
+    bool has_backlog();
+
+    BackendOptions options_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<std::size_t> next_worker_{0};
+
+    std::mutex idle_mutex_;
+    std::condition_variable idle_;
+    std::atomic<std::size_t> queued_{0};
+    std::atomic<bool> stopped_{false};
+
+    std::mutex sources_mutex_;
+    std::vector<std::shared_ptr<detail::Source>> sources_;
+    std::chrono::steady_clock::time_point last_tick_;
+};
+
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_BACKEND_HPP_
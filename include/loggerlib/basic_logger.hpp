@@ -0,0 +1,260 @@
+#ifndef LOGGERLIB_BASIC_LOGGER_HPP_
+#define LOGGERLIB_BASIC_LOGGER_HPP_
+
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <loggerlib/level.hpp>
+#include <loggerlib/net.hpp>
+#include <loggerlib/pattern.hpp>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace loggerlib {
+
+/////////////////
+// sink policy //
+/////////////////
+
+// Appends to a file, flushed after every write
+class FileSink {
+public:
+    explicit FileSink(const std::string &filename)
+        : file_(filename, std::ios::app) {
+        if (!file_.is_open()) {
+            throw std::runtime_error("Cannot open log file: " + filename);
+        }
+    }
+
+    void write(const std::string &out) {
+        file_.write(out.data(), static_cast<std::streamsize>(out.size()));
+        file_.flush();
+    }
+
+private:
+    std::ofstream file_;
+};
+
+// Sends text lines to a TCP socket
+class SocketSink {
+public:
+    SocketSink(const std::string &host, int port)
+        : sockfd_(connect_tcp(host, port)) {}
+    SocketSink(SocketSink &&other) noexcept
+        : sockfd_(std::exchange(other.sockfd_, -1)) {}
+    ~SocketSink() {
+        if (sockfd_ != -1) {
+            close(sockfd_);
+        }
+    }
+
+    SocketSink(const SocketSink &) = delete;
+    SocketSink &operator=(const SocketSink &) = delete;
+    SocketSink &operator=(SocketSink &&) = delete;
+
+    void write(const std::string &out) {
+        send_all(sockfd_, out.data(), out.size());
+    }
+
+private:
+    int sockfd_;
+};
+
+// File or socket chosen at runtime, as in Logger
+class DynamicSink {
+public:
+    DynamicSink(FileSink sink) : sink_(std::move(sink)) {}
+    DynamicSink(SocketSink sink) : sink_(std::move(sink)) {}
+
+    void write(const std::string &out) {
+        std::visit([&](auto &sink) { sink.write(out); }, sink_);
+    }
+
+private:
+    std::variant<FileSink, SocketSink> sink_;
+};
+
+//////////////////////
+// threading policy //
+//////////////////////
+
+// No locking, the logger is used by one thread at a time
+struct SingleThreaded {
+    struct Mutex {
+        void lock() {}
+        void unlock() {}
+    };
+
+    // std::atomic look-alike without the atomicity
+    template <typename T>
+    class Value {
+    public:
+        explicit Value(T value) : value_(value) {}
+        T load(std::memory_order = std::memory_order_seq_cst) const {
+            return value_;
+        }
+        void store(T value, std::memory_order = std::memory_order_seq_cst) {
+            value_ = value;
+        }
+
+    private:
+        T value_;
+    };
+};
+
+// Writes are serialized by a mutex
+struct MultiThreaded {
+    using Mutex = std::mutex;
+
+    template <typename T>
+    using Value = std::atomic<T>;
+};
+
+///////////////////
+// format policy //
+///////////////////
+
+// Lines laid out by a pattern compiled at compile time:
+//   static constexpr auto LAYOUT = compile_pattern("%H:%M:%S %l %v");
+//   BasicLogger<FileSink, SingleThreaded, StaticPatternFormat<LAYOUT>>
+template <const auto &Layout>
+struct StaticPatternFormat {
+    void format(
+        std::string &out,
+        std::string_view message,
+        LogLevel level,
+        std::int64_t timestamp_ms
+    ) {
+        Layout.format(out, {message, level, timestamp_ms});
+    }
+};
+
+// "[YYYY-MM-DD HH:MM:SS] LEVEL: message\n", the same lines as Logger
+using DefaultFormat = StaticPatternFormat<DEFAULT_LAYOUT>;
+
+// Lines laid out by a pattern given at runtime
+class PatternFormat {
+public:
+    explicit PatternFormat(std::string_view pattern = DEFAULT_PATTERN)
+        : pattern_(pattern) {}
+
+    void format(
+        std::string &out,
+        std::string_view message,
+        LogLevel level,
+        std::int64_t timestamp_ms
+    ) {
+        pattern_.format(out, {message, level, timestamp_ms});
+    }
+
+private:
+    Pattern pattern_;
+};
+
+// The message alone, one per line
+struct MessageOnlyFormat {
+    void format(
+        std::string &out,
+        std::string_view message,
+        LogLevel /*level*/,
+        std::int64_t /*timestamp_ms*/
+    ) {
+        out += message;
+        out += '\n';
+    }
+};
+
+/////////////////
+// BasicLogger //
+/////////////////
+
+// Logger assembled from policies at compile time:
+//  - SinkPolicy: void write(const std::string &out)
+//  - ThreadingPolicy: Mutex and Value<T> types, see SingleThreaded
+//  - FormatPolicy: void format(out, message, level, timestamp_ms)
+//  - MinLevel: messages below it compile to nothing
+// A fixed sink with SingleThreaded has no locks and no dispatch.
+template <
+    typename SinkPolicy,
+    typename ThreadingPolicy = MultiThreaded,
+    typename FormatPolicy = DefaultFormat,
+    LogLevel MinLevel = LogLevel::DEBUG>
+class BasicLogger {
+public:
+    explicit BasicLogger(SinkPolicy sink, LogLevel level = LogLevel::INFO)
+        : sink_(std::move(sink)), level_(level) {}
+    BasicLogger(SinkPolicy sink, LogLevel level, FormatPolicy format)
+        : sink_(std::move(sink)), format_(std::move(format)), level_(level) {}
+
+    // Log message
+    void log(std::string_view message, LogLevel level) {
+        if (!is_enabled(level)) {
+            return;
+        }
+
+        std::lock_guard lock(mutex_);
+        line_.clear();
+        format_.format(line_, message, level, current_time_ms());
+        sink_.write(line_);
+    }
+
+    // Level fixed at compile time, dropped entirely below MinLevel
+    template <LogLevel Level>
+    void log(std::string_view message) {
+        if constexpr (Level >= MinLevel) {
+            log(message, Level);
+        }
+    }
+
+    // Log message built by make_message() only if the level passes
+    template <
+        typename F,
+        typename = std::enable_if_t<std::is_invocable_v<F &>>>
+    void log(F &&make_message, LogLevel level) {
+        if (is_enabled(level)) {
+            log(std::string_view(make_message()), level);
+        }
+    }
+
+    bool is_enabled(LogLevel level) const {
+        return level >= MinLevel &&
+               level >= level_.load(std::memory_order_relaxed);
+    }
+
+    // Set/get default message level, MinLevel still applies
+    void set_level(LogLevel level) {
+        level_.store(level, std::memory_order_relaxed);
+    }
+    LogLevel get_level() const {
+        return level_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static std::int64_t current_time_ms() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch()
+        )
+            .count();
+    }
+
+    SinkPolicy sink_;
+    FormatPolicy format_;
+    typename ThreadingPolicy::template Value<LogLevel> level_;
+    typename ThreadingPolicy::Mutex mutex_;
+    std::string line_;  // reused, guarded by mutex_
+};
+
+// Destination chosen at runtime, safe to share between threads
+using GenericLogger =
+    BasicLogger<DynamicSink, MultiThreaded, DefaultFormat, LogLevel::DEBUG>;
+
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_BASIC_LOGGER_HPP_
@@ -0,0 +1,52 @@
+#ifndef LOGGERLIB_EXECUTOR_HPP_
+#define LOGGERLIB_EXECUTOR_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <loggerlib/export.hpp>
+#include <mutex>
+
+namespace loggerlib {
+
+// Runs posted callbacks, e.g. resumptions of coroutines waiting in
+// Logger::log_async()
+class LOGGERLIB_EXPORT Executor {
+public:
+    virtual ~Executor() = default;
+
+    virtual void post(std::function<void()> task) = 0;
+
+    // Executor whose task the calling thread is running, null if none
+    LOGGERLIB_EXPORT static Executor *current();
+
+protected:
+    // Implementations call it around running their tasks
+    LOGGERLIB_EXPORT static void set_current(Executor *executor);
+};
+
+// Minimal run loop, enough for tests and benchmarks
+class LOGGERLIB_EXPORT EventLoop : public Executor {
+public:
+    LOGGERLIB_EXPORT void post(std::function<void()> task) override;
+
+    // Run tasks on the calling thread until stop()
+    LOGGERLIB_EXPORT void run();
+    // Run the tasks ready now, returns how many ran
+    LOGGERLIB_EXPORT std::size_t poll();
+    // Make run() return once the current task is done, pending tasks stay
+    LOGGERLIB_EXPORT void stop();
+
+private:
+    std::function<void()> pop(bool wait);
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopped_ = false;
+};
+
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_EXECUTOR_HPP_
@@ -0,0 +1,115 @@
+#ifndef LOGGERLIB_FORWARDER_HPP_
+#define LOGGERLIB_FORWARDER_HPP_
+
+#include <sys/types.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <loggerlib/export.hpp>
+#include <string>
+
+namespace loggerlib {
+
+struct LOGGERLIB_EXPORT ForwarderOptions {
+    // Resume offset file, empty - "<file>.fwd"
+    std::string state_path;
+    // Longest wait for file events, also the reconnect delay
+    std::chrono::milliseconds poll_interval{1000};
+    // How long the destructor waits for the collector to take queued bytes
+    std::chrono::milliseconds linger{1000};
+    // Largest sendfile() call
+    std::size_t chunk_size = 1 << 20;
+};
+
+// Follows a growing log file and streams its new bytes to a TCP collector,
+// the same one the Logger(host, port) clients use. Bytes go from the page
+// cache to the socket with sendfile(), never through userspace.
+//
+// The file is watched with inotify. Rotation is detected by the path
+// naming another inode: the old file is drained, including what writers
+// still holding it append, and acknowledged, then the new one is followed
+// from its start. A file truncated in place is followed from its start as
+// well.
+//
+// The resume offset counts bytes the collector host acknowledged (sent
+// minus the socket's unacknowledged queue) and is saved after every
+// pump() and at destruction, when queued bytes are waited for up to
+// linger. So a restart never loses bytes; after a crash it may resend
+// the bytes since the last save.
+class LOGGERLIB_EXPORT Forwarder {
+public:
+    // Throws std::runtime_error if inotify can't be set up. The collector
+    // is connected on the first pump().
+    LOGGERLIB_EXPORT Forwarder(
+        std::string path,
+        std::string host,
+        int port,
+        ForwarderOptions options = ForwarderOptions()
+    );
+    LOGGERLIB_EXPORT ~Forwarder();
+
+    Forwarder(const Forwarder &) = delete;
+    Forwarder &operator=(const Forwarder &) = delete;
+
+    // Ship everything written so far, returns the number of bytes sent.
+    // Throws std::runtime_error if the collector can't be connected; a
+    // broken connection is dropped and the bytes it didn't acknowledge are
+    // sent again by the next pump().
+    LOGGERLIB_EXPORT std::uint64_t pump();
+
+    // pump() whenever the file changes until stop(). Connection errors are
+    // retried every poll_interval.
+    LOGGERLIB_EXPORT void run();
+    // Make run() return, async-signal-safe
+    LOGGERLIB_EXPORT void stop() noexcept;
+
+    // Position in the file followed now
+    std::uint64_t offset() const {
+        return offset_;
+    }
+    bool connected() const {
+        return sockfd_ != -1;
+    }
+
+private:
+    void connect();
+    void disconnect();
+    // Bytes sent but not acknowledged by the collector host
+    std::uint64_t unacknowledged() const;
+    // Open the file at path, resuming at the saved offset if it is the same
+    // file. Returns false if there is no file.
+    bool open_file();
+    void save_state();
+    // Wait until the socket takes more bytes, false if stopped
+    bool wait_writable();
+    // Wait up to linger for the collector to acknowledge everything sent,
+    // false if it didn't
+    bool wait_acknowledged();
+    // Wait for file events, stop() or the poll interval
+    void wait_for_change();
+
+    std::string path_;
+    std::string host_;
+    int port_;
+    ForwarderOptions options_;
+
+    int inotify_fd_ = -1;
+    int wake_fd_ = -1;  // eventfd, signaled by stop()
+    int sockfd_ = -1;
+    int file_fd_ = -1;
+    dev_t device_ = 0;
+    ino_t inode_ = 0;
+    std::uint64_t offset_ = 0;
+
+    // Loaded state, used when the file is first opened
+    dev_t saved_device_ = 0;
+    ino_t saved_inode_ = 0;
+    std::uint64_t saved_offset_ = 0;
+
+    std::atomic<bool> stopped_{false};
+};
+
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_FORWARDER_HPP_
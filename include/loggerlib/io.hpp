@@ -0,0 +1,14 @@
+#ifndef LOGGERLIB_IO_HPP_
+#define LOGGERLIB_IO_HPP_
+
+#include <cstddef>
+#include <loggerlib/export.hpp>
+
+namespace loggerlib {
+
+// write() until the whole buffer is written, false on error
+LOGGERLIB_EXPORT bool write_all(int fd, const char *data, std::size_t size);
+
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_IO_HPP_
@@ -0,0 +1,43 @@
+#ifndef LOGGERLIB_LANES_HPP_
+#define LOGGERLIB_LANES_HPP_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <loggerlib/export.hpp>
+
+namespace loggerlib {
+
+class Backend;
+
+// What a full lane does with a new message
+enum class LOGGERLIB_EXPORT OverflowPolicy {
+    BLOCK = 0,    // wait until the writer frees space
+    DROP_NEWEST,  // discard the new message
+    DROP_OLDEST   // discard the oldest queued message
+};
+
+struct LOGGERLIB_EXPORT LaneOptions {
+    std::size_t capacity = 16384;  // queued messages
+    OverflowPolicy overflow = OverflowPolicy::BLOCK;
+    bool write_through = false;  // written and flushed by the caller at once
+};
+
+// Asynchronous mode: one lane per level, indexed by LogLevel
+struct LOGGERLIB_EXPORT AsyncOptions {
+    std::array<LaneOptions, 3> lanes = {{
+        {16384, OverflowPolicy::DROP_OLDEST, false},  // DEBUG
+        {16384, OverflowPolicy::BLOCK, false},        // INFO
+        {16384, OverflowPolicy::BLOCK, true},         // ERROR
+    }};
+    // Lower lanes are written in batches of up to batch_size per lane
+    std::size_t batch_size = 4096;
+    // Queued messages wait no longer than this
+    std::chrono::milliseconds flush_interval{50};
+    // I/O threads writing the lanes, null - the process-wide Backend
+    Backend *backend = nullptr;
+};
+
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_LANES_HPP_
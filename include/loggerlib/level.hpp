@@ -0,0 +1,12 @@
+#ifndef LOGGERLIB_LEVEL_HPP_
+#define LOGGERLIB_LEVEL_HPP_
+
+#include <loggerlib/export.hpp>
+
+namespace loggerlib {
+
+enum class LOGGERLIB_EXPORT LogLevel { DEBUG = 0, INFO, ERROR };
+
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_LEVEL_HPP_
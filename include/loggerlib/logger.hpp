@@ -5,33 +5,305 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstddef>
 #include <ctime>
 #include <fstream>
+#include <functional>
+#include <loggerlib/backend.hpp>
+#include <loggerlib/executor.hpp>
 #include <loggerlib/export.hpp>
+#include <loggerlib/lanes.hpp>
+#include <loggerlib/level.hpp>
+#include <loggerlib/pattern.hpp>
+#include <loggerlib/profiler.hpp>
+#include <loggerlib/shedding.hpp>
+#include <loggerlib/time_index.hpp>
+#include <loggerlib/wire.hpp>
+#include <memory>
 #include <mutex>
+#include <ostream>
+#include <shared_mutex>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <variant>
+#include <vector>
+
+// Lazy logging: the message expression is evaluated only if the level passes
+// NOLINTBEGIN(cppcoreguidelines-macro-usage)
+#define LOGGERLIB_LOG(logger, level, message)                     \
+    do {                                                          \
+        (logger).log([&]() { return (message); }, level);         \
+    } while (false)
+#define LOGGERLIB_DEBUG(logger, message) \
+    LOGGERLIB_LOG(logger, ::loggerlib::LogLevel::DEBUG, message)
+#define LOGGERLIB_INFO(logger, message) \
+    LOGGERLIB_LOG(logger, ::loggerlib::LogLevel::INFO, message)
+#define LOGGERLIB_ERROR(logger, message) \
+    LOGGERLIB_LOG(logger, ::loggerlib::LogLevel::ERROR, message)
+// NOLINTEND(cppcoreguidelines-macro-usage)
 
 namespace loggerlib {
 
-enum class LOGGERLIB_EXPORT LogLevel { DEBUG = 0, INFO, ERROR };
+namespace detail {
+class Backtrace;
+struct Extent;
+class Indexer;
+class Lanes;
+struct Message;
+struct Parked;
+class Shedder;
+class Source;
+struct StreamBuffer;
+}  // namespace detail
+
+class Logger;
+
+// Streaming message builder returned by Logger::debug()/info()/error().
+// Writes into a reusable thread-local buffer and logs on destruction,
+// does nothing when the level is filtered.
+class LOGGERLIB_EXPORT LogStream {
+public:
+    LogStream(Logger *logger, LogLevel level, SourceLocation location);
+    LogStream(LogStream &&other) noexcept
+        : logger_(other.logger_),
+          level_(other.level_),
+          location_(other.location_),
+          buffer_(other.buffer_) {
+        other.buffer_ = nullptr;
+    }
+    ~LogStream() {
+        if (buffer_) {
+            release();
+        }
+    }
+
+    LogStream(const LogStream &) = delete;
+    LogStream &operator=(const LogStream &) = delete;
+    LogStream &operator=(LogStream &&) = delete;
+
+    template <typename T>
+    LogStream &operator<<(const T &value) {
+        if (buffer_) {
+            stream() << value;
+        }
+        return *this;
+    }
+
+private:
+    LOGGERLIB_EXPORT void acquire();
+    LOGGERLIB_EXPORT void release();
+    LOGGERLIB_EXPORT std::ostream &stream();
+
+    Logger *logger_;
+    LogLevel level_;
+    SourceLocation location_;                 // for Profiler
+    detail::StreamBuffer *buffer_ = nullptr;  // null when filtered
+};
+
+// Awaitable returned by Logger::log_async(). Completes without suspending
+// when the lane has room, otherwise parks the message and suspends the
+// coroutine until the writer frees space. Works with any coroutine type.
+class LOGGERLIB_EXPORT LogAwaitable {
+public:
+    bool await_ready() const noexcept {
+        return false;
+    }
+    template <typename Handle>
+    bool await_suspend(Handle handle) {
+        return suspend([handle]() mutable { handle.resume(); });
+    }
+    void await_resume() const noexcept {}
+
+private:
+    friend class Logger;
+    LogAwaitable(
+        Logger *logger,
+        std::string message,
+        LogLevel level,
+        Executor *executor,
+        SourceLocation location
+    )
+        : logger_(logger),
+          message_(std::move(message)),
+          level_(level),
+          executor_(executor),
+          location_(location) {}
+
+    // Returns true if the coroutine has to wait
+    LOGGERLIB_EXPORT bool suspend(std::function<void()> &&resume);
+
+    Logger *logger_;
+    std::string message_;
+    LogLevel level_;
+    Executor *executor_;
+    SourceLocation location_;  // for log() when it falls back to it
+};
+
+// How a log file is written
+enum class LOGGERLIB_EXPORT FileMode {
+    PRIVATE = 0,  // buffered stream, one process per file
+    SHARED        // O_APPEND, one write(2) per record, any number of processes
+};
+
+// Longest write(2) in FileMode::SHARED. Longer records are split into
+// lines of at most this size: all but the last end with
+// CONTINUATION_SUFFIX, all but the first start with "+<pid> ".
+inline constexpr std::size_t SHARED_WRITE_SIZE = 4096;
+inline constexpr std::string_view CONTINUATION_SUFFIX = " \\";
 
 class LOGGERLIB_EXPORT Logger {
 public:
     // File writing ctor
     LOGGERLIB_EXPORT explicit Logger(
         const std::string &filename,
-        LogLevel level = LogLevel::INFO
+        LogLevel level = LogLevel::INFO,
+        FileMode mode = FileMode::PRIVATE
+    );
+    // TCP-socket writing ctor, BINARY format negotiates the wire protocol.
+    // Synchronous log() sends a frame per record, so compression works on
+    // asynchronous batches and on records of 256 bytes and longer.
+    LOGGERLIB_EXPORT Logger(
+        const std::string &host,
+        int port,
+        LogLevel level = LogLevel::INFO,
+        WireFormat format = WireFormat::TEXT
     );
-    // TCP-socket writing ctor
-    LOGGERLIB_EXPORT
-    Logger(const std::string &host, int port, LogLevel level = LogLevel::INFO);
     LOGGERLIB_EXPORT ~Logger();
 
-    // Log message
-    LOGGERLIB_EXPORT void log(const std::string &message, LogLevel level);
+    // Log message. The location identifies the call site for Profiler.
+    LOGGERLIB_EXPORT void log(
+        const std::string &message,
+        LogLevel level,
+        SourceLocation location = SourceLocation::current()
+    );
+
+    // Coroutine form: co_await logger.log_async(message, level).
+    // In asynchronous mode it never does I/O on the calling thread: a full
+    // BLOCK lane suspends the coroutine instead of the thread, and it is
+    // resumed on the executor that was current at the call (see
+    // Executor::current()). If there was none, the thread that made room
+    // (a Backend thread or one in flush()) resumes it after releasing the
+    // logger's locks.
+    // ERROR messages flushing a backtrace and the synchronous mode fall back
+    // to log() with the location of the call.
+    LogAwaitable log_async(
+        std::string message,
+        LogLevel level,
+        SourceLocation location = SourceLocation::current()
+    ) {
+        return LogAwaitable(
+            this, std::move(message), level, Executor::current(), location
+        );
+    }
+    LogAwaitable log_async(
+        std::string message,
+        LogLevel level,
+        Executor &executor,
+        SourceLocation location = SourceLocation::current()
+    ) {
+        return LogAwaitable(
+            this, std::move(message), level, &executor, location
+        );
+    }
+
+    // Log message built by make_message() only if the level passes
+    template <
+        typename F,
+        typename = std::enable_if_t<std::is_invocable_v<F &>>>
+    void log(
+        F &&make_message,
+        LogLevel level,
+        SourceLocation location = SourceLocation::current()
+    ) {
+        if (should_log(level)) {
+            log(std::string(make_message()), level, location);
+        } else if (Profiler::enabled()) {
+            Profiler::record_filtered(location);
+        }
+    }
+
+    // Stream form: logger.debug() << "state=" << value;
+    LogStream debug(SourceLocation location = SourceLocation::current()) {
+        return LogStream(this, LogLevel::DEBUG, location);
+    }
+    LogStream info(SourceLocation location = SourceLocation::current()) {
+        return LogStream(this, LogLevel::INFO, location);
+    }
+    LogStream error(SourceLocation location = SourceLocation::current()) {
+        return LogStream(this, LogLevel::ERROR, location);
+    }
+
+    // Whether a message of the level would be written or kept for backtrace
+    bool is_enabled(LogLevel level) const {
+        if (backtrace_enabled_.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        return level >= level_.load(std::memory_order_relaxed) &&
+               static_cast<int>(level) >=
+                   shed_floor_.load(std::memory_order_relaxed);
+    }
+
+    // Backtrace mode: messages below the level are kept in a per-thread ring
+    // of `size` entries without any I/O. The last `size` of them are written
+    // ahead of every ERROR message.
+    LOGGERLIB_EXPORT void enable_backtrace(std::size_t size);
+    LOGGERLIB_EXPORT void disable_backtrace();
+    // Write the buffered messages now
+    LOGGERLIB_EXPORT void dump_backtrace();
+    // Same, into fd and async-signal-safe, for crash handlers
+    LOGGERLIB_EXPORT void dump_backtrace_signal_safe(int fd) noexcept;
+
+    // Asynchronous mode: messages are queued in per-level lanes and written
+    // in batches by Backend threads, write-through lanes are written by the
+    // caller at once. Other threads may keep logging while the mode is
+    // switched, but enable_async() and disable_async() must not race with
+    // each other.
+    LOGGERLIB_EXPORT void enable_async(
+        const AsyncOptions &options = AsyncOptions()
+    );
+    // Write everything queued and return to synchronous mode
+    LOGGERLIB_EXPORT void disable_async();
+    // Write everything queued now
+    LOGGERLIB_EXPORT void flush();
+    // Messages dropped by the lane's overflow policy
+    LOGGERLIB_EXPORT std::uint64_t dropped(LogLevel level) const;
+
+    // Text line layout, DEFAULT_PATTERN by default (see Pattern).
+    // Throws std::runtime_error if the pattern is invalid. Lines already
+    // queued in async mode may come out in either layout.
+    LOGGERLIB_EXPORT void set_pattern(const std::string &pattern);
+    // Name shown by %n
+    LOGGERLIB_EXPORT void set_name(const std::string &name);
+
+    // Load shedding: under I/O pressure (slow writes, deep async backlog)
+    // messages are dropped above set_level(), DEBUG first, then INFO, and
+    // the level is restored with hysteresis once the pressure clears. The
+    // shed counts are logged at INFO on recovery. Must not race with log()
+    // calls.
+    LOGGERLIB_EXPORT void enable_shedding(
+        const SheddingOptions &options = SheddingOptions()
+    );
+    LOGGERLIB_EXPORT void disable_shedding();
+    // Messages dropped by load shedding
+    LOGGERLIB_EXPORT std::uint64_t shed(LogLevel level) const;
+    // Lowest level written now: set_level() raised by load shedding
+    LOGGERLIB_EXPORT LogLevel effective_level() const;
+
+    // Time index: keep a sparse sidecar "<file>.idx" mapping time buckets
+    // to file offsets (see time_index.hpp), for loggerlib-query. Costs one
+    // small write per closed region. File logger in FileMode::PRIVATE only,
+    // throws std::runtime_error otherwise or if the sidecar can't be opened.
+    LOGGERLIB_EXPORT void enable_time_index(
+        const TimeIndexOptions &options = TimeIndexOptions()
+    );
+    // Index what was written so far and stop
+    LOGGERLIB_EXPORT void disable_time_index();
 
     // Set/get default message level
     LOGGERLIB_EXPORT void set_level(LogLevel level);
@@ -41,14 +313,133 @@ public:
     std::string get_current_timestamp();
 
 private:
+    // log() without profiling, returns false if the message was dropped
+    bool dispatch(const std::string &message, LogLevel level);
+
+    // Format and write one message, mutex_ must be held
+    void write_locked(
+        std::string_view message,
+        LogLevel level,
+        std::int64_t timestamp_ms,
+        std::uint32_t thread_id
+    );
+    static std::string format_batch(
+        const std::vector<detail::Message> &batch,
+        const Pattern &pattern,
+        std::string_view name
+    );
+    void write_batch_locked(std::vector<detail::Message> &batch);
+    // extent describes text records for the time index, null for others
+    void write_out_locked(
+        const std::string &out,
+        const detail::Extent *extent = nullptr
+    );
+    void write_backtrace_locked();
+
+    // Write queued messages, returns false if there were none. Parked
+    // coroutines given room are added to resumed, see Lanes::resume().
+    bool drain_once(
+        std::vector<detail::Message> &batch,
+        std::vector<detail::Parked> &resumed
+    );
+    // Wait until the batches with tickets below tickets are written
+    void wait_drains(std::uint64_t tickets);
+    friend class AsyncSource;
+
+    // log_async() body, returns true if the message was parked
+    bool log_or_park(
+        std::string &&message,
+        LogLevel level,
+        Executor *executor,
+        SourceLocation location,
+        std::function<void()> &&resume
+    );
+    friend class LogAwaitable;
+
+    // is_enabled() for the lazy forms, which drop the message if it
+    // returns false: a shed one is counted here
+    bool should_log(LogLevel level) {
+        if (is_enabled(level)) {
+            return true;
+        }
+        if (level >= level_.load(std::memory_order_relaxed)) {
+            note_shed(level);
+        }
+        return false;
+    }
+    friend class LogStream;
+
+    // Count a shed message and check the pressure
+    LOGGERLIB_EXPORT void note_shed(LogLevel level);
+    // Check the pressure if an interval passed
+    void refresh_shedding();
+    // Same, then log the report of a finished shedding episode
+    void update_shedding();
+
     // Common fields
-    LogLevel level_;
+    std::atomic<LogLevel> level_;
     std::mutex mutex_;
 
+    // File opened with FileMode::SHARED
+    struct SharedFile {
+        int fd;
+    };
+
     // Destination point: file or socket
-    std::variant<int, std::ofstream> dest_;
+    std::variant<int, std::ofstream, SharedFile> dest_;
+    std::string path_;  // file only
+
+    // Time index of a file, null when disabled
+    std::unique_ptr<detail::Indexer> indexer_;
+
+    // Text line layout
+    Pattern pattern_;
+    std::string name_;
+
+    // Socket wire protocol state
+    WireFormat format_ = WireFormat::TEXT;
+    wire::Encoder encoder_;
+    std::uint64_t seq_ = 0;
+
+    // Backtrace ring, created once by enable_backtrace()
+    std::unique_ptr<detail::Backtrace> backtrace_;
+    std::atomic<bool> backtrace_enabled_{false};
+
+    // Asynchronous mode state, null when synchronous. async_mutex_ is held
+    // shared while queueing and exclusively while switching the mode.
+    mutable std::shared_mutex async_mutex_;
+    std::unique_ptr<detail::Lanes> lanes_;
+    // Batches get tickets in the order they are taken and are written in
+    // ticket order. Formatting overlaps, and flush() waits only for the
+    // batches taken before it returns.
+    std::mutex drains_mutex_;
+    std::condition_variable drain_written_;
+    std::uint64_t next_drain_ = 0;
+    std::uint64_t written_drains_ = 0;  // tickets below it are written
+    Backend *backend_ = nullptr;
+    std::shared_ptr<detail::Source> source_;
+
+    // Load shedding controller, created once by enable_shedding()
+    std::unique_ptr<detail::Shedder> shedder_;
+    std::atomic<bool> shedding_enabled_{false};
+    // Levels below it are shed, raised by the controller
+    std::atomic<int> shed_floor_{0};
 };
 
+// Defined here to keep filtered streams free of calls
+inline LogStream::LogStream(
+    Logger *logger,
+    LogLevel level,
+    SourceLocation location
+)
+    : logger_(logger), level_(level), location_(location) {
+    if (logger_->should_log(level_)) {
+        acquire();
+    } else if (Profiler::enabled()) {
+        Profiler::record_filtered(location_);
+    }
+}
+
 }  // namespace loggerlib
 
 #endif  // LOGGERLIB_LOGGER_HPP_
\ No newline at end of file
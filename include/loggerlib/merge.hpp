@@ -0,0 +1,135 @@
+#ifndef LOGGERLIB_MERGE_HPP_
+#define LOGGERLIB_MERGE_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <loggerlib/export.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Timestamp-ordered merge of several log streams, used by the collector for
+// its connections and by loggerlib-merge for log files.
+//
+// Records are ordered by timestamp, then by stream, then by sequence number,
+// so records of one stream with equal timestamps keep their order. Each
+// stream may be out of order by up to the reorder window: a record is only
+// released once every open stream has moved past it by more than the
+// window, or the clock given to advance() has.
+
+namespace loggerlib {
+
+struct LOGGERLIB_EXPORT MergeOptions {
+    // How far behind its newest record a stream may still send records
+    std::chrono::milliseconds window{1000};
+};
+
+namespace merge {
+
+constexpr std::int64_t NO_TIMESTAMP = std::numeric_limits<std::int64_t>::min();
+
+struct LOGGERLIB_EXPORT Entry {
+    std::int64_t timestamp_ms = 0;  // since epoch
+    std::uint64_t seq = 0;
+    std::string text;  // whole lines
+};
+
+// Timestamp of a line in the default layout, "[YYYY-MM-DD HH:MM:SS] ...",
+// in local time. Calls mktime() once per hour of log.
+class LOGGERLIB_EXPORT LineClock {
+public:
+    std::optional<std::int64_t> timestamp_ms(std::string_view line);
+
+private:
+    std::string hour_;
+    std::int64_t hour_start_ = 0;
+};
+
+// Cuts a byte stream into entries of one line each, whatever the reads it
+// arrives in. Lines without a timestamp (continuations of multi-line
+// messages) get the timestamp of the line before them, so they stay with
+// their record. seq counts lines.
+class LOGGERLIB_EXPORT LineSplitter {
+public:
+    // Append received bytes
+    void feed(const char *data, std::size_t size);
+
+    // Get next complete line
+    bool next(Entry &entry);
+    // Get the unterminated tail at the end of the stream, '\n' is added
+    bool finish(Entry &entry);
+
+private:
+    void make_entry(std::string_view line, Entry &entry);
+
+    std::string input_;
+    std::size_t input_pos_ = 0;
+    LineClock clock_;
+    std::int64_t last_ts_ = NO_TIMESTAMP;
+    std::uint64_t seq_ = 0;
+};
+
+}  // namespace merge
+
+// Heap-based k-way merge with a bounded reorder window. Not thread-safe.
+class LOGGERLIB_EXPORT Merger {
+public:
+    explicit Merger(MergeOptions options = MergeOptions());
+
+    // Returns the id of a new stream. Ids of closed and drained streams are
+    // reused.
+    std::size_t add_stream();
+    void push(std::size_t stream, merge::Entry entry);
+    // The stream sends nothing more, its pending records are still merged
+    void close_stream(std::size_t stream);
+    // No open stream sends records older than now_ms - window any more
+    void advance(std::int64_t now_ms);
+
+    // Get the next record no stream can precede any more
+    bool pop(merge::Entry &entry);
+    // Get the next pending record regardless of the window
+    bool pop_any(merge::Entry &entry);
+
+    // Open stream that holds back the merge the most, the one to read next
+    // when streams are pulled. nullopt if no stream is open.
+    std::optional<std::size_t> lagging() const;
+
+    std::size_t pending() const {
+        return pending_;
+    }
+    // Records released after a later record, having come beyond the window
+    std::uint64_t late() const {
+        return late_;
+    }
+
+private:
+    struct Stream {
+        std::deque<merge::Entry> entries;  // sorted
+        std::int64_t newest_ts = merge::NO_TIMESTAMP;
+        bool open = false;
+    };
+
+    bool before(std::size_t lhs, std::size_t rhs) const;
+    std::int64_t watermark() const;
+    void take_front(merge::Entry &entry);
+
+    MergeOptions options_;
+    std::vector<Stream> streams_;
+    std::vector<std::size_t> free_;
+    // Ids of streams with pending records, a min-heap by their first record
+    std::vector<std::size_t> heap_;
+    std::int64_t clock_ = merge::NO_TIMESTAMP;
+    mutable std::int64_t watermark_ = merge::NO_TIMESTAMP;
+    mutable bool watermark_dirty_ = true;
+    std::int64_t last_released_ = merge::NO_TIMESTAMP;
+    std::size_t pending_ = 0;
+    std::uint64_t late_ = 0;
+};
+
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_MERGE_HPP_
@@ -0,0 +1,19 @@
+#ifndef LOGGERLIB_NET_HPP_
+#define LOGGERLIB_NET_HPP_
+
+#include <cstddef>
+#include <loggerlib/export.hpp>
+#include <string>
+
+namespace loggerlib {
+
+// Resolve host and connect a TCP socket, returns its descriptor.
+// Throws std::runtime_error if resolving or connecting fails.
+LOGGERLIB_EXPORT int connect_tcp(const std::string &host, int port);
+
+// send() until the whole buffer is written, false on error
+LOGGERLIB_EXPORT bool send_all(int sockfd, const char *data, std::size_t size);
+
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_NET_HPP_
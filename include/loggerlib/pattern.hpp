@@ -0,0 +1,392 @@
+#ifndef LOGGERLIB_PATTERN_HPP_
+#define LOGGERLIB_PATTERN_HPP_
+
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <limits>
+#include <loggerlib/export.hpp>
+#include <loggerlib/level.hpp>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace loggerlib {
+
+// Values a layout can refer to
+struct LineFields {
+    std::string_view message;
+    LogLevel level;
+    std::int64_t timestamp_ms;
+    std::uint32_t thread_id = 0;  // 0 - the calling thread
+    std::string_view name = {};   // %n, empty if unnamed
+};
+
+// Kernel id of the calling thread, as shown by ps/top
+inline std::uint32_t current_thread_id() {
+    thread_local const auto id = static_cast<std::uint32_t>(syscall(SYS_gettid));
+    return id;
+}
+
+namespace pattern {
+
+// Layout program op
+enum class Field : std::uint8_t {
+    LITERAL = 0,  // copy text[offset, offset + length)
+    YEAR,         // %Y
+    MONTH,        // %m
+    DAY,          // %d
+    HOUR,         // %H
+    MINUTE,       // %M
+    SECOND,       // %S
+    MILLIS,       // %e
+    LEVEL,        // %l, copy the level's length bytes at text[offset]
+    THREAD,       // %t
+    PID,          // %P
+    NAME,         // %n
+    MESSAGE       // %v
+};
+
+struct Op {
+    Field field = Field::LITERAL;
+    std::uint32_t offset = 0;
+    std::uint32_t length = 0;
+};
+
+inline constexpr std::string_view LEVEL_NAMES[] = {"DEBUG", "INFO", "ERROR"};
+inline constexpr std::size_t LEVEL_NAME_WIDTH = 5;
+
+constexpr Field field_of(char spec) {
+    switch (spec) {
+        case 'Y':
+            return Field::YEAR;
+        case 'm':
+            return Field::MONTH;
+        case 'd':
+            return Field::DAY;
+        case 'H':
+            return Field::HOUR;
+        case 'M':
+            return Field::MINUTE;
+        case 'S':
+            return Field::SECOND;
+        case 'e':
+            return Field::MILLIS;
+        case 'l':
+            return Field::LEVEL;
+        case 't':
+            return Field::THREAD;
+        case 'P':
+            return Field::PID;
+        case 'n':
+            return Field::NAME;
+        case 'v':
+            return Field::MESSAGE;
+        default:
+            throw std::runtime_error("Invalid log pattern: unknown field");
+    }
+}
+
+// Copy static text up to the next field into the program, returns the
+// position of that field
+template <typename Program>
+constexpr std::size_t
+compile_literal(std::string_view pattern, std::size_t pos, Program &program) {
+    while (pos < pattern.size()) {
+        if (pattern[pos] == '%') {
+            if (pos + 1 < pattern.size() && pattern[pos + 1] == '%') {
+                program.push_char('%');
+                pos += 2;
+                continue;
+            }
+            break;
+        }
+        program.push_char(pattern[pos++]);
+    }
+    return pos;
+}
+
+// Compile a pattern into a flat list of copy and field ops. A level name
+// and the static text after it are pre-rendered for every level and padded
+// to one width, so "%l: " gives "INFO:  " and messages stay aligned.
+template <typename Program>
+constexpr void compile(std::string_view pattern, Program &program) {
+    std::size_t pos = 0;
+    while (pos < pattern.size()) {
+        std::size_t start = program.text_size();
+        pos = compile_literal(pattern, pos, program);
+        if (program.text_size() > start) {
+            program.push_op(Op{
+                Field::LITERAL, static_cast<std::uint32_t>(start),
+                static_cast<std::uint32_t>(program.text_size() - start)
+            });
+        }
+        if (pos == pattern.size()) {
+            break;
+        }
+        if (pos + 1 == pattern.size()) {
+            throw std::runtime_error("Invalid log pattern: trailing %");
+        }
+
+        Field field = field_of(pattern[pos + 1]);
+        pos += 2;
+        if (field != Field::LEVEL) {
+            program.push_op(Op{field, 0, 0});
+            continue;
+        }
+
+        std::size_t suffix = program.text_size();
+        pos = compile_literal(pattern, pos, program);
+        std::size_t suffix_length = program.text_size() - suffix;
+        std::size_t width = LEVEL_NAME_WIDTH + suffix_length;
+
+        std::size_t chunks = program.text_size();
+        for (auto name : LEVEL_NAMES) {
+            for (char ch : name) {
+                program.push_char(ch);
+            }
+            for (std::size_t i = 0; i < suffix_length; ++i) {
+                program.push_char(program.char_at(suffix + i));
+            }
+            for (std::size_t i = name.size(); i < LEVEL_NAME_WIDTH; ++i) {
+                program.push_char(' ');
+            }
+        }
+        program.push_op(Op{
+            Field::LEVEL, static_cast<std::uint32_t>(chunks),
+            static_cast<std::uint32_t>(width)
+        });
+    }
+}
+
+// Broken-down local time, localtime_r runs once per second per thread
+inline const std::tm &local_time(std::int64_t second) {
+    thread_local std::int64_t cached_second =
+        std::numeric_limits<std::int64_t>::min();
+    thread_local std::tm cached{};
+    if (second != cached_second) {
+        std::time_t in_time = second;
+        localtime_r(&in_time, &cached);
+        cached_second = second;
+    }
+    return cached;
+}
+
+// Zero-padded fixed-width number
+inline char *write_digits(char *pos, unsigned value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        pos[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return pos + width;
+}
+
+inline char *write_text(char *pos, const char *text, std::size_t length) {
+    std::char_traits<char>::copy(pos, text, length);
+    return pos + length;
+}
+
+// Upper bound of the rendered line length
+inline std::size_t
+line_bound(const Op *ops, std::size_t count, const LineFields &fields) {
+    std::size_t bound = 1;  // '\n'
+    for (std::size_t i = 0; i < count; ++i) {
+        switch (ops[i].field) {
+            case Field::LITERAL:
+            case Field::LEVEL:
+                bound += ops[i].length;
+                break;
+            case Field::NAME:
+                bound += fields.name.size();
+                break;
+            case Field::MESSAGE:
+                bound += fields.message.size();
+                break;
+            default:
+                bound += 20;  // any number
+                break;
+        }
+    }
+    return bound;
+}
+
+// Run a compiled program: one resize, then plain copies into the line
+inline void render(
+    std::string &out,
+    const Op *ops,
+    std::size_t count,
+    const char *text,
+    const LineFields &fields
+) {
+    std::int64_t second = fields.timestamp_ms / 1000;
+    if (fields.timestamp_ms < 0 && fields.timestamp_ms % 1000 != 0) {
+        --second;
+    }
+    const std::tm *tm = nullptr;
+    auto time = [&]() -> const std::tm & {
+        if (!tm) {
+            tm = &local_time(second);
+        }
+        return *tm;
+    };
+
+    std::size_t start = out.size();
+    out.resize(start + line_bound(ops, count, fields));
+    char *pos = out.data() + start;
+    char *end = out.data() + out.size();
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const Op &op = ops[i];
+        switch (op.field) {
+            case Field::LITERAL:
+                pos = write_text(pos, text + op.offset, op.length);
+                break;
+            case Field::YEAR:
+                pos = write_digits(
+                    pos, static_cast<unsigned>(time().tm_year + 1900), 4
+                );
+                break;
+            case Field::MONTH:
+                pos = write_digits(
+                    pos, static_cast<unsigned>(time().tm_mon + 1), 2
+                );
+                break;
+            case Field::DAY:
+                pos = write_digits(pos, static_cast<unsigned>(time().tm_mday), 2);
+                break;
+            case Field::HOUR:
+                pos = write_digits(pos, static_cast<unsigned>(time().tm_hour), 2);
+                break;
+            case Field::MINUTE:
+                pos = write_digits(pos, static_cast<unsigned>(time().tm_min), 2);
+                break;
+            case Field::SECOND:
+                pos = write_digits(pos, static_cast<unsigned>(time().tm_sec), 2);
+                break;
+            case Field::MILLIS:
+                pos = write_digits(
+                    pos,
+                    static_cast<unsigned>(fields.timestamp_ms - second * 1000),
+                    3
+                );
+                break;
+            case Field::LEVEL:
+                pos = write_text(
+                    pos,
+                    text + op.offset +
+                        static_cast<std::size_t>(fields.level) * op.length,
+                    op.length
+                );
+                break;
+            case Field::THREAD:
+                pos = std::to_chars(
+                          pos, end,
+                          fields.thread_id ? fields.thread_id
+                                           : current_thread_id()
+                )
+                          .ptr;
+                break;
+            case Field::PID:
+                pos = std::to_chars(pos, end, getpid()).ptr;
+                break;
+            case Field::NAME:
+                pos = write_text(pos, fields.name.data(), fields.name.size());
+                break;
+            case Field::MESSAGE:
+                pos = write_text(
+                    pos, fields.message.data(), fields.message.size()
+                );
+                break;
+        }
+    }
+    *pos++ = '\n';
+    out.resize(static_cast<std::size_t>(pos - out.data()));
+}
+
+}  // namespace pattern
+
+namespace pattern {
+
+// Text a pattern of length characters can compile to. Each literal byte is
+// copied once, and again into the three level chunks if it follows a %l;
+// each %l adds three names of LEVEL_NAME_WIDTH. With k fields %l and L
+// literal bytes, L + 2k <= length and the text is at most
+// 4L + 3 * LEVEL_NAME_WIDTH * k, largest when every pair is a %l.
+constexpr std::size_t text_bound(std::size_t length) {
+    return length / 2 * 3 * LEVEL_NAME_WIDTH + length % 2 * 4;
+}
+
+}  // namespace pattern
+
+// Layout compiled at compile time, see compile_pattern()
+template <std::size_t N>
+struct StaticPattern {
+    std::array<pattern::Op, N> ops{};
+    std::size_t op_count = 0;
+    std::array<char, pattern::text_bound(N - 1)> text{};
+    std::size_t text_length = 0;
+
+    constexpr void push_op(pattern::Op op) {
+        ops[op_count++] = op;
+    }
+    constexpr void push_char(char ch) {
+        text[text_length++] = ch;
+    }
+    constexpr char char_at(std::size_t pos) const {
+        return text[pos];
+    }
+    constexpr std::size_t text_size() const {
+        return text_length;
+    }
+
+    // Append the line for fields to out, with a trailing '\n'
+    void format(std::string &out, const LineFields &fields) const {
+        pattern::render(out, ops.data(), op_count, text.data(), fields);
+    }
+};
+
+// constexpr auto layout = compile_pattern("%H:%M:%S.%e %l %v");
+// An invalid pattern fails to compile.
+template <std::size_t N>
+constexpr StaticPattern<N> compile_pattern(const char (&pattern)[N]) {
+    StaticPattern<N> program;
+    pattern::compile(std::string_view(pattern, N - 1), program);
+    return program;
+}
+
+// Line layout of the original Logger
+inline constexpr char DEFAULT_PATTERN[] = "[%Y-%m-%d %H:%M:%S] %l: %v";
+inline constexpr auto DEFAULT_LAYOUT = compile_pattern(DEFAULT_PATTERN);
+
+// Layout compiled at runtime. Fields:
+//  %Y %m %d %H %M %S - local date and time, %e - milliseconds,
+//  %l - level, %t - thread id, %P - process id, %n - logger name,
+//  %v - message, %% - percent sign.
+class LOGGERLIB_EXPORT Pattern {
+public:
+    // Throws std::runtime_error if the pattern is invalid
+    LOGGERLIB_EXPORT explicit Pattern(std::string_view pattern = DEFAULT_PATTERN);
+
+    // Append the line for fields to out, with a trailing '\n'
+    void format(std::string &out, const LineFields &fields) const {
+        pattern::render(out, ops_.data(), ops_.size(), text_.data(), fields);
+    }
+
+    const std::string &str() const {
+        return pattern_;
+    }
+
+private:
+    std::string pattern_;
+    std::vector<pattern::Op> ops_;
+    std::string text_;
+};
+
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_PATTERN_HPP_
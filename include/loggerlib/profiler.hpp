@@ -0,0 +1,96 @@
+#ifndef LOGGERLIB_PROFILER_HPP_
+#define LOGGERLIB_PROFILER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <loggerlib/export.hpp>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <version>
+#ifdef __cpp_lib_source_location
+#include <source_location>
+#endif
+
+namespace loggerlib {
+
+namespace detail {
+// Read on every log call, Profiler::enabled() is the accessor
+LOGGERLIB_EXPORT extern std::atomic<bool> profiling_enabled;
+}  // namespace detail
+
+// Call site of a log call. Plain fields, so code built as C++17 calls the
+// same exported functions; std::source_location fills them in where the
+// standard library has it, the compiler builtins elsewhere.
+struct SourceLocation {
+    const char *file = "";
+    const char *function = "";
+    std::uint32_t line = 0;
+    std::uint32_t column = 0;
+
+#ifdef __cpp_lib_source_location
+    static constexpr SourceLocation
+    current(std::source_location location = std::source_location::current()) {
+        return {
+            location.file_name(), location.function_name(), location.line(),
+            location.column()
+        };
+    }
+#else
+    // no column: sites on one line share a record
+    static constexpr SourceLocation current(
+        const char *file = __builtin_FILE(),
+        const char *function = __builtin_FUNCTION(),
+        std::uint32_t line = __builtin_LINE()
+    ) {
+        return {file, function, line, 0};
+    }
+#endif
+};
+
+// Counters of one log() call site
+struct LOGGERLIB_EXPORT CallSite {
+    std::string file;
+    unsigned line;
+    std::string function;
+    std::uint64_t calls;     // messages that passed the level
+    std::uint64_t filtered;  // messages dropped by the level
+    std::uint64_t bytes;     // message bytes of the passed ones
+    std::uint64_t cycles;    // spent formatting and writing/queueing
+};
+
+// Per-call-site profiling of Logger calls. While enabled, every call is
+// counted in a static record of its SourceLocation, interned into a
+// lock-free table on first use.
+class LOGGERLIB_EXPORT Profiler {
+public:
+    LOGGERLIB_EXPORT static void enable();
+    LOGGERLIB_EXPORT static void disable();
+    static bool enabled() {
+        return detail::profiling_enabled.load(std::memory_order_relaxed);
+    }
+    // Zero the counters of all sites
+    LOGGERLIB_EXPORT static void reset();
+
+    // The `count` sites that spent most cycles, most expensive first
+    LOGGERLIB_EXPORT static std::vector<CallSite> top(std::size_t count = 20);
+    // Same as a table
+    LOGGERLIB_EXPORT static void report(std::ostream &out, std::size_t count = 20);
+
+    // Used by Logger and the macros
+    LOGGERLIB_EXPORT static void record_filtered(
+        const SourceLocation &location
+    );
+    LOGGERLIB_EXPORT static void record_call(
+        const SourceLocation &location,
+        std::size_t bytes,
+        std::uint64_t cycles
+    );
+    // Timestamp counter, or nanoseconds where there is none
+    LOGGERLIB_EXPORT static std::uint64_t cycles();
+};
+
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_PROFILER_HPP_
@@ -0,0 +1,150 @@
+#ifndef LOGGERLIB_SEGMENT_STORE_HPP_
+#define LOGGERLIB_SEGMENT_STORE_HPP_
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <loggerlib/export.hpp>
+#include <loggerlib/level.hpp>
+#include <loggerlib/wire.hpp>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Append-only record storage of the collector, a directory of segments.
+//
+// Segment file "<dir>/<number, 12 digits>.seg":
+//     "LGLS" | u8 version | 3 zero bytes
+// followed by batch frames of the wire protocol, one per group commit,
+// with deltas running through the whole segment. A sealed segment ends
+// with a footer:
+//     u8 version | varint data end | varint records | 3 x varint level
+//     count | varint zigzag min ts | varint zigzag max ts | varint bytes |
+//     varint min length | varint max length | varint minutes |
+//     minutes x (varint zigzag minute delta | varint count) |
+//     u32 LE footer length | "LGLF"
+// Minutes are counted since the epoch. A segment without a footer (the
+// collector crashed) is scanned once on open, cut after its last whole
+// frame and sealed.
+
+namespace loggerlib {
+
+enum class LOGGERLIB_EXPORT FsyncPolicy {
+    NEVER = 0,  // leave it to the kernel
+    SEGMENT,    // when a segment is sealed
+    COMMIT      // after every group commit
+};
+
+struct LOGGERLIB_EXPORT SegmentStoreOptions {
+    // A segment is sealed once it grows past this
+    std::size_t segment_size = 64 << 20;
+    FsyncPolicy fsync = FsyncPolicy::SEGMENT;
+    bool compression = false;
+};
+
+// Aggregates of a set of records, kept in every footer
+struct LOGGERLIB_EXPORT SegmentSummary {
+    std::uint64_t records = 0;
+    std::array<std::uint64_t, 3> levels{};
+    std::int64_t min_ms = std::numeric_limits<std::int64_t>::max();
+    std::int64_t max_ms = std::numeric_limits<std::int64_t>::min();
+    // Message bytes
+    std::uint64_t bytes = 0;
+    std::uint64_t min_length = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t max_length = 0;
+    // Records per minute since the epoch
+    std::map<std::int64_t, std::uint64_t> minutes;
+
+    void add(LogLevel level, std::int64_t timestamp_ms, std::size_t length);
+    void merge(const SegmentSummary &other);
+    // Records in the minutes overlapping [from_ms, +inf)
+    std::uint64_t since(std::int64_t from_ms) const;
+};
+
+namespace segment {
+
+constexpr char MAGIC[4] = {'L', 'G', 'L', 'S'};
+constexpr char FOOTER_MAGIC[4] = {'L', 'G', 'L', 'F'};
+constexpr std::uint8_t VERSION = 1;
+constexpr std::size_t HEADER_SIZE = 8;
+
+LOGGERLIB_EXPORT std::string make_header();
+LOGGERLIB_EXPORT std::string
+make_footer(std::uint64_t data_end, const SegmentSummary &summary);
+// Footer of a segment file, nullopt if it has none or can't be read
+LOGGERLIB_EXPORT std::optional<SegmentSummary>
+read_footer(const std::string &path);
+// Records of a segment file, up to its last whole frame if it isn't sealed.
+// Throws std::runtime_error if it can't be read.
+LOGGERLIB_EXPORT std::vector<wire::Record> read(const std::string &path);
+
+}  // namespace segment
+
+// Writes records to the current segment with group commit: concurrent
+// append() calls are written by one of them with a single write(), then
+// synced according to the policy. Thread-safe.
+class LOGGERLIB_EXPORT SegmentStore {
+public:
+    // Creates dir if needed, seals a segment left open by a crash and starts
+    // a new one. Summaries of existing segments come from their footers.
+    // Throws std::runtime_error on file errors.
+    LOGGERLIB_EXPORT explicit SegmentStore(
+        std::string dir,
+        SegmentStoreOptions options = SegmentStoreOptions()
+    );
+    // Seals the current segment
+    LOGGERLIB_EXPORT ~SegmentStore();
+
+    SegmentStore(const SegmentStore &) = delete;
+    SegmentStore &operator=(const SegmentStore &) = delete;
+
+    // Store records, returns once they are written (and synced with
+    // FsyncPolicy::COMMIT). seq is assigned by the store. Throws
+    // std::runtime_error if the write fails.
+    LOGGERLIB_EXPORT void append(std::vector<wire::Record> records);
+
+    // Everything stored, including earlier runs
+    LOGGERLIB_EXPORT SegmentSummary summary() const;
+    LOGGERLIB_EXPORT std::vector<std::string> segments() const;
+
+private:
+    // Write what is pending as the committing thread
+    void commit(std::unique_lock<std::mutex> &lock);
+    void open_segment();
+    void seal_segment(const SegmentSummary &summary);
+    void sync_dir();
+    std::string segment_path(std::uint64_t number) const;
+
+    std::string dir_;
+    SegmentStoreOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable committed_cv_;
+    wire::Encoder encoder_;
+    std::uint64_t seq_ = 0;
+    // Records not taken by a commit yet, taken by the commit running, of
+    // the current segment and sealed
+    SegmentSummary pending_;
+    SegmentSummary writing_;
+    SegmentSummary segment_;
+    SegmentSummary sealed_;
+    std::uint64_t segment_bytes_ = 0;  // taken by commits
+    std::uint64_t next_commit_ = 1;
+    std::uint64_t committed_ = 0;
+    bool committing_ = false;
+    bool failed_ = false;
+
+    // Used by the committing thread only
+    int fd_ = -1;
+    std::uint64_t number_ = 0;
+    std::uint64_t written_ = 0;
+};
+
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_SEGMENT_STORE_HPP_
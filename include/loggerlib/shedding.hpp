@@ -0,0 +1,27 @@
+#ifndef LOGGERLIB_SHEDDING_HPP_
+#define LOGGERLIB_SHEDDING_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <loggerlib/export.hpp>
+
+namespace loggerlib {
+
+// Load shedding: under I/O pressure the effective level is raised above the
+// one set by set_level(), one step (DEBUG, then INFO) per interval
+struct LOGGERLIB_EXPORT SheddingOptions {
+    // Pressure: the slowest write in an interval took longer than this...
+    std::chrono::microseconds latency_budget{10000};
+    // ...or more messages than this wait in the async lanes
+    std::size_t backlog_budget = 65536;
+    // How often the pressure is checked
+    std::chrono::milliseconds interval{100};
+    // Calm: both below recovery_ratio of their budgets. Every `recovery`
+    // of calm lowers the level back by one step.
+    double recovery_ratio = 0.5;
+    std::chrono::milliseconds recovery{1000};
+};
+
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_SHEDDING_HPP_
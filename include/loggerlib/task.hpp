@@ -0,0 +1,33 @@
+#ifndef LOGGERLIB_TASK_HPP_
+#define LOGGERLIB_TASK_HPP_
+
+// C++20 only: Logger itself works with any coroutine library, this is the
+// bundled minimum for tests and benchmarks
+#include <coroutine>
+#include <exception>
+
+namespace loggerlib {
+
+// Fire-and-forget coroutine: starts at once, frees itself when done.
+// Start it from an EventLoop task so that log_async() resumes it there.
+struct Task {
+    struct promise_type {
+        Task get_return_object() noexcept {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {
+            std::terminate();
+        }
+    };
+};
+
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_TASK_HPP_
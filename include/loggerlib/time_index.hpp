@@ -0,0 +1,87 @@
+#ifndef LOGGERLIB_TIME_INDEX_HPP_
+#define LOGGERLIB_TIME_INDEX_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <loggerlib/export.hpp>
+#include <loggerlib/level.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Sparse time index kept next to a log file, see Logger::enable_time_index().
+//
+// Sidecar file "<log>.idx":
+//     "LGLI" | u8 version | 3 zero bytes
+// followed by fixed-size entries, one per closed region of the log:
+//     u64 LE offset | u64 LE length | i64 LE min ts | i64 LE max ts (ms) |
+//     u8 level mask (1 << level) | 7 zero bytes
+// Regions are contiguous and written in file order. A region is closed when
+// a write falls into another time bucket or the region grows too big, so
+// the log past the last entry is not indexed yet.
+
+namespace loggerlib {
+
+struct LOGGERLIB_EXPORT TimeIndexOptions {
+    // Width of a timestamp bucket, a region never spans two of them
+    std::chrono::milliseconds bucket{1000};
+    // Longest region in bytes
+    std::size_t region_bytes = 1 << 20;
+};
+
+namespace time_index {
+
+constexpr char MAGIC[4] = {'L', 'G', 'L', 'I'};
+constexpr std::uint8_t VERSION = 1;
+constexpr std::size_t HEADER_SIZE = 8;
+constexpr std::size_t ENTRY_SIZE = 40;
+
+struct LOGGERLIB_EXPORT Entry {
+    std::uint64_t offset = 0;
+    std::uint64_t length = 0;
+    std::int64_t min_ms = 0;
+    std::int64_t max_ms = 0;
+    std::uint8_t levels = 0;
+};
+
+// Part of the log worth scanning
+struct LOGGERLIB_EXPORT Range {
+    std::uint64_t offset;
+    std::uint64_t length;
+};
+
+inline std::string sidecar_path(const std::string &log_path) {
+    return log_path + ".idx";
+}
+
+inline std::uint8_t level_bit(LogLevel level) {
+    return static_cast<std::uint8_t>(1U << static_cast<int>(level));
+}
+
+LOGGERLIB_EXPORT std::string make_header();
+LOGGERLIB_EXPORT void put_entry(std::string &out, const Entry &entry);
+LOGGERLIB_EXPORT std::optional<Entry> parse_entry(std::string_view data);
+
+// Read the sidecar of log_path, nullopt if it is missing or malformed.
+// A torn last entry is ignored.
+LOGGERLIB_EXPORT std::optional<std::vector<Entry>>
+load(const std::string &log_path);
+
+// Byte ranges of a log of file_size bytes that may hold records with
+// from_ms <= ts < to_ms at min_level or above: matching regions, merged
+// when adjacent, plus the unindexed tail
+LOGGERLIB_EXPORT std::vector<Range> lookup(
+    const std::vector<Entry> &entries,
+    std::uint64_t file_size,
+    std::int64_t from_ms,
+    std::int64_t to_ms,
+    LogLevel min_level
+);
+
+}  // namespace time_index
+
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_TIME_INDEX_HPP_
@@ -0,0 +1,154 @@
+#ifndef LOGGERLIB_WIRE_HPP_
+#define LOGGERLIB_WIRE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <loggerlib/export.hpp>
+#include <loggerlib/level.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Framed binary protocol between the TCP Logger and the collector.
+//
+// Handshake (both directions, 6 bytes):
+//     "LGLB" | u8 version | u8 flags
+// The client sends its highest version and the flags it supports, the server
+// answers with the chosen version (0 = rejected) and the accepted flags.
+//
+// Batch frame:
+//     u32 LE length of the rest | u8 flags | [varint raw size] | payload
+// The raw size is present only for compressed batches. The payload is
+// a sequence of records:
+//     varint (seq delta << 2 | level) | varint zigzag(ts delta, ms) |
+//     varint message length | message bytes
+// Deltas are taken against the previous record of the same connection.
+
+namespace loggerlib {
+
+enum class LOGGERLIB_EXPORT WireFormat { TEXT = 0, BINARY };
+
+namespace wire {
+
+constexpr char MAGIC[4] = {'L', 'G', 'L', 'B'};
+constexpr std::uint8_t VERSION = 1;
+constexpr std::size_t HELLO_SIZE = 6;
+constexpr std::size_t FRAME_HEADER_SIZE = 5;
+
+// Handshake and batch flags
+constexpr std::uint8_t FLAG_COMPRESSED = 0x01;
+
+// Batches bigger than this are rejected by the decoder
+constexpr std::size_t MAX_FRAME_SIZE = 64 * 1024 * 1024;
+
+struct LOGGERLIB_EXPORT Record {
+    std::uint64_t seq = 0;
+    LogLevel level = LogLevel::INFO;
+    std::int64_t timestamp_ms = 0;  // since epoch
+    std::string message;
+};
+
+struct LOGGERLIB_EXPORT Hello {
+    std::uint8_t version = 0;
+    std::uint8_t flags = 0;
+};
+
+// Handshake helpers
+LOGGERLIB_EXPORT std::string make_hello(const Hello &hello);
+LOGGERLIB_EXPORT std::optional<Hello> parse_hello(std::string_view data);
+
+// Varint helpers (LEB128), also used by other on-disk formats
+LOGGERLIB_EXPORT void put_varint(std::string &out, std::uint64_t value);
+LOGGERLIB_EXPORT bool
+get_varint(const char *&pos, const char *end, std::uint64_t &value);
+
+inline std::uint64_t zigzag(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^
+           static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t unzigzag(std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1) ^
+           -static_cast<std::int64_t>(value & 1);
+}
+
+// Fixed-width little-endian helpers, also used by other on-disk formats
+inline void put_u32_le(std::string &out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+inline void put_u64_le(std::string &out, std::uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+inline std::uint32_t get_u32_le(const char *p) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<std::uint32_t>(static_cast<unsigned char>(p[i]))
+                 << (8 * i);
+    }
+    return value;
+}
+
+inline std::uint64_t get_u64_le(const char *p) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(p[i]))
+                 << (8 * i);
+    }
+    return value;
+}
+
+// In-tree LZ77 block compression
+LOGGERLIB_EXPORT std::string compress(std::string_view data);
+// Throws std::runtime_error if data is malformed or size doesn't match
+LOGGERLIB_EXPORT std::string
+decompress(std::string_view data, std::size_t raw_size);
+
+// Accumulates records into batch frames. Keeps delta state between batches,
+// so one encoder must be used per connection.
+class LOGGERLIB_EXPORT Encoder {
+public:
+    explicit Encoder(bool compression = false);
+
+    void add(const Record &record);
+    bool empty() const;
+
+    // Returns the framed batch and starts a new one
+    std::string finish();
+
+private:
+    bool compression_;
+    std::string payload_;
+    std::uint64_t last_seq_ = 0;
+    std::int64_t last_ts_ = 0;
+};
+
+// Streaming decoder for one connection
+class LOGGERLIB_EXPORT Decoder {
+public:
+    // Append received bytes
+    void feed(const char *data, std::size_t size);
+
+    // Get next complete record. Throws std::runtime_error on malformed input.
+    bool next(Record &record);
+
+private:
+    bool decode_frame();
+
+    std::string input_;
+    std::size_t input_pos_ = 0;
+    std::string batch_;
+    std::size_t batch_pos_ = 0;
+    std::uint64_t last_seq_ = 0;
+    std::int64_t last_ts_ = 0;
+};
+
+}  // namespace wire
+}  // namespace loggerlib
+
+#endif  // LOGGERLIB_WIRE_HPP_
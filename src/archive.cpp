@@ -0,0 +1,459 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <ctime>
+#include <limits>
+#include <loggerlib/archive.hpp>
+#include <loggerlib/io.hpp>
+#include <loggerlib/wire.hpp>
+#include <stdexcept>
+
+namespace loggerlib {
+namespace archive {
+
+namespace {
+
+constexpr std::string_view TAGS[] = {"DEBUG: ", "INFO:  ", "ERROR: "};
+constexpr std::size_t TAG_POS = 22;
+constexpr std::size_t MESSAGE_POS = 29;
+
+// "YYYY-MM-DD HH:MM:SS" in local time
+void format_time(std::int64_t seconds, char (&out)[20]) {
+    std::time_t time = static_cast<std::time_t>(seconds);
+    std::tm tm;
+    localtime_r(&time, &tm);
+    std::strftime(out, sizeof(out), "%Y-%m-%d %H:%M:%S", &tm);
+}
+
+std::string pack_column(const std::string &raw) {
+    std::string packed = wire::compress(raw);
+    std::string size;
+    wire::put_varint(size, raw.size());
+
+    std::string out;
+    if (packed.size() + size.size() < raw.size()) {
+        out.push_back(1);
+        out += size;
+        out += packed;
+    } else {
+        out.push_back(0);
+        out += raw;
+    }
+    return out;
+}
+
+[[noreturn]] void malformed() {
+    throw std::runtime_error("Malformed archive");
+}
+
+std::uint64_t next_varint(const char *&pos, const char *end) {
+    std::uint64_t value;
+    if (!wire::get_varint(pos, end, value)) {
+        malformed();
+    }
+    return value;
+}
+
+}  // namespace
+
+Writer::Writer(const std::string &path, ArchiveOptions options)
+    : options_(options) {
+    options_.block_records = std::clamp<std::size_t>(
+        options_.block_records, 1, std::numeric_limits<std::uint32_t>::max()
+    );
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    std::string header(MAGIC, sizeof(MAGIC));
+    header.push_back(static_cast<char>(VERSION));
+    header.append(3, '\0');
+    if (fd_ == -1 || !write_all(fd_, header.data(), header.size())) {
+        if (fd_ != -1) {
+            close(fd_);
+        }
+        throw std::runtime_error("Cannot create archive: " + path);
+    }
+}
+
+Writer::~Writer() {
+    try {
+        finish();
+    } catch (const std::runtime_error &) {
+    }
+}
+
+void Writer::add_line(std::string_view line) {
+    newline_ = !line.empty() && line.back() == '\n';
+    if (newline_) {
+        line.remove_suffix(1);
+    }
+
+    // "[YYYY-MM-DD HH:MM:SS] LEVEL: message"
+    int level = -1;
+    auto ts = clock_.timestamp_ms(line);
+    if (ts && line.size() >= MESSAGE_POS && line[TAG_POS - 1] == ' ') {
+        for (int i = 0; i < 3; ++i) {
+            if (line.substr(TAG_POS, TAGS[i].size()) == TAGS[i]) {
+                level = i;
+            }
+        }
+    }
+    // times skipped by a DST change don't format back, checked per hour
+    if (level != -1 && line.compare(1, 13, checked_hour_) != 0) {
+        int minutes = (line[15] - '0') * 10 + (line[16] - '0');
+        int seconds = (line[18] - '0') * 10 + (line[19] - '0');
+        char text[20];
+        format_time(*ts / 1000 - minutes * 60 - seconds, text);
+        if (line.compare(1, 13, text, 13) == 0) {
+            checked_hour_.assign(text, 13);
+        } else {
+            level = -1;
+        }
+    }
+
+    if (level != -1) {
+        end_record();
+        has_record_ = true;
+        level_ = static_cast<std::uint8_t>(level);
+        timestamp_ms_ = *ts;
+        message_.assign(line.substr(MESSAGE_POS));
+    } else if (has_record_ && level_ != RAW) {
+        message_ += '\n';
+        message_ += line;
+    } else {
+        end_record();
+        has_record_ = true;
+        level_ = RAW;
+        message_.assign(line);
+    }
+}
+
+void Writer::finish() {
+    if (fd_ == -1) {
+        return;
+    }
+    // the block of the last record is flushed here or by end_record()
+    if (!newline_ && has_record_) {
+        block_.flags |= NO_FINAL_NEWLINE;
+    }
+    end_record();
+    if (block_.records > 0) {
+        flush_block();
+    }
+    int fd = fd_;
+    fd_ = -1;
+    if (close(fd) != 0) {
+        throw std::runtime_error("Cannot write archive");
+    }
+}
+
+void Writer::end_record() {
+    if (!has_record_) {
+        return;
+    }
+    has_record_ = false;
+
+    // words with digits are the arguments of the template
+    std::string pattern;
+    if (message_.find(TEMPLATE_ARG) != std::string::npos) {
+        pattern.assign(1, TEMPLATE_ARG);
+        wire::put_varint(arguments_, message_.size());
+        arguments_ += message_;
+    } else {
+        std::size_t pos = 0;
+        while (pos <= message_.size()) {
+            std::size_t end =
+                std::min(message_.find(' ', pos), message_.size());
+            std::string_view word(message_.data() + pos, end - pos);
+            if (word.find_first_of("0123456789") != std::string_view::npos) {
+                pattern += TEMPLATE_ARG;
+                wire::put_varint(arguments_, word.size());
+                arguments_ += word;
+            } else {
+                pattern += word;
+            }
+            if (end < message_.size()) {
+                pattern += ' ';
+            }
+            pos = end + 1;
+        }
+    }
+    auto [it, added] = dictionary_.try_emplace(
+        std::move(pattern), static_cast<std::uint32_t>(templates_.size())
+    );
+    if (added) {
+        templates_.push_back(&it->first);
+    }
+    wire::put_varint(template_ids_, it->second);
+
+    // raw records keep the time of the record before them
+    std::int64_t ts = timestamp_ms_;
+    wire::put_varint(timestamps_, wire::zigzag(ts - last_ts_));
+    last_ts_ = ts;
+
+    std::uint32_t index = block_.records;
+    if (index % 4 == 0) {
+        levels_.push_back(0);
+    }
+    levels_.back() = static_cast<char>(
+        static_cast<unsigned char>(levels_.back()) |
+        (level_ << (index % 4 * 2))
+    );
+
+    if (block_.records == 0) {
+        block_.min_ms = ts;
+        block_.max_ms = ts;
+    }
+    block_.min_ms = std::min(block_.min_ms, ts);
+    block_.max_ms = std::max(block_.max_ms, ts);
+    block_.levels |= static_cast<std::uint8_t>(1U << level_);
+    ++block_.counts[level_];
+    ++block_.records;
+    ++records_;
+
+    if (block_.records >= options_.block_records) {
+        flush_block();
+    }
+}
+
+void Writer::flush_block() {
+    std::string templates;
+    wire::put_varint(templates, templates_.size());
+    for (const auto *pattern : templates_) {
+        wire::put_varint(templates, pattern->size());
+        templates += *pattern;
+    }
+    templates += template_ids_;
+
+    std::string columns[4] = {
+        std::move(timestamps_), std::move(levels_), pack_column(templates),
+        pack_column(arguments_)
+    };
+
+    std::string out;
+    wire::put_u32_le(out, block_.records);
+    wire::put_u64_le(out, static_cast<std::uint64_t>(block_.min_ms));
+    wire::put_u64_le(out, static_cast<std::uint64_t>(block_.max_ms));
+    out.push_back(static_cast<char>(block_.levels));
+    out.push_back(static_cast<char>(block_.flags));
+    out.append(2, '\0');
+    for (auto count : block_.counts) {
+        wire::put_u32_le(out, count);
+    }
+    for (const auto &column : columns) {
+        wire::put_u32_le(out, static_cast<std::uint32_t>(column.size()));
+    }
+    for (const auto &column : columns) {
+        out += column;
+    }
+    if (!write_all(fd_, out.data(), out.size())) {
+        throw std::runtime_error("Cannot write archive");
+    }
+
+    // every block starts its deltas at 0
+    block_ = BlockInfo();
+    timestamps_.clear();
+    levels_.clear();
+    dictionary_.clear();
+    templates_.clear();
+    template_ids_.clear();
+    arguments_.clear();
+    last_ts_ = 0;
+}
+
+Reader::Reader(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st{};
+    if (fd == -1 || fstat(fd, &st) != 0) {
+        if (fd != -1) {
+            close(fd);
+        }
+        throw std::runtime_error("Cannot open archive: " + path);
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ > 0) {
+        void *mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error("Cannot map archive: " + path);
+        }
+        data_ = static_cast<const char *>(mapped);
+    } else {
+        close(fd);
+    }
+
+    if (size_ < HEADER_SIZE ||
+        std::string_view(data_, 4) != std::string_view(MAGIC, 4) ||
+        static_cast<std::uint8_t>(data_[4]) != VERSION) {
+        unmap();
+        throw std::runtime_error("Not an archive: " + path);
+    }
+
+    // block headers only, the columns are skipped
+    std::size_t pos = HEADER_SIZE;
+    while (pos < size_) {
+        if (size_ - pos < BLOCK_HEADER_SIZE) {
+            unmap();
+            malformed();
+        }
+        const char *head = data_ + pos;
+        BlockInfo block;
+        block.records = wire::get_u32_le(head);
+        block.min_ms = static_cast<std::int64_t>(wire::get_u64_le(head + 4));
+        block.max_ms = static_cast<std::int64_t>(wire::get_u64_le(head + 12));
+        block.levels = static_cast<std::uint8_t>(head[20]);
+        block.flags = static_cast<std::uint8_t>(head[21]);
+        std::uint64_t length = 0;
+        for (int i = 0; i < 4; ++i) {
+            block.counts[i] = wire::get_u32_le(head + 24 + 4 * i);
+            block.column_sizes[i] = wire::get_u32_le(head + 40 + 4 * i);
+            length += block.column_sizes[i];
+        }
+        block.offset = pos + BLOCK_HEADER_SIZE;
+        if (length > size_ - block.offset) {
+            unmap();
+            malformed();
+        }
+        blocks_.push_back(block);
+        pos = block.offset + length;
+    }
+}
+
+Reader::~Reader() {
+    unmap();
+}
+
+void Reader::unmap() {
+    if (data_) {
+        munmap(const_cast<char *>(data_), size_);
+        data_ = nullptr;
+    }
+}
+
+std::string_view Reader::column(const BlockInfo &block, Column column) const {
+    std::uint64_t offset = block.offset;
+    for (int i = 0; i < column; ++i) {
+        offset += block.column_sizes[i];
+    }
+    return std::string_view(data_ + offset, block.column_sizes[column]);
+}
+
+std::string
+Reader::message_column(const BlockInfo &block, Column column) const {
+    std::string_view data = this->column(block, column);
+    if (data.empty()) {
+        malformed();
+    }
+    if (data[0] == 0) {
+        return std::string(data.substr(1));
+    }
+    const char *pos = data.data() + 1;
+    const char *end = data.data() + data.size();
+    std::uint64_t raw_size = next_varint(pos, end);
+    return wire::decompress(
+        std::string_view(pos, static_cast<std::size_t>(end - pos)), raw_size
+    );
+}
+
+std::vector<std::int64_t> Reader::timestamps(const BlockInfo &block) const {
+    std::string_view data = column(block, TIMESTAMPS);
+    const char *pos = data.data();
+    const char *end = pos + data.size();
+
+    std::vector<std::int64_t> result(block.records);
+    std::int64_t ts = 0;
+    for (auto &value : result) {
+        // one byte for most deltas
+        if (pos < end && static_cast<unsigned char>(*pos) < 0x80) {
+            ts += wire::unzigzag(static_cast<unsigned char>(*pos++));
+        } else {
+            ts += wire::unzigzag(next_varint(pos, end));
+        }
+        value = ts;
+    }
+    return result;
+}
+
+std::vector<std::uint8_t> Reader::levels(const BlockInfo &block) const {
+    std::string_view data = column(block, LEVELS);
+    if (data.size() < (block.records + 3) / 4) {
+        malformed();
+    }
+    std::vector<std::uint8_t> result(block.records);
+    for (std::uint32_t i = 0; i < block.records; ++i) {
+        result[i] = static_cast<std::uint8_t>(
+            (static_cast<unsigned char>(data[i / 4]) >> (i % 4 * 2)) & 3
+        );
+    }
+    return result;
+}
+
+void Reader::text(
+    const BlockInfo &block,
+    std::string &out,
+    const std::vector<bool> *keep
+) const {
+    auto stamps = timestamps(block);
+    auto codes = levels(block);
+    std::string templates = message_column(block, TEMPLATES);
+    std::string arguments = message_column(block, ARGUMENTS);
+
+    const char *pos = templates.data();
+    const char *end = pos + templates.size();
+    std::vector<std::string_view> dictionary(next_varint(pos, end));
+    for (auto &pattern : dictionary) {
+        std::uint64_t length = next_varint(pos, end);
+        if (length > static_cast<std::uint64_t>(end - pos)) {
+            malformed();
+        }
+        pattern = std::string_view(pos, length);
+        pos += length;
+    }
+
+    const char *arg = arguments.data();
+    const char *arg_end = arg + arguments.size();
+    std::int64_t second = -1;
+    char time[20];
+    for (std::uint32_t i = 0; i < block.records; ++i) {
+        std::uint64_t id = next_varint(pos, end);
+        if (id >= dictionary.size()) {
+            malformed();
+        }
+        bool kept = !keep || (*keep)[i];
+        if (kept && codes[i] != RAW) {
+            // timestamps are formatted once per second
+            std::int64_t seconds = stamps[i] / 1000 - (stamps[i] % 1000 < 0);
+            if (seconds != second) {
+                format_time(seconds, time);
+                second = seconds;
+            }
+            out += '[';
+            out.append(time, 19);
+            out += "] ";
+            out += TAGS[codes[i]];
+        }
+        for (char ch : dictionary[id]) {
+            if (ch != TEMPLATE_ARG) {
+                if (kept) {
+                    out += ch;
+                }
+                continue;
+            }
+            std::uint64_t length = next_varint(arg, arg_end);
+            if (length > static_cast<std::uint64_t>(arg_end - arg)) {
+                malformed();
+            }
+            if (kept) {
+                out.append(arg, length);
+            }
+            arg += length;
+        }
+        if (kept && (i + 1 < block.records ||
+                     !(block.flags & NO_FINAL_NEWLINE))) {
+            out += '\n';
+        }
+    }
+}
+
+}  // namespace archive
+}  // namespace loggerlib
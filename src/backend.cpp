@@ -0,0 +1,328 @@
+#include <loggerlib/backend.hpp>
+#include <pthread.h>
+#include <sched.h>
+#include <algorithm>
+#include "lanes.hpp"
+#include "source.hpp"
+
+namespace loggerlib {
+
+namespace {
+
+// Backend thread the code is running on, if any
+struct CurrentWorker {
+    const Backend *backend = nullptr;
+    std::size_t index = 0;
+};
+
+thread_local CurrentWorker current_worker;
+
+int native_policy(SchedulingPolicy policy) {
+    switch (policy) {
+        case SchedulingPolicy::FIFO:
+            return SCHED_FIFO;
+        case SchedulingPolicy::ROUND_ROBIN:
+            return SCHED_RR;
+        case SchedulingPolicy::BATCH:
+            return SCHED_BATCH;
+        case SchedulingPolicy::IDLE:
+            return SCHED_IDLE;
+        default:
+            return SCHED_OTHER;
+    }
+}
+
+}  // namespace
+
+Backend::Backend(const BackendOptions &options)
+    : options_(options), last_tick_(std::chrono::steady_clock::now()) {
+    for (std::size_t i = 0; i < options_.threads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (std::size_t i = 0; i < options_.threads; ++i) {
+        workers_[i]->thread = std::thread(&Backend::run_worker, this, i);
+    }
+}
+
+Backend::~Backend() {
+    shutdown(std::chrono::milliseconds::max());
+}
+
+Backend &Backend::instance() {
+    // never destroyed: loggers with static storage may still use it at exit
+    static Backend *backend = new Backend();
+    return *backend;
+}
+
+std::size_t Backend::threads() const {
+    return workers_.size();
+}
+
+void Backend::attach(const std::shared_ptr<detail::Source> &source) {
+    std::lock_guard lock(sources_mutex_);
+    sources_.push_back(source);
+}
+
+void Backend::detach(const std::shared_ptr<detail::Source> &source) {
+    {
+        std::lock_guard lock(sources_mutex_);
+        sources_.erase(
+            std::remove(sources_.begin(), sources_.end(), source),
+            sources_.end()
+        );
+    }
+
+    // a tick checking the source is done now, wait for a drain in
+    // progress, queued copies are skipped later
+    std::lock_guard lock(source->run_mutex);
+    source->detached = true;
+}
+
+void Backend::schedule(const std::shared_ptr<detail::Source> &source) {
+    if (stopped_.load()) {
+        drain_inline(source);
+        return;
+    }
+    if (workers_.empty()) {
+        return;
+    }
+
+    int state = source->state.load();
+    while (true) {
+        if (state == detail::Source::IDLE) {
+            if (source->state.compare_exchange_weak(
+                    state, detail::Source::QUEUED
+                )) {
+                break;
+            }
+        } else if (state == detail::Source::RUNNING) {
+            // the running thread requeues it when done
+            if (source->state.compare_exchange_weak(
+                    state, detail::Source::RUNNING_AGAIN
+                )) {
+                return;
+            }
+        } else {
+            return;
+        }
+    }
+
+    // keep the task on the scheduling worker, spread the rest
+    std::size_t index = current_worker.backend == this
+                            ? current_worker.index
+                            : next_worker_.fetch_add(1) % workers_.size();
+    push_task(index, source);
+}
+
+void Backend::push_task(
+    std::size_t index,
+    std::shared_ptr<detail::Source> source
+) {
+    {
+        std::lock_guard lock(workers_[index]->mutex);
+        workers_[index]->tasks.push_back(std::move(source));
+    }
+    queued_.fetch_add(1);
+
+    std::lock_guard lock(idle_mutex_);
+    idle_.notify_one();
+}
+
+std::shared_ptr<detail::Source> Backend::pop_task(std::size_t index) {
+    std::shared_ptr<detail::Source> task;
+
+    // own queue first, oldest task
+    {
+        auto &own = *workers_[index];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.front());
+            own.tasks.pop_front();
+        }
+    }
+
+    // steal the newest task of another worker
+    for (std::size_t i = 1; !task && i < workers_.size(); ++i) {
+        auto &victim = *workers_[(index + i) % workers_.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+        }
+    }
+
+    if (task) {
+        queued_.fetch_sub(1);
+    }
+    return task;
+}
+
+void Backend::run_task(
+    std::size_t index,
+    const std::shared_ptr<detail::Source> &task
+) {
+    bool more;
+    std::vector<detail::Parked> resumed;
+    {
+        std::lock_guard lock(task->run_mutex);
+        if (task->detached) {
+            task->state.store(detail::Source::IDLE);
+            return;
+        }
+        task->state.store(detail::Source::RUNNING);
+        more = task->drain(resumed);
+    }
+    // a coroutine resumed in place may flush or detach this very source
+    detail::Lanes::resume(resumed);
+
+    // requeue behind other tasks so quiet loggers aren't starved
+    int expected = detail::Source::RUNNING;
+    if (more || !task->state.compare_exchange_strong(
+                    expected, detail::Source::IDLE
+                )) {
+        task->state.store(detail::Source::QUEUED);
+        push_task(index, task);
+    }
+}
+
+void Backend::schedule_due() {
+    std::unique_lock lock(sources_mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_tick_ < options_.tick) {
+        return;
+    }
+    last_tick_ = now;
+
+    // due() is asked under the lock: once detach() removed a source, its
+    // logger may drop the lanes due() reads
+    std::vector<std::shared_ptr<detail::Source>> due;
+    for (const auto &source : sources_) {
+        if (source->due(now)) {
+            due.push_back(source);
+        }
+    }
+    lock.unlock();
+
+    for (const auto &source : due) {
+        schedule(source);
+    }
+}
+
+void Backend::drain_inline(const std::shared_ptr<detail::Source> &source) {
+    // tasks left in the queues keep their state, it isn't looked at here
+    std::vector<detail::Parked> resumed;
+    {
+        std::lock_guard lock(source->run_mutex);
+        if (!source->detached) {
+            while (source->drain(resumed)) {
+            }
+        }
+    }
+    detail::Lanes::resume(resumed);
+}
+
+bool Backend::has_backlog() {
+    std::lock_guard lock(sources_mutex_);
+    return std::any_of(sources_.begin(), sources_.end(), [](const auto &s) {
+        return !s->empty();
+    });
+}
+
+void Backend::setup_thread(std::size_t index) {
+    pthread_t self = pthread_self();
+
+    if (!options_.cpu_affinity.empty()) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(
+            options_.cpu_affinity[index % options_.cpu_affinity.size()], &cpus
+        );
+        pthread_setaffinity_np(self, sizeof(cpus), &cpus);
+    }
+
+    if (options_.policy != SchedulingPolicy::DEFAULT) {
+        sched_param param{};
+        param.sched_priority = options_.priority;
+        pthread_setschedparam(self, native_policy(options_.policy), &param);
+    }
+}
+
+void Backend::run_worker(std::size_t index) {
+    setup_thread(index);
+    current_worker = {this, index};
+
+    while (!stopped_.load()) {
+        schedule_due();
+
+        if (auto task = pop_task(index)) {
+            run_task(index, task);
+            continue;
+        }
+
+        std::unique_lock lock(idle_mutex_);
+        idle_.wait_for(lock, options_.tick, [&] {
+            return queued_.load() > 0 || stopped_.load();
+        });
+    }
+}
+
+bool Backend::shutdown(std::chrono::milliseconds deadline) {
+    if (stopped_.load()) {
+        return !has_backlog();
+    }
+    if (workers_.empty()) {
+        std::vector<std::shared_ptr<detail::Source>> sources;
+        {
+            std::lock_guard lock(sources_mutex_);
+            sources = sources_;
+        }
+        for (const auto &source : sources) {
+            drain_inline(source);
+        }
+        stopped_.store(true);
+        return !has_backlog();
+    }
+
+    // milliseconds::max() means no deadline
+    auto until = deadline == std::chrono::milliseconds::max()
+                     ? std::chrono::steady_clock::time_point::max()
+                     : std::chrono::steady_clock::now() + deadline;
+
+    bool drained = false;
+    while (true) {
+        {
+            std::lock_guard lock(sources_mutex_);
+            for (const auto &source : sources_) {
+                if (!source->empty()) {
+                    schedule(source);
+                }
+            }
+        }
+        if (!has_backlog()) {
+            drained = true;
+            break;
+        }
+        if (std::chrono::steady_clock::now() >= until) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    stopped_.store(true);
+    {
+        std::lock_guard lock(idle_mutex_);
+        idle_.notify_all();
+    }
+    for (auto &worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+    return drained;
+}
+
+}  // namespace loggerlib
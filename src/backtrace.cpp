@@ -0,0 +1,269 @@
+#include "backtrace.hpp"
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <loggerlib/pattern.hpp>
+#include <utility>
+
+namespace loggerlib::detail {
+
+namespace {
+
+std::atomic<std::uint64_t> next_backtrace_id{1};
+
+// Rings used by the current thread, one per live Backtrace
+struct ThreadRings {
+    std::vector<std::pair<std::uint64_t, std::shared_ptr<BacktraceRing>>>
+        rings;
+
+    ~ThreadRings() {
+        // give the rings back for reuse by new threads, entries stay
+        for (auto &[id, ring] : rings) {
+            ring->in_use.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadRings thread_rings;
+
+void lock_ring(BacktraceRing &ring) {
+    while (ring.busy.test_and_set(std::memory_order_acquire)) {
+    }
+}
+
+void unlock_ring(BacktraceRing &ring) {
+    ring.busy.clear(std::memory_order_release);
+}
+
+// Async-signal-safe helpers: plain arithmetic, no locale, no allocation
+char *put_number(char *out, long value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return out + width;
+}
+
+// "[YYYY-MM-DD HH:MM:SS] " from local seconds since epoch
+char *put_timestamp(char *out, long long local_seconds) {
+    long long days = local_seconds / 86400;
+    long long rem = local_seconds % 86400;
+    if (rem < 0) {
+        rem += 86400;
+        --days;
+    }
+
+    // civil from days (proleptic Gregorian calendar)
+    days += 719468;
+    long long era = (days >= 0 ? days : days - 146096) / 146097;
+    long long doe = days - era * 146097;
+    long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long long mp = (5 * doy + 2) / 153;
+    long day = static_cast<long>(doy - (153 * mp + 2) / 5 + 1);
+    long month = static_cast<long>(mp < 10 ? mp + 3 : mp - 9);
+    long year = static_cast<long>(yoe + era * 400 + (month <= 2));
+
+    *out++ = '[';
+    out = put_number(out, year, 4);
+    *out++ = '-';
+    out = put_number(out, month, 2);
+    *out++ = '-';
+    out = put_number(out, day, 2);
+    *out++ = ' ';
+    out = put_number(out, static_cast<long>(rem / 3600), 2);
+    *out++ = ':';
+    out = put_number(out, static_cast<long>(rem / 60 % 60), 2);
+    *out++ = ':';
+    out = put_number(out, static_cast<long>(rem % 60), 2);
+    *out++ = ']';
+    *out++ = ' ';
+    return out;
+}
+
+void write_all(int fd, const char *data, std::size_t size) noexcept {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written <= 0) {
+            return;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
+
+}  // namespace
+
+Backtrace::Backtrace(std::size_t capacity)
+    : id_(next_backtrace_id.fetch_add(1)), capacity_(capacity) {
+    std::time_t now = std::time(nullptr);
+    std::tm buf;
+    localtime_r(&now, &buf);
+    utc_offset_ = buf.tm_gmtoff;
+}
+
+Backtrace::~Backtrace() {
+    // threads drop retired rings from their caches lazily
+    std::lock_guard lock(owned_mutex_);
+    for (auto &ring : owned_) {
+        ring->retired.store(true, std::memory_order_release);
+    }
+}
+
+void Backtrace::set_capacity(std::size_t capacity) {
+    capacity_.store(capacity, std::memory_order_relaxed);
+}
+
+std::size_t Backtrace::capacity() const {
+    return capacity_.load(std::memory_order_relaxed);
+}
+
+BacktraceRing *Backtrace::acquire_ring() {
+    auto &rings = thread_rings.rings;
+    for (auto &[id, ring] : rings) {
+        if (id == id_) {
+            return ring.get();
+        }
+    }
+
+    rings.erase(
+        std::remove_if(
+            rings.begin(), rings.end(),
+            [](const auto &item) {
+                return item.second->retired.load(std::memory_order_acquire);
+            }
+        ),
+        rings.end()
+    );
+
+    // reuse a ring left by an exited thread
+    std::shared_ptr<BacktraceRing> ring;
+    {
+        std::lock_guard lock(owned_mutex_);
+        for (auto &candidate : owned_) {
+            bool expected = false;
+            if (candidate->in_use.compare_exchange_strong(expected, true)) {
+                ring = candidate;
+                break;
+            }
+        }
+        if (!ring) {
+            ring = std::make_shared<BacktraceRing>();
+            owned_.push_back(ring);
+            ring->next.store(head_.load(std::memory_order_relaxed));
+            head_.store(ring.get(), std::memory_order_release);
+        }
+    }
+
+    rings.emplace_back(id_, ring);
+    return ring.get();
+}
+
+void Backtrace::push(
+    LogLevel level,
+    std::int64_t timestamp_ms,
+    const char *message,
+    std::size_t length
+) {
+    BacktraceRing *ring = acquire_ring();
+    std::size_t capacity = capacity_.load(std::memory_order_relaxed);
+
+    lock_ring(*ring);
+    if (ring->slots.size() != capacity) {
+        ring->slots.assign(capacity, BacktraceEntry{});
+        ring->head = 0;
+        ring->count = 0;
+    }
+    if (capacity > 0) {
+        auto &entry = ring->slots[ring->head];
+        entry.timestamp_ms = timestamp_ms;
+        entry.level = level;
+        entry.thread_id = current_thread_id();
+        entry.truncated = length > BACKTRACE_MESSAGE_SIZE;
+        entry.length = static_cast<std::uint16_t>(
+            std::min(length, BACKTRACE_MESSAGE_SIZE)
+        );
+        std::memcpy(entry.text, message, entry.length);
+
+        ring->head = (ring->head + 1) % capacity;
+        ring->count = std::min(ring->count + 1, capacity);
+    }
+    unlock_ring(*ring);
+}
+
+std::vector<BacktraceEntry> Backtrace::drain() {
+    std::vector<BacktraceEntry> entries;
+
+    for (auto *ring = head_.load(std::memory_order_acquire); ring;
+         ring = ring->next.load(std::memory_order_relaxed)) {
+        lock_ring(*ring);
+        std::size_t size = ring->slots.size();
+        for (std::size_t i = 0; i < ring->count; ++i) {
+            entries.push_back(
+                ring->slots[(ring->head + size - ring->count + i) % size]
+            );
+        }
+        ring->count = 0;
+        unlock_ring(*ring);
+    }
+
+    std::stable_sort(
+        entries.begin(), entries.end(),
+        [](const BacktraceEntry &lhs, const BacktraceEntry &rhs) {
+            return lhs.timestamp_ms < rhs.timestamp_ms;
+        }
+    );
+
+    std::size_t capacity = capacity_.load(std::memory_order_relaxed);
+    if (entries.size() > capacity) {
+        entries.erase(entries.begin(), entries.end() - capacity);
+    }
+    return entries;
+}
+
+void Backtrace::clear() {
+    for (auto *ring = head_.load(std::memory_order_acquire); ring;
+         ring = ring->next.load(std::memory_order_relaxed)) {
+        lock_ring(*ring);
+        ring->count = 0;
+        unlock_ring(*ring);
+    }
+}
+
+void Backtrace::dump_signal_safe(int fd) const noexcept {
+    static const char *tags[] = {"DEBUG: ", "INFO:  ", "ERROR: "};
+    char line[BACKTRACE_MESSAGE_SIZE + 64];
+
+    for (auto *ring = head_.load(std::memory_order_acquire); ring;
+         ring = ring->next.load(std::memory_order_relaxed)) {
+        // never wait in a signal handler: the owner may be interrupted
+        if (ring->busy.test_and_set(std::memory_order_acquire)) {
+            continue;
+        }
+
+        std::size_t size = ring->slots.size();
+        for (std::size_t i = 0; i < ring->count; ++i) {
+            const auto &entry =
+                ring->slots[(ring->head + size - ring->count + i) % size];
+
+            char *out = put_timestamp(
+                line, entry.timestamp_ms / 1000 + utc_offset_
+            );
+            std::memcpy(out, tags[static_cast<int>(entry.level)], 7);
+            out += 7;
+            std::memcpy(out, entry.text, entry.length);
+            out += entry.length;
+            if (entry.truncated) {
+                std::memcpy(out, "...", 3);
+                out += 3;
+            }
+            *out++ = '\n';
+
+            write_all(fd, line, static_cast<std::size_t>(out - line));
+        }
+        ring->busy.clear(std::memory_order_release);
+    }
+}
+
+}  // namespace loggerlib::detail
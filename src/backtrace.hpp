@@ -0,0 +1,79 @@
+#ifndef LOGGERLIB_SRC_BACKTRACE_HPP_
+#define LOGGERLIB_SRC_BACKTRACE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <loggerlib/level.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace loggerlib::detail {
+
+// Longer messages are truncated in the ring
+constexpr std::size_t BACKTRACE_MESSAGE_SIZE = 240;
+
+struct BacktraceEntry {
+    std::int64_t timestamp_ms;
+    LogLevel level;
+    std::uint32_t thread_id;
+    std::uint16_t length;
+    bool truncated;
+    char text[BACKTRACE_MESSAGE_SIZE];
+};
+
+// Fixed-size ring owned by one thread at a time. The busy flag is taken by
+// the owner on push and by dumpers, so it is practically never contended.
+struct BacktraceRing {
+    std::atomic<BacktraceRing *> next{nullptr};
+    std::atomic<bool> in_use{true};
+    std::atomic<bool> retired{false};
+    std::atomic_flag busy = ATOMIC_FLAG_INIT;
+
+    std::vector<BacktraceEntry> slots;
+    std::size_t head = 0;  // next slot to write
+    std::size_t count = 0;
+};
+
+class Backtrace {
+public:
+    explicit Backtrace(std::size_t capacity);
+    ~Backtrace();
+
+    void set_capacity(std::size_t capacity);
+    std::size_t capacity() const;
+
+    // Store a message in the calling thread's ring, no I/O
+    void push(
+        LogLevel level,
+        std::int64_t timestamp_ms,
+        const char *message,
+        std::size_t length
+    );
+
+    // Take the last capacity() entries of all threads ordered by time
+    std::vector<BacktraceEntry> drain();
+
+    void clear();
+
+    // Write all entries into fd using only async-signal-safe calls.
+    // Rings busy at the moment of the call are skipped.
+    void dump_signal_safe(int fd) const noexcept;
+
+private:
+    BacktraceRing *acquire_ring();
+
+    const std::uint64_t id_;  // unique, keys the thread-local ring cache
+    std::atomic<std::size_t> capacity_;
+    long utc_offset_;  // seconds, captured at creation for dump_signal_safe
+
+    // lock-free list for traversal, owned_ keeps the rings alive
+    std::atomic<BacktraceRing *> head_{nullptr};
+    std::mutex owned_mutex_;
+    std::vector<std::shared_ptr<BacktraceRing>> owned_;
+};
+
+}  // namespace loggerlib::detail
+
+#endif  // LOGGERLIB_SRC_BACKTRACE_HPP_
@@ -0,0 +1,85 @@
+#include <loggerlib/executor.hpp>
+
+namespace loggerlib {
+
+namespace {
+
+thread_local Executor *current_executor = nullptr;
+
+}  // namespace
+
+Executor *Executor::current() {
+    return current_executor;
+}
+
+void Executor::set_current(Executor *executor) {
+    current_executor = executor;
+}
+
+void EventLoop::post(std::function<void()> task) {
+    {
+        std::lock_guard lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    ready_.notify_one();
+}
+
+std::function<void()> EventLoop::pop(bool wait) {
+    std::unique_lock lock(mutex_);
+    if (wait) {
+        ready_.wait(lock, [&] { return !tasks_.empty() || stopped_; });
+        if (stopped_) {
+            // consumed, the next run() goes on
+            stopped_ = false;
+            return nullptr;
+        }
+    }
+    if (tasks_.empty()) {
+        return nullptr;
+    }
+    auto task = std::move(tasks_.front());
+    tasks_.pop_front();
+    return task;
+}
+
+void EventLoop::run() {
+    Executor *previous = current();
+    set_current(this);
+    while (auto task = pop(true)) {
+        task();
+    }
+    set_current(previous);
+}
+
+std::size_t EventLoop::poll() {
+    Executor *previous = current();
+    set_current(this);
+
+    // tasks posted meanwhile wait for the next poll()
+    std::size_t ready;
+    {
+        std::lock_guard lock(mutex_);
+        ready = tasks_.size();
+    }
+    std::size_t ran = 0;
+    for (; ran < ready; ++ran) {
+        auto task = pop(false);
+        if (!task) {
+            break;
+        }
+        task();
+    }
+
+    set_current(previous);
+    return ran;
+}
+
+void EventLoop::stop() {
+    {
+        std::lock_guard lock(mutex_);
+        stopped_ = true;
+    }
+    ready_.notify_all();
+}
+
+}  // namespace loggerlib
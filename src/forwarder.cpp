@@ -0,0 +1,322 @@
+#include <fcntl.h>
+#include <linux/sockios.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <loggerlib/forwarder.hpp>
+#include <loggerlib/net.hpp>
+#include <stdexcept>
+#include <utility>
+
+namespace loggerlib {
+
+namespace {
+
+constexpr char STATE_HEADER[] = "loggerlib-forwarder 1";
+
+// Directory to watch for events of the file at path
+std::string directory_of(const std::string &path) {
+    auto slash = path.rfind('/');
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+// sendfile() has no MSG_NOSIGNAL: SIGPIPE of a closed connection is held
+// back for the calling thread and discarded
+class SigpipeGuard {
+public:
+    SigpipeGuard() {
+        sigemptyset(&sigpipe_);
+        sigaddset(&sigpipe_, SIGPIPE);
+        sigset_t pending;
+        sigpending(&pending);
+        was_pending_ = sigismember(&pending, SIGPIPE) == 1;
+        pthread_sigmask(SIG_BLOCK, &sigpipe_, &old_mask_);
+    }
+    ~SigpipeGuard() {
+        sigset_t pending;
+        sigpending(&pending);
+        if (!was_pending_ && sigismember(&pending, SIGPIPE) == 1) {
+            timespec zero{0, 0};
+            sigtimedwait(&sigpipe_, nullptr, &zero);
+        }
+        pthread_sigmask(SIG_SETMASK, &old_mask_, nullptr);
+    }
+
+    SigpipeGuard(const SigpipeGuard &) = delete;
+    SigpipeGuard &operator=(const SigpipeGuard &) = delete;
+
+private:
+    sigset_t sigpipe_;
+    sigset_t old_mask_;
+    bool was_pending_ = false;
+};
+
+}  // namespace
+
+Forwarder::Forwarder(
+    std::string path,
+    std::string host,
+    int port,
+    ForwarderOptions options
+)
+    : path_(std::move(path)),
+      host_(std::move(host)),
+      port_(port),
+      options_(std::move(options)) {
+    if (options_.state_path.empty()) {
+        options_.state_path = path_ + ".fwd";
+    }
+    options_.chunk_size = std::max<std::size_t>(options_.chunk_size, 1);
+
+    // creation, renames and writes in the directory all wake the pump
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotify_fd_ == -1 || wake_fd_ == -1 ||
+        inotify_add_watch(
+            inotify_fd_, directory_of(path_).c_str(),
+            IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO |
+                IN_MOVED_FROM | IN_DELETE
+        ) == -1) {
+        if (inotify_fd_ != -1) {
+            close(inotify_fd_);
+        }
+        if (wake_fd_ != -1) {
+            close(wake_fd_);
+        }
+        throw std::runtime_error("Cannot watch log file: " + path_);
+    }
+
+    std::ifstream state(options_.state_path);
+    std::string header;
+    if (std::getline(state, header) && header == STATE_HEADER) {
+        std::uint64_t device = 0;
+        std::uint64_t inode = 0;
+        std::uint64_t offset = 0;
+        if (state >> device >> inode >> offset) {
+            saved_device_ = static_cast<dev_t>(device);
+            saved_inode_ = static_cast<ino_t>(inode);
+            saved_offset_ = offset;
+        }
+    }
+}
+
+Forwarder::~Forwarder() {
+    if (sockfd_ != -1) {
+        wait_acknowledged();
+        disconnect();
+    }
+    if (file_fd_ != -1) {
+        save_state();
+        close(file_fd_);
+    }
+    close(inotify_fd_);
+    close(wake_fd_);
+}
+
+void Forwarder::connect() {
+    sockfd_ = connect_tcp(host_, port_);
+    fcntl(sockfd_, F_SETFL, fcntl(sockfd_, F_GETFL) | O_NONBLOCK);
+}
+
+void Forwarder::disconnect() {
+    // what the collector didn't acknowledge is sent again
+    offset_ -= std::min(offset_, unacknowledged());
+    close(sockfd_);
+    sockfd_ = -1;
+}
+
+std::uint64_t Forwarder::unacknowledged() const {
+    int queued = 0;
+    if (sockfd_ == -1 || ioctl(sockfd_, SIOCOUTQ, &queued) != 0) {
+        return 0;
+    }
+    return static_cast<std::uint64_t>(queued);
+}
+
+bool Forwarder::open_file() {
+    int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st{};
+    if (fd == -1 || fstat(fd, &st) != 0) {
+        if (fd != -1) {
+            close(fd);
+        }
+        return false;
+    }
+
+    file_fd_ = fd;
+    device_ = st.st_dev;
+    inode_ = st.st_ino;
+    offset_ = 0;
+    if (device_ == saved_device_ && inode_ == saved_inode_ &&
+        saved_offset_ <= static_cast<std::uint64_t>(st.st_size)) {
+        offset_ = saved_offset_;
+    }
+    saved_inode_ = 0;
+    saved_device_ = 0;
+    return true;
+}
+
+void Forwarder::save_state() {
+    // written aside and renamed, a crash leaves the old or the new state
+    std::string temp = options_.state_path + ".tmp";
+    {
+        std::ofstream state(temp, std::ios::trunc);
+        state << STATE_HEADER << "\n"
+              << static_cast<std::uint64_t>(device_) << " "
+              << static_cast<std::uint64_t>(inode_) << " "
+              << offset_ - std::min(offset_, unacknowledged()) << "\n";
+        if (!state.flush()) {
+            return;
+        }
+    }
+    std::rename(temp.c_str(), options_.state_path.c_str());
+}
+
+bool Forwarder::wait_writable() {
+    pollfd fds[2] = {{sockfd_, POLLOUT, 0}, {wake_fd_, POLLIN, 0}};
+    while (!stopped_.load()) {
+        int rv =
+            poll(fds, 2, static_cast<int>(options_.poll_interval.count()));
+        if (rv < 0 && errno != EINTR) {
+            return false;
+        }
+        if (rv > 0 && (fds[0].revents & (POLLOUT | POLLERR | POLLHUP))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Forwarder::wait_acknowledged() {
+    auto until = std::chrono::steady_clock::now() + options_.linger;
+    while (unacknowledged() > 0) {
+        if (std::chrono::steady_clock::now() >= until) {
+            return false;
+        }
+        usleep(1000);
+    }
+    return true;
+}
+
+std::uint64_t Forwarder::pump() {
+    if (sockfd_ == -1) {
+        connect();
+    }
+
+    SigpipeGuard guard;
+    std::uint64_t shipped = 0;
+    while (file_fd_ != -1 || open_file()) {
+        struct stat st{};
+        if (fstat(file_fd_, &st) != 0) {
+            break;
+        }
+        auto size = static_cast<std::uint64_t>(st.st_size);
+        if (size < offset_) {
+            offset_ = 0;  // truncated in place
+        }
+
+        bool truncated = false;
+        while (offset_ < size) {
+            auto offset = static_cast<off_t>(offset_);
+            ssize_t sent = sendfile(
+                sockfd_, file_fd_, &offset,
+                std::min<std::uint64_t>(size - offset_, options_.chunk_size)
+            );
+            if (sent > 0) {
+                offset_ += static_cast<std::uint64_t>(sent);
+                shipped += static_cast<std::uint64_t>(sent);
+            } else if (sent == 0) {
+                // truncated after fstat, the file has less than size
+                truncated = true;
+                break;
+            } else if (sent < 0 && errno == EINTR) {
+                continue;
+            } else if (sent < 0 && errno == EAGAIN) {
+                if (!wait_writable()) {
+                    save_state();
+                    return shipped;
+                }
+            } else {
+                disconnect();
+                save_state();
+                return shipped;
+            }
+        }
+        if (truncated) {
+            continue;
+        }
+
+        // rotated: the path names another file now. Writers append to the
+        // old one until they reopen, so it is left only once the collector
+        // has all of it and nothing was added meanwhile.
+        struct stat current{};
+        if (stat(path_.c_str(), &current) != 0 ||
+            (current.st_dev == device_ && current.st_ino == inode_)) {
+            break;
+        }
+        auto grown = [this]() {
+            struct stat old{};
+            return fstat(file_fd_, &old) == 0 &&
+                   static_cast<std::uint64_t>(old.st_size) > offset_;
+        };
+        if (grown()) {
+            continue;
+        }
+        if (!wait_acknowledged()) {
+            break;
+        }
+        if (grown()) {
+            continue;
+        }
+        close(file_fd_);
+        file_fd_ = -1;
+    }
+
+    if (file_fd_ != -1) {
+        save_state();
+    }
+    return shipped;
+}
+
+void Forwarder::run() {
+    while (!stopped_.load()) {
+        try {
+            pump();
+        } catch (const std::runtime_error &) {
+            // the collector is down, retried after the poll interval
+        }
+        wait_for_change();
+    }
+}
+
+void Forwarder::stop() noexcept {
+    stopped_.store(true);
+    std::uint64_t one = 1;
+    ssize_t rv = write(wake_fd_, &one, sizeof(one));
+    (void)rv;
+}
+
+void Forwarder::wait_for_change() {
+    pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+    int rv = poll(fds, 2, static_cast<int>(options_.poll_interval.count()));
+    if (rv > 0 && (fds[0].revents & POLLIN)) {
+        // events only wake the pump, which looks at the file itself
+        char events[4096];
+        while (read(inotify_fd_, events, sizeof(events)) > 0) {
+        }
+    }
+}
+
+}  // namespace loggerlib
@@ -0,0 +1,59 @@
+#ifndef LOGGERLIB_SRC_INDEXER_HPP_
+#define LOGGERLIB_SRC_INDEXER_HPP_
+
+#include <cstdint>
+#include <loggerlib/level.hpp>
+#include <loggerlib/time_index.hpp>
+#include <string>
+#include <vector>
+
+namespace loggerlib::detail {
+
+struct Message;
+
+// Time span and levels of the records in one write
+struct Extent {
+    std::int64_t min_ms;
+    std::int64_t max_ms;
+    std::uint8_t levels;
+};
+
+Extent extent_of(const std::vector<Message> &batch);
+
+// Appends time index entries for a log file as it grows, see time_index.hpp.
+// Not thread-safe, the Logger calls it under its mutex.
+class Indexer {
+public:
+    // Opens or creates the sidecar of log_path, file_size is the log's
+    // current size. Throws std::runtime_error if the sidecar can't be opened.
+    Indexer(
+        const std::string &log_path,
+        std::uint64_t file_size,
+        const TimeIndexOptions &options
+    );
+    // Writes the open region
+    ~Indexer();
+
+    Indexer(const Indexer &) = delete;
+    Indexer &operator=(const Indexer &) = delete;
+
+    // Account length bytes just appended to the log
+    void add(std::uint64_t length, const Extent &extent);
+    // Write the open region's entry now
+    void close_region();
+
+private:
+    std::int64_t bucket_of(std::int64_t timestamp_ms) const;
+
+    int fd_;
+    TimeIndexOptions options_;
+    std::uint64_t end_;  // log size
+    time_index::Entry region_;
+    std::int64_t region_bucket_ = 0;
+    bool open_ = false;
+    std::string entry_;  // reused encoding buffer
+};
+
+}  // namespace loggerlib::detail
+
+#endif  // LOGGERLIB_SRC_INDEXER_HPP_
@@ -0,0 +1,22 @@
+#include <unistd.h>
+#include <cerrno>
+#include <loggerlib/io.hpp>
+
+namespace loggerlib {
+
+bool write_all(int fd, const char *data, std::size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+}  // namespace loggerlib
@@ -0,0 +1,317 @@
+#include "lanes.hpp"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace loggerlib::detail {
+
+namespace {
+
+std::atomic<std::uint64_t> next_lanes_id{1};
+
+// Shards of the current thread, one per live Lanes
+struct ThreadShards {
+    std::vector<std::pair<std::uint64_t, std::shared_ptr<Shard>>> shards;
+
+    ~ThreadShards() {
+        // the writer drains what's left and forgets the shard
+        for (auto &[id, shard] : shards) {
+            shard->orphaned.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadShards thread_shards;
+
+}  // namespace
+
+Lanes::Lanes(const AsyncOptions &options, std::function<void()> on_batch)
+    : id_(next_lanes_id.fetch_add(1)),
+      options_(options),
+      on_batch_(std::move(on_batch)),
+      last_take_(std::chrono::steady_clock::now().time_since_epoch().count()) {
+    options_.batch_size = std::max<std::size_t>(options_.batch_size, 1);
+    for (auto &lane : options_.lanes) {
+        lane.capacity = std::max<std::size_t>(lane.capacity, 1);
+    }
+}
+
+Lanes::~Lanes() {
+    // threads drop retired shards from their caches lazily
+    std::lock_guard lock(shards_mutex_);
+    for (auto &shard : shards_) {
+        shard->retired.store(true, std::memory_order_release);
+    }
+}
+
+const AsyncOptions &Lanes::options() const {
+    return options_;
+}
+
+bool Lanes::write_through(LogLevel level) const {
+    return options_.lanes[static_cast<int>(level)].write_through;
+}
+
+std::size_t Lanes::batch_threshold(std::size_t lane) const {
+    return std::min(options_.batch_size, options_.lanes[lane].capacity);
+}
+
+Shard &Lanes::local_shard() {
+    auto &shards = thread_shards.shards;
+    for (auto &[id, shard] : shards) {
+        if (id == id_) {
+            return *shard;
+        }
+    }
+
+    shards.erase(
+        std::remove_if(
+            shards.begin(), shards.end(),
+            [](const auto &item) {
+                return item.second->retired.load(std::memory_order_acquire);
+            }
+        ),
+        shards.end()
+    );
+
+    // registered once per thread
+    auto shard = std::make_shared<Shard>();
+    {
+        std::lock_guard lock(shards_mutex_);
+        shards_.push_back(shard);
+    }
+    shards.emplace_back(id_, shard);
+    return *shard;
+}
+
+bool Lanes::push(Message &&message) {
+    auto lane = static_cast<std::size_t>(message.level);
+    const auto &lane_options = options_.lanes[lane];
+    Shard &shard = local_shard();
+    auto &queue = shard.queues[lane];
+    bool kept_all = true;
+
+    std::unique_lock lock(shard.mutex);
+    if (queue.size() >= lane_options.capacity) {
+        switch (lane_options.overflow) {
+            case OverflowPolicy::BLOCK:
+                // after stop() the final drain takes everything
+                shard.not_full.wait(lock, [&] {
+                    return queue.size() < lane_options.capacity ||
+                           stopped_.load();
+                });
+                break;
+            case OverflowPolicy::DROP_NEWEST:
+                dropped_[lane].fetch_add(1, std::memory_order_relaxed);
+                return false;
+            case OverflowPolicy::DROP_OLDEST:
+                queue.pop_front();
+                dropped_[lane].fetch_add(1, std::memory_order_relaxed);
+                kept_all = false;
+                break;
+        }
+    }
+
+    message.seq = shard.next_seq++;
+    queue.push_back(std::move(message));
+    std::size_t size = queue.size();
+    shard.sizes[lane].store(size, std::memory_order_relaxed);
+    lock.unlock();
+
+    // wake the writer once per batch, not per message
+    if (size == batch_threshold(lane)) {
+        on_batch_();
+    }
+    return kept_all;
+}
+
+bool Lanes::push_or_park(
+    Message &&message,
+    Executor *executor,
+    std::function<void()> &&resume
+) {
+    auto lane = static_cast<std::size_t>(message.level);
+    const auto &lane_options = options_.lanes[lane];
+    Shard &shard = local_shard();
+
+    if (lane_options.overflow == OverflowPolicy::BLOCK) {
+        std::unique_lock lock(shard.mutex);
+        // parked messages of the thread go first
+        if (!stopped_.load() &&
+            (shard.queues[lane].size() >= lane_options.capacity ||
+             !shard.parked[lane].empty())) {
+            message.seq = shard.next_seq++;
+            shard.parked[lane].push_back(
+                Parked{std::move(message), executor, std::move(resume)}
+            );
+            lock.unlock();
+            on_batch_();
+            return true;
+        }
+    }
+
+    // only this thread pushes to the shard, so push() won't wait now
+    push(std::move(message));
+    if (lane_options.write_through) {
+        on_batch_();
+    }
+    return false;
+}
+
+void Lanes::unpark_locked(
+    Shard &shard,
+    bool force,
+    std::vector<Parked> &resumed
+) {
+    for (std::size_t lane = 0; lane < shard.parked.size(); ++lane) {
+        auto &parked = shard.parked[lane];
+        auto &queue = shard.queues[lane];
+        while (!parked.empty() &&
+               (force || queue.size() < options_.lanes[lane].capacity)) {
+            queue.push_back(std::move(parked.front().message));
+            resumed.push_back(std::move(parked.front()));
+            parked.pop_front();
+        }
+        shard.sizes[lane].store(queue.size(), std::memory_order_relaxed);
+    }
+}
+
+void Lanes::resume(std::vector<Parked> &resumed) {
+    for (auto &parked : resumed) {
+        if (parked.executor) {
+            parked.executor->post(std::move(parked.resume));
+        } else {
+            parked.resume();
+        }
+    }
+    resumed.clear();
+}
+
+void Lanes::take(std::vector<Message> &out, std::vector<Parked> &resumed) {
+    last_take_.store(
+        std::chrono::steady_clock::now().time_since_epoch().count(),
+        std::memory_order_relaxed
+    );
+
+    std::vector<std::shared_ptr<Shard>> shards;
+    {
+        std::lock_guard lock(shards_mutex_);
+        shards = shards_;
+    }
+
+    std::array<std::deque<Message>, 3> taken;
+    std::vector<std::shared_ptr<Shard>> drained_orphans;
+    std::vector<Parked> unparked;
+    for (const auto &shard : shards) {
+        // orphaned is read before the swap: nothing can be pushed after it
+        bool orphaned = shard->orphaned.load(std::memory_order_acquire);
+
+        {
+            std::lock_guard lock(shard->mutex);
+            for (std::size_t lane = 0; lane < taken.size(); ++lane) {
+                taken[lane].swap(shard->queues[lane]);
+                shard->sizes[lane].store(0, std::memory_order_relaxed);
+            }
+
+            // freed space goes to parked coroutines first
+            std::size_t before = unparked.size();
+            unpark_locked(*shard, false, unparked);
+            if (orphaned && unparked.size() == before) {
+                drained_orphans.push_back(shard);
+            }
+        }
+        shard->not_full.notify_all();
+
+        for (auto &queue : taken) {
+            std::move(queue.begin(), queue.end(), std::back_inserter(out));
+            queue.clear();
+        }
+    }
+
+    // posted at once, so that detach() waits for it. Those resumed in place
+    // are left to the caller.
+    for (auto &parked : unparked) {
+        if (parked.executor) {
+            parked.executor->post(std::move(parked.resume));
+        } else {
+            resumed.push_back(std::move(parked));
+        }
+    }
+
+    // shards of exited threads are empty for good now
+    if (!drained_orphans.empty()) {
+        std::lock_guard lock(shards_mutex_);
+        for (const auto &shard : drained_orphans) {
+            // a concurrent take() may have removed it already
+            auto it = std::find(shards_.begin(), shards_.end(), shard);
+            if (it != shards_.end()) {
+                shards_.erase(it);
+            }
+        }
+    }
+
+    // cross-thread order is restored up to the timestamp resolution,
+    // a thread's own messages keep their order
+    std::stable_sort(
+        out.begin(), out.end(),
+        [](const Message &lhs, const Message &rhs) {
+            return lhs.timestamp_ms != rhs.timestamp_ms
+                       ? lhs.timestamp_ms < rhs.timestamp_ms
+                       : lhs.seq < rhs.seq;
+        }
+    );
+}
+
+bool Lanes::has_full_batch() const {
+    std::lock_guard lock(shards_mutex_);
+    for (const auto &shard : shards_) {
+        for (std::size_t lane = 0; lane < shard->sizes.size(); ++lane) {
+            if (shard->sizes[lane].load(std::memory_order_relaxed) >=
+                batch_threshold(lane)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool Lanes::due(std::chrono::steady_clock::time_point now) const {
+    auto last = std::chrono::steady_clock::time_point(
+        std::chrono::steady_clock::duration(
+            last_take_.load(std::memory_order_relaxed)
+        )
+    );
+    return backlog() > 0 && now - last >= options_.flush_interval;
+}
+
+void Lanes::stop() {
+    stopped_.store(true);
+
+    std::vector<Parked> resumed;
+    {
+        std::lock_guard lock(shards_mutex_);
+        for (auto &shard : shards_) {
+            std::lock_guard shard_lock(shard->mutex);
+            unpark_locked(*shard, true, resumed);
+            shard->not_full.notify_all();
+        }
+    }
+    resume(resumed);
+}
+
+std::size_t Lanes::backlog() const {
+    std::size_t total = 0;
+    std::lock_guard lock(shards_mutex_);
+    for (const auto &shard : shards_) {
+        for (const auto &size : shard->sizes) {
+            total += size.load(std::memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+std::uint64_t Lanes::dropped(LogLevel level) const {
+    return dropped_[static_cast<int>(level)].load(std::memory_order_relaxed);
+}
+
+}  // namespace loggerlib::detail
@@ -0,0 +1,120 @@
+#ifndef LOGGERLIB_SRC_LANES_HPP_
+#define LOGGERLIB_SRC_LANES_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <loggerlib/executor.hpp>
+#include <loggerlib/lanes.hpp>
+#include <loggerlib/level.hpp>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace loggerlib::detail {
+
+// Unformatted message waiting in a lane
+struct Message {
+    std::int64_t timestamp_ms;
+    LogLevel level;
+    std::string text;
+    std::uint64_t seq = 0;  // order within the producer thread
+    std::uint32_t thread_id = 0;
+};
+
+// Message of a suspended coroutine waiting for space in a full lane
+struct Parked {
+    Message message;
+    Executor *executor;  // resume is posted there, null - called in place
+    std::function<void()> resume;
+};
+
+// Staging buffer of one producer thread: a queue per lane. Its mutex is
+// shared only with the writer swapping the queues out, never with other
+// producers.
+struct Shard {
+    std::mutex mutex;
+    std::condition_variable not_full;
+    std::array<std::deque<Message>, 3> queues;
+    std::array<std::atomic<std::size_t>, 3> sizes{};
+    std::array<std::deque<Parked>, 3> parked;  // BLOCK lanes only
+    std::uint64_t next_seq = 0;
+
+    std::atomic<bool> orphaned{false};  // producer thread exited
+    std::atomic<bool> retired{false};   // Lanes destroyed
+};
+
+// Per-level bounded queues sharded by producer thread, drained by Backend
+// threads. Lane capacity applies to every thread's shard separately.
+class Lanes {
+public:
+    // on_batch is called when a shard collects a full batch
+    Lanes(const AsyncOptions &options, std::function<void()> on_batch);
+    ~Lanes();
+
+    const AsyncOptions &options() const;
+    bool write_through(LogLevel level) const;
+
+    // Queue a message applying the lane's overflow policy.
+    // Returns false if a message was dropped.
+    bool push(Message &&message);
+
+    // Non-blocking push for coroutines. A full BLOCK lane parks the message
+    // instead, and resume runs once it is queued. Write-through lanes are
+    // queued too and scheduled at once. Returns true if parked, resume is
+    // moved from only then.
+    bool push_or_park(
+        Message &&message,
+        Executor *executor,
+        std::function<void()> &&resume
+    );
+
+    // Swap out all shards and merge their messages into out by time.
+    // Parked coroutines whose messages got room are posted to their
+    // executors; those without one are moved to resumed.
+    void take(std::vector<Message> &out, std::vector<Parked> &resumed);
+
+    // Post or run resumptions. A coroutine without an executor runs in
+    // place and may log, flush or switch the mode, so the caller must hold
+    // no logger or backend lock.
+    static void resume(std::vector<Parked> &resumed);
+
+    // Whether a full batch is waiting in some shard
+    bool has_full_batch() const;
+    // Whether messages wait longer than the flush interval
+    bool due(std::chrono::steady_clock::time_point now) const;
+
+    // Release producers blocked on full lanes, they queue over capacity
+    // for the final drain
+    void stop();
+
+    std::size_t backlog() const;
+    std::uint64_t dropped(LogLevel level) const;
+
+private:
+    Shard &local_shard();
+    // Queue parked messages while the lane has room (any room if force),
+    // shard mutex must be held
+    void unpark_locked(Shard &shard, bool force, std::vector<Parked> &resumed);
+    std::size_t batch_threshold(std::size_t lane) const;
+
+    const std::uint64_t id_;  // unique, keys the thread-local shard cache
+    AsyncOptions options_;
+    std::function<void()> on_batch_;
+    std::array<std::atomic<std::uint64_t>, 3> dropped_{};
+
+    mutable std::mutex shards_mutex_;
+    std::vector<std::shared_ptr<Shard>> shards_;
+
+    std::atomic<std::chrono::steady_clock::rep> last_take_;
+    std::atomic<bool> stopped_{false};
+};
+
+}  // namespace loggerlib::detail
+
+#endif  // LOGGERLIB_SRC_LANES_HPP_
@@ -1,71 +1,282 @@
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <loggerlib/io.hpp>
 #include <loggerlib/logger.hpp>
+#include <loggerlib/net.hpp>
 #include <sstream>
 #include <variant>
+#include "backtrace.hpp"
+#include "indexer.hpp"
+#include "lanes.hpp"
+#include "shedder.hpp"
+#include "source.hpp"
 
 namespace loggerlib {
 
-// File writing ctor
-Logger::Logger(const std::string &filename, LogLevel level)
-    : level_(level), dest_(std::ofstream(filename, std::ios::app)) {
-    auto &ofs = std::get<std::ofstream>(dest_);
+namespace detail {
 
-    if (!ofs.is_open()) {
-        throw std::runtime_error("Cannot open log file: " + filename);
+// Appends stream output to a string that keeps its capacity between messages
+struct StreamBuffer : std::streambuf {
+    std::string data;
+    std::ostream stream{this};
+    bool in_use = false;
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            data.push_back(traits_type::to_char_type(ch));
+        }
+        return traits_type::not_eof(ch);
     }
-}
 
-// Socket writing ctor
-Logger::Logger(const std::string &host, int port, LogLevel level)
-    : level_(level) {
-    int sockfd;                 // socket file descriptor
-    struct addrinfo hints;      // for getaddrinfo search
-    struct addrinfo *servinfo;  // search results
-    struct addrinfo *p;         // iterating through servinfo
-    int rv;                     // error code
-
-    memset(&hints, 0, sizeof hints);  // to prevent trash
-    hints.ai_family = AF_UNSPEC;      // ipv4 or ipv6
-    hints.ai_socktype = SOCK_STREAM;  // TCP-socket
-
-    if ((rv = getaddrinfo(
-             host.c_str(), std::to_string(port).c_str(), &hints, &servinfo
-         )) != 0) {
-        throw std::runtime_error(
-            std::string("getaddrinfo: ") + gai_strerror(rv)
-        );
+    std::streamsize xsputn(const char *s, std::streamsize n) override {
+        data.append(s, static_cast<std::size_t>(n));
+        return n;
     }
+};
+
+}  // namespace detail
+
+namespace {
 
-    // iterating in servinfo trying to create socket & connect
-    for (p = servinfo; p != NULL; p = p->ai_next) {
-        if ((sockfd = socket(p->ai_family, p->ai_socktype, p->ai_protocol)) ==
-            -1) {
+thread_local detail::StreamBuffer thread_stream_buffer;
+
+// How long the client waits for the server's handshake reply
+constexpr int HANDSHAKE_TIMEOUT_MS = 2000;
+
+// Read exactly size bytes, waiting no longer than timeout_ms for each chunk
+bool recv_exact(int sockfd, char *data, std::size_t size, int timeout_ms) {
+    while (size > 0) {
+        pollfd pfd{sockfd, POLLIN, 0};
+        int rv = poll(&pfd, 1, timeout_ms);
+        if (rv < 0 && errno == EINTR) {
             continue;
         }
+        if (rv <= 0) {
+            return false;
+        }
 
-        if (connect(sockfd, p->ai_addr, p->ai_addrlen) == -1) {
-            close(sockfd);
-            continue;
+        ssize_t got = recv(sockfd, data, size, 0);
+        if (got <= 0) {
+            return false;
+        }
+        data += got;
+        size -= static_cast<std::size_t>(got);
+    }
+    return true;
+}
+
+// Returns accepted flags, throws if the server doesn't speak the protocol
+std::uint8_t negotiate(int sockfd) {
+    std::string hello = wire::make_hello({wire::VERSION, wire::FLAG_COMPRESSED}
+    );
+    char reply[wire::HELLO_SIZE];
+
+    if (!send_all(sockfd, hello.data(), hello.size()) ||
+        !recv_exact(sockfd, reply, sizeof(reply), HANDSHAKE_TIMEOUT_MS)) {
+        throw std::runtime_error("Wire protocol negotiation failed");
+    }
+
+    auto answer = wire::parse_hello(std::string_view(reply, sizeof(reply)));
+    if (!answer || answer->version == 0 || answer->version > wire::VERSION) {
+        throw std::runtime_error("Wire protocol negotiation failed");
+    }
+    return answer->flags & wire::FLAG_COMPRESSED;
+}
+
+std::int64_t current_time_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch()
+    )
+        .count();
+}
+
+// Get timestamp in YYYY-MM-DD HH:MM:SS format
+std::string format_timestamp(std::int64_t timestamp_ms) {
+    // localise the time
+    std::time_t in_time = timestamp_ms / 1000;
+    std::tm buf;
+    localtime_r(&in_time, &buf);
+
+    // get formatted timestamp
+    std::ostringstream oss;
+    oss << std::put_time(&buf, "%Y-%m-%d %H:%M:%S");
+
+    return oss.str();
+}
+
+// Split a record longer than SHARED_WRITE_SIZE into marked lines, one
+// write(2) each
+void append_chunked(int fd, std::string_view line) {
+    std::string_view body = line.substr(0, line.size() - 1);  // w/o '\n'
+    std::string marker = "+" + std::to_string(getpid()) + " ";
+    std::string chunk;
+    std::size_t pos = 0;
+
+    while (pos < body.size()) {
+        chunk.clear();
+        if (pos > 0) {
+            chunk += marker;
+        }
+        std::size_t room =
+            SHARED_WRITE_SIZE - chunk.size() - CONTINUATION_SUFFIX.size() - 1;
+        std::size_t length = std::min(room, body.size() - pos);
+        chunk.append(body.substr(pos, length));
+        pos += length;
+        if (pos < body.size()) {
+            chunk += CONTINUATION_SUFFIX;
+        }
+        chunk += '\n';
+        write_all(fd, chunk.data(), chunk.size());
+    }
+}
+
+// Write whole lines, as many per write(2) as fit in SHARED_WRITE_SIZE.
+// O_APPEND makes each write land at the end of the file in one piece, so
+// records of other processes never cut into these.
+void append_records(int fd, std::string_view out) {
+    std::size_t begin = 0;
+    while (begin < out.size()) {
+        std::size_t end = begin;
+        while (end < out.size()) {
+            std::size_t eol = out.find('\n', end);
+            std::size_t next = eol == std::string_view::npos ? out.size()
+                                                             : eol + 1;
+            if (next - begin > SHARED_WRITE_SIZE) {
+                break;
+            }
+            end = next;
+        }
+
+        if (end > begin) {
+            write_all(fd, out.data() + begin, end - begin);
+        } else {
+            // a single line over the limit
+            std::size_t eol = out.find('\n', begin);
+            end = eol == std::string_view::npos ? out.size() : eol + 1;
+            append_chunked(fd, out.substr(begin, end - begin));
         }
+        begin = end;
+    }
+}
+
+}  // namespace
+
+// Lets Backend threads drain the logger's lanes
+class AsyncSource : public detail::Source {
+public:
+    explicit AsyncSource(Logger *logger) : logger_(logger) {}
+
+    bool drain(std::vector<detail::Parked> &resumed) override {
+        logger_->drain_once(batch_, resumed);
+        logger_->refresh_shedding();
+        return logger_->lanes_->has_full_batch();
+    }
+
+    bool due(std::chrono::steady_clock::time_point now) const override {
+        // recovery is noticed even when all producers are shed
+        logger_->refresh_shedding();
+        return logger_->lanes_->due(now);
+    }
+
+    bool empty() const override {
+        return logger_->lanes_->backlog() == 0;
+    }
 
-        break;
+private:
+    Logger *logger_;
+    std::vector<detail::Message> batch_;
+};
+
+void LogStream::acquire() {
+    // nested streams (e.g. logging inside operator<<) get their own buffer
+    if (!thread_stream_buffer.in_use) {
+        buffer_ = &thread_stream_buffer;
+    } else {
+        buffer_ = new detail::StreamBuffer();
+    }
+    buffer_->in_use = true;
+}
+
+void LogStream::release() {
+    logger_->log(buffer_->data, level_, location_);
+
+    if (buffer_ != &thread_stream_buffer) {
+        delete buffer_;
+        return;
+    }
+
+    // reset the reusable buffer and any manipulators applied to it
+    buffer_->data.clear();
+    buffer_->stream.clear();
+    buffer_->stream.flags(std::ios_base::dec | std::ios_base::skipws);
+    buffer_->stream.precision(6);
+    buffer_->stream.width(0);
+    buffer_->stream.fill(' ');
+    buffer_->in_use = false;
+}
+
+std::ostream &LogStream::stream() {
+    return buffer_->stream;
+}
+
+// File writing ctor
+Logger::Logger(const std::string &filename, LogLevel level, FileMode mode)
+    : level_(level) {
+    if (mode == FileMode::SHARED) {
+        int fd = open(
+            filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644
+        );
+        if (fd == -1) {
+            throw std::runtime_error("Cannot open log file: " + filename);
+        }
+        dest_ = SharedFile{fd};
+        return;
     }
 
-    // couldn't connect by no address in servinfo
-    if (p == NULL) {
-        throw std::runtime_error("Socket connection failed");
+    dest_ = std::ofstream(filename, std::ios::app);
+    path_ = filename;
+    auto &ofs = std::get<std::ofstream>(dest_);
+
+    if (!ofs.is_open()) {
+        throw std::runtime_error("Cannot open log file: " + filename);
     }
+}
 
-    freeaddrinfo(servinfo);
+// Socket writing ctor
+Logger::Logger(
+    const std::string &host,
+    int port,
+    LogLevel level,
+    WireFormat format
+)
+    : level_(level), format_(format) {
+    int sockfd = connect_tcp(host, port);
+
+    if (format_ == WireFormat::BINARY) {
+        try {
+            encoder_ = wire::Encoder(negotiate(sockfd) != 0);
+        } catch (...) {
+            close(sockfd);
+            throw;
+        }
+    }
 
     dest_ = sockfd;
 }
 
-// Dtor closes file/socket
+// Dtor writes queued messages and closes file/socket
 Logger::~Logger() {
+    if (lanes_) {
+        disable_async();
+    }
+
     std::visit(
         [&](auto &dest) {
             using T = std::decay_t<decltype(dest)>;
@@ -76,38 +287,181 @@ Logger::~Logger() {
                 }
             } else if constexpr (std::is_same_v<T, int>) {
                 close(dest);
+            } else {
+                close(dest.fd);
             }
         },
         dest_
     );
 }
 
-void Logger::log(const std::string &message, LogLevel level) {
-    // Ignore if level is too low
-    if (level < level_) {
+void Logger::log(
+    const std::string &message,
+    LogLevel level,
+    SourceLocation location
+) {
+    if (!Profiler::enabled()) {
+        dispatch(message, level);
         return;
     }
 
+    auto start = Profiler::cycles();
+    if (dispatch(message, level)) {
+        Profiler::record_call(
+            location, message.size(), Profiler::cycles() - start
+        );
+    } else {
+        Profiler::record_filtered(location);
+    }
+}
+
+bool Logger::dispatch(const std::string &message, LogLevel level) {
+    // Ignore if level is too low or shed, but keep it for the backtrace
+    bool shed = static_cast<int>(level) <
+                shed_floor_.load(std::memory_order_relaxed);
+    if (level < level_.load(std::memory_order_relaxed) || shed) {
+        if (backtrace_enabled_.load(std::memory_order_acquire)) {
+            backtrace_->push(
+                level, current_time_ms(), message.data(), message.size()
+            );
+        }
+        if (shed && level >= level_.load(std::memory_order_relaxed)) {
+            note_shed(level);
+        }
+        return false;
+    }
+
+    // the report of a finished shedding episode goes first
+    update_shedding();
+
+    bool with_backtrace = level == LogLevel::ERROR &&
+                          backtrace_enabled_.load(std::memory_order_acquire);
+
+    // Queue into the level's lane unless it is written through
+    if (!with_backtrace) {
+        std::shared_lock async(async_mutex_);
+        if (lanes_ && !lanes_->write_through(level)) {
+            lanes_->push(detail::Message{
+                current_time_ms(), level, message, 0, current_thread_id()
+            });
+            return true;
+        }
+    }
+
     std::unique_lock lock(mutex_);
 
-    // Forming the message:
-    std::ostringstream oss;
-    oss << "[" << get_current_timestamp() << "] ";
+    // ERROR brings the context recorded before it
+    if (with_backtrace) {
+        write_backtrace_locked();
+    }
+
+    write_locked(message, level, current_time_ms(), current_thread_id());
+    return true;
+}
+
+bool LogAwaitable::suspend(std::function<void()> &&resume) {
+    return logger_->log_or_park(
+        std::move(message_), level_, executor_, location_, std::move(resume)
+    );
+}
 
-    switch (level) {
-        case LogLevel::DEBUG:
-            oss << "DEBUG: ";
-            break;
-        case LogLevel::INFO:
-            oss << "INFO:  ";
-            break;
-        case LogLevel::ERROR:
-            oss << "ERROR: ";
-            break;
+bool Logger::log_or_park(
+    std::string &&message,
+    LogLevel level,
+    Executor *executor,
+    SourceLocation location,
+    std::function<void()> &&resume
+) {
+    bool with_backtrace = level == LogLevel::ERROR &&
+                          backtrace_enabled_.load(std::memory_order_acquire);
+    bool shed = static_cast<int>(level) <
+                shed_floor_.load(std::memory_order_relaxed);
+    if (level < level_.load(std::memory_order_relaxed) || with_backtrace ||
+        shed) {
+        log(message, level, location);
+        return false;
     }
 
-    oss << message << "\n";
-    auto out = oss.str();
+    update_shedding();
+    {
+        std::shared_lock async(async_mutex_);
+        if (lanes_) {
+            return lanes_->push_or_park(
+                detail::Message{
+                    current_time_ms(), level, std::move(message), 0,
+                    current_thread_id()
+                },
+                executor, std::move(resume)
+            );
+        }
+    }
+    log(message, level, location);
+    return false;
+}
+
+void Logger::write_locked(
+    std::string_view message,
+    LogLevel level,
+    std::int64_t timestamp_ms,
+    std::uint32_t thread_id
+) {
+    // Binary socket: one record per batch
+    if (format_ == WireFormat::BINARY) {
+        encoder_.add(
+            wire::Record{seq_++, level, timestamp_ms, std::string(message)}
+        );
+        write_out_locked(encoder_.finish());
+        return;
+    }
+
+    std::string out;
+    pattern_.format(out, {message, level, timestamp_ms, thread_id, name_});
+    detail::Extent extent{
+        timestamp_ms, timestamp_ms, time_index::level_bit(level)
+    };
+    write_out_locked(out, &extent);
+}
+
+std::string Logger::format_batch(
+    const std::vector<detail::Message> &batch,
+    const Pattern &pattern,
+    std::string_view name
+) {
+    std::string out;
+    for (const auto &message : batch) {
+        pattern.format(
+            out, {message.text, message.level, message.timestamp_ms,
+                  message.thread_id, name}
+        );
+    }
+    return out;
+}
+
+void Logger::write_batch_locked(std::vector<detail::Message> &batch) {
+    // whole batch goes out with one write and one flush
+    if (format_ == WireFormat::BINARY) {
+        for (auto &message : batch) {
+            encoder_.add(wire::Record{
+                seq_++, message.level, message.timestamp_ms,
+                std::move(message.text)
+            });
+        }
+        write_out_locked(encoder_.finish());
+        return;
+    }
+
+    auto extent = detail::extent_of(batch);
+    write_out_locked(format_batch(batch, pattern_, name_), &extent);
+}
+
+void Logger::write_out_locked(
+    const std::string &out,
+    const detail::Extent *extent
+) {
+    // load shedding watches the write latency
+    bool timed = shedding_enabled_.load(std::memory_order_relaxed);
+    auto start = timed ? std::chrono::steady_clock::now()
+                       : std::chrono::steady_clock::time_point();
 
     // writing to file/sending to socket
     std::visit(
@@ -118,36 +472,303 @@ void Logger::log(const std::string &message, LogLevel level) {
                 dest << out;
                 dest.flush();
             } else if constexpr (std::is_same_v<T, int>) {
-                send(dest, out.c_str(), static_cast<int>(out.size()), 0);
+                send_all(dest, out.data(), out.size());
+            } else {
+                append_records(dest.fd, out);
             }
         },
         dest_
     );
+
+    if (timed) {
+        shedder_->record_write(std::chrono::steady_clock::now() - start);
+    }
+    if (indexer_ && extent) {
+        indexer_->add(out.size(), *extent);
+    }
 }
 
-void Logger::set_level(LogLevel level) {
+void Logger::write_backtrace_locked() {
+    for (const auto &entry : backtrace_->drain()) {
+        std::string message(entry.text, entry.length);
+        if (entry.truncated) {
+            message += "...";
+        }
+        write_locked(
+            message, entry.level, entry.timestamp_ms, entry.thread_id
+        );
+    }
+}
+
+void Logger::enable_backtrace(std::size_t size) {
     std::unique_lock lock(mutex_);
-    level_ = level;
+    if (!backtrace_) {
+        backtrace_ = std::make_unique<detail::Backtrace>(size);
+    } else {
+        backtrace_->set_capacity(size);
+    }
+    backtrace_enabled_.store(true, std::memory_order_release);
 }
 
-LogLevel Logger::get_level() const {
-    return level_;
+void Logger::disable_backtrace() {
+    std::unique_lock lock(mutex_);
+    backtrace_enabled_.store(false, std::memory_order_release);
+    if (backtrace_) {
+        backtrace_->clear();
+    }
 }
 
-std::string Logger::get_current_timestamp() {
-    // get current time
-    auto in_time =
-        std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+void Logger::dump_backtrace() {
+    std::unique_lock lock(mutex_);
+    if (backtrace_enabled_.load(std::memory_order_acquire)) {
+        write_backtrace_locked();
+    }
+}
 
-    // localise the time
-    std::tm buf;
-    localtime_r(&in_time, &buf);
+void Logger::dump_backtrace_signal_safe(int fd) noexcept {
+    if (backtrace_enabled_.load(std::memory_order_acquire)) {
+        backtrace_->dump_signal_safe(fd);
+    }
+}
 
-    // get formatted timestamp
-    std::ostringstream oss;
-    oss << std::put_time(&buf, "%Y-%m-%d %H:%M:%S");
+void Logger::enable_async(const AsyncOptions &options) {
+    if (lanes_) {
+        disable_async();
+    }
 
-    return oss.str();
+    auto *backend = options.backend ? options.backend : &Backend::instance();
+    auto source = std::make_shared<AsyncSource>(this);
+    auto lanes = std::make_unique<detail::Lanes>(
+        options,
+        [backend, weak = std::weak_ptr<detail::Source>(source)]() {
+            if (auto locked = weak.lock()) {
+                backend->schedule(locked);
+            }
+        }
+    );
+    {
+        std::unique_lock async(async_mutex_);
+        backend_ = backend;
+        source_ = source;
+        lanes_ = std::move(lanes);
+    }
+    backend->attach(source);
+}
+
+// Only enable_async() and disable_async() change lanes_, and not at the same
+// time, so they read it without async_mutex_
+void Logger::disable_async() {
+    if (!lanes_) {
+        return;
+    }
+
+    // no backend thread reads the lanes after detach(), producers blocked
+    // on full lanes hold async_mutex_ until stop() releases them
+    backend_->detach(source_);
+    lanes_->stop();
+
+    std::unique_lock async(async_mutex_);
+    std::vector<detail::Message> batch;
+    std::vector<detail::Parked> resumed;
+    while (drain_once(batch, resumed)) {
+    }
+    lanes_.reset();
+    source_.reset();
+    backend_ = nullptr;
+    async.unlock();
+    detail::Lanes::resume(resumed);
+}
+
+void Logger::flush() {
+    std::vector<detail::Parked> resumed;
+    {
+        std::shared_lock async(async_mutex_);
+        if (!lanes_) {
+            return;
+        }
+
+        std::vector<detail::Message> batch;
+        while (drain_once(batch, resumed)) {
+        }
+        // a Backend thread may still write a batch it took before
+        std::uint64_t taken;
+        {
+            std::lock_guard drains(drains_mutex_);
+            taken = next_drain_;
+        }
+        wait_drains(taken);
+    }
+    // resumed coroutines may log or flush again
+    detail::Lanes::resume(resumed);
+}
+
+std::uint64_t Logger::dropped(LogLevel level) const {
+    std::shared_lock async(async_mutex_);
+    return lanes_ ? lanes_->dropped(level) : 0;
+}
+
+bool Logger::drain_once(
+    std::vector<detail::Message> &batch,
+    std::vector<detail::Parked> &resumed
+) {
+    std::uint64_t ticket;
+    {
+        std::lock_guard drains(drains_mutex_);
+        batch.clear();
+        lanes_->take(batch, resumed);
+        if (batch.empty()) {
+            return false;
+        }
+        ticket = next_drain_++;
+    }
+    // the next batch is written after this one, even if this one throws
+    struct Turn {
+        Logger *logger;
+        std::uint64_t ticket;
+        ~Turn() {
+            logger->wait_drains(ticket);
+            std::lock_guard drains(logger->drains_mutex_);
+            ++logger->written_drains_;
+            logger->drain_written_.notify_all();
+        }
+    } turn{this, ticket};
+
+    // text doesn't depend on the writer state, format it outside the lock
+    // so that write-through messages wait only for the write itself. The
+    // layout is copied under the lock, set_pattern() may replace it.
+    if (format_ == WireFormat::TEXT) {
+        auto [pattern, name] = [this]() {
+            std::unique_lock lock(mutex_);
+            return std::pair(pattern_, name_);
+        }();
+        auto out = format_batch(batch, pattern, name);
+        auto extent = detail::extent_of(batch);
+        wait_drains(ticket);
+        std::unique_lock lock(mutex_);
+        write_out_locked(out, &extent);
+        return true;
+    }
+
+    wait_drains(ticket);
+    std::unique_lock lock(mutex_);
+    write_batch_locked(batch);
+    return true;
+}
+
+void Logger::wait_drains(std::uint64_t tickets) {
+    std::unique_lock drains(drains_mutex_);
+    drain_written_.wait(drains, [this, tickets]() {
+        return written_drains_ >= tickets;
+    });
+}
+
+void Logger::set_pattern(const std::string &pattern) {
+    Pattern compiled(pattern);
+    std::unique_lock lock(mutex_);
+    pattern_ = std::move(compiled);
+}
+
+void Logger::set_name(const std::string &name) {
+    std::unique_lock lock(mutex_);
+    name_ = name;
+}
+
+void Logger::enable_shedding(const SheddingOptions &options) {
+    if (!shedder_) {
+        shedder_ = std::make_unique<detail::Shedder>(options);
+    } else {
+        shedder_->set_options(options);
+    }
+    shedding_enabled_.store(true);
+}
+
+void Logger::disable_shedding() {
+    shedding_enabled_.store(false);
+    shed_floor_.store(0);
+    if (shedder_) {
+        shedder_->reset();
+    }
+}
+
+std::uint64_t Logger::shed(LogLevel level) const {
+    return shedder_ ? shedder_->shed(level) : 0;
+}
+
+LogLevel Logger::effective_level() const {
+    return std::max(
+        level_.load(std::memory_order_relaxed),
+        static_cast<LogLevel>(
+            std::min(shed_floor_.load(std::memory_order_relaxed), 2)
+        )
+    );
+}
+
+void Logger::enable_time_index(const TimeIndexOptions &options) {
+    std::unique_lock lock(mutex_);
+    if (!std::holds_alternative<std::ofstream>(dest_)) {
+        throw std::runtime_error("Time index needs a private log file");
+    }
+
+    // every write is flushed, so the size on disk is the end of the log
+    struct stat st{};
+    if (stat(path_.c_str(), &st) != 0) {
+        throw std::runtime_error("Cannot stat log file: " + path_);
+    }
+    indexer_.reset();
+    indexer_ = std::make_unique<detail::Indexer>(
+        path_, static_cast<std::uint64_t>(st.st_size), options
+    );
+}
+
+void Logger::disable_time_index() {
+    std::unique_lock lock(mutex_);
+    indexer_.reset();
+}
+
+void Logger::note_shed(LogLevel level) {
+    shedder_->count(level);
+    refresh_shedding();
+}
+
+void Logger::refresh_shedding() {
+    if (!shedding_enabled_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (shedder_->due(now)) {
+        std::size_t backlog = 0;
+        {
+            std::shared_lock async(async_mutex_);
+            backlog = lanes_ ? lanes_->backlog() : 0;
+        }
+        shed_floor_.store(
+            shedder_->evaluate(now, backlog), std::memory_order_relaxed
+        );
+    }
+}
+
+void Logger::update_shedding() {
+    if (!shedding_enabled_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    refresh_shedding();
+    if (auto report = shedder_->take_report()) {
+        log(*report, LogLevel::INFO);
+    }
+}
+
+void Logger::set_level(LogLevel level) {
+    level_.store(level, std::memory_order_relaxed);
+}
+
+LogLevel Logger::get_level() const {
+    return level_.load(std::memory_order_relaxed);
+}
+
+std::string Logger::get_current_timestamp() {
+    return format_timestamp(current_time_ms());
 }
 
 }  // namespace loggerlib
\ No newline at end of file
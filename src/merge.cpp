@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <loggerlib/merge.hpp>
+#include <utility>
+
+namespace loggerlib {
+
+namespace {
+
+bool parse_number(std::string_view text, int &value) {
+    value = 0;
+    for (char ch : text) {
+        if (ch < '0' || ch > '9') {
+            return false;
+        }
+        value = value * 10 + (ch - '0');
+    }
+    return !text.empty();
+}
+
+}  // namespace
+
+namespace merge {
+
+std::optional<std::int64_t> LineClock::timestamp_ms(std::string_view line) {
+    if (line.size() < 21 || line[0] != '[' || line[20] != ']') {
+        return std::nullopt;
+    }
+    std::string_view text = line.substr(1, 19);
+
+    if (text.compare(0, 13, hour_) != 0) {
+        int fields[4];
+        if (text[4] != '-' || text[7] != '-' || text[10] != ' ' ||
+            !parse_number(text.substr(0, 4), fields[0]) ||
+            !parse_number(text.substr(5, 2), fields[1]) ||
+            !parse_number(text.substr(8, 2), fields[2]) ||
+            !parse_number(text.substr(11, 2), fields[3])) {
+            return std::nullopt;
+        }
+        std::tm tm{};
+        tm.tm_year = fields[0] - 1900;
+        tm.tm_mon = fields[1] - 1;
+        tm.tm_mday = fields[2];
+        tm.tm_hour = fields[3];
+        tm.tm_isdst = -1;
+        hour_ = text.substr(0, 13);
+        hour_start_ = static_cast<std::int64_t>(std::mktime(&tm));
+    }
+
+    int minutes = 0;
+    int seconds = 0;
+    if (text[13] != ':' || text[16] != ':' ||
+        !parse_number(text.substr(14, 2), minutes) ||
+        !parse_number(text.substr(17, 2), seconds)) {
+        return std::nullopt;
+    }
+    return (hour_start_ + minutes * 60 + seconds) * 1000;
+}
+
+void LineSplitter::feed(const char *data, std::size_t size) {
+    // drop consumed input before it grows
+    if (input_pos_ > 0 && input_pos_ >= input_.size() / 2) {
+        input_.erase(0, input_pos_);
+        input_pos_ = 0;
+    }
+    input_.append(data, size);
+}
+
+bool LineSplitter::next(Entry &entry) {
+    const char *pos = input_.data() + input_pos_;
+    const auto *eol = static_cast<const char *>(
+        std::memchr(pos, '\n', input_.size() - input_pos_)
+    );
+    if (!eol) {
+        return false;
+    }
+    auto length = static_cast<std::size_t>(eol - pos) + 1;
+    make_entry(std::string_view(pos, length), entry);
+    input_pos_ += length;
+    return true;
+}
+
+bool LineSplitter::finish(Entry &entry) {
+    if (input_pos_ == input_.size()) {
+        return false;
+    }
+    input_ += '\n';
+    return next(entry);
+}
+
+void LineSplitter::make_entry(std::string_view line, Entry &entry) {
+    if (auto ts = clock_.timestamp_ms(line)) {
+        last_ts_ = *ts;
+    }
+    entry.timestamp_ms = last_ts_;
+    entry.seq = seq_++;
+    entry.text.assign(line);
+}
+
+}  // namespace merge
+
+Merger::Merger(MergeOptions options) : options_(options) {}
+
+std::size_t Merger::add_stream() {
+    std::size_t stream;
+    if (!free_.empty()) {
+        stream = free_.back();
+        free_.pop_back();
+        streams_[stream] = Stream();
+    } else {
+        stream = streams_.size();
+        streams_.emplace_back();
+    }
+    streams_[stream].open = true;
+    watermark_dirty_ = true;
+    return stream;
+}
+
+void Merger::push(std::size_t stream, merge::Entry entry) {
+    auto later = [this](auto lhs, auto rhs) { return before(rhs, lhs); };
+    Stream &s = streams_[stream];
+    if (entry.timestamp_ms > s.newest_ts) {
+        s.newest_ts = entry.timestamp_ms;
+        watermark_dirty_ = true;
+    }
+    ++pending_;
+
+    if (s.entries.empty()) {
+        s.entries.push_back(std::move(entry));
+        heap_.push_back(stream);
+        std::push_heap(heap_.begin(), heap_.end(), later);
+        return;
+    }
+
+    // usually in order, so searched from the back
+    auto it = s.entries.end();
+    while (it != s.entries.begin()) {
+        auto prev = std::prev(it);
+        if (prev->timestamp_ms < entry.timestamp_ms ||
+            (prev->timestamp_ms == entry.timestamp_ms &&
+             prev->seq <= entry.seq)) {
+            break;
+        }
+        it = prev;
+    }
+    bool new_front = it == s.entries.begin();
+    s.entries.insert(it, std::move(entry));
+    if (new_front) {
+        std::make_heap(heap_.begin(), heap_.end(), later);
+    }
+}
+
+void Merger::close_stream(std::size_t stream) {
+    Stream &s = streams_[stream];
+    s.open = false;
+    watermark_dirty_ = true;
+    if (s.entries.empty()) {
+        free_.push_back(stream);
+    }
+}
+
+void Merger::advance(std::int64_t now_ms) {
+    if (now_ms > clock_) {
+        clock_ = now_ms;
+        watermark_dirty_ = true;
+    }
+}
+
+bool Merger::pop(merge::Entry &entry) {
+    if (heap_.empty() ||
+        streams_[heap_.front()].entries.front().timestamp_ms >= watermark()) {
+        return false;
+    }
+    take_front(entry);
+    return true;
+}
+
+bool Merger::pop_any(merge::Entry &entry) {
+    if (heap_.empty()) {
+        return false;
+    }
+    take_front(entry);
+    return true;
+}
+
+std::optional<std::size_t> Merger::lagging() const {
+    std::optional<std::size_t> result;
+    for (std::size_t i = 0; i < streams_.size(); ++i) {
+        if (streams_[i].open &&
+            (!result || streams_[i].newest_ts < streams_[*result].newest_ts)) {
+            result = i;
+        }
+    }
+    return result;
+}
+
+bool Merger::before(std::size_t lhs, std::size_t rhs) const {
+    auto lhs_ts = streams_[lhs].entries.front().timestamp_ms;
+    auto rhs_ts = streams_[rhs].entries.front().timestamp_ms;
+    return lhs_ts < rhs_ts || (lhs_ts == rhs_ts && lhs < rhs);
+}
+
+std::int64_t Merger::watermark() const {
+    if (!watermark_dirty_) {
+        return watermark_;
+    }
+    watermark_ = std::numeric_limits<std::int64_t>::max();
+    for (const auto &s : streams_) {
+        if (!s.open) {
+            continue;
+        }
+        auto newest = std::max(s.newest_ts, clock_);
+        watermark_ = std::min(
+            watermark_, newest == merge::NO_TIMESTAMP
+                            ? newest
+                            : newest - options_.window.count()
+        );
+    }
+    watermark_dirty_ = false;
+    return watermark_;
+}
+
+void Merger::take_front(merge::Entry &entry) {
+    auto later = [this](auto lhs, auto rhs) { return before(rhs, lhs); };
+    std::pop_heap(heap_.begin(), heap_.end(), later);
+    std::size_t stream = heap_.back();
+    Stream &s = streams_[stream];
+
+    entry = std::move(s.entries.front());
+    s.entries.pop_front();
+    --pending_;
+    if (entry.timestamp_ms < last_released_) {
+        ++late_;
+    }
+    last_released_ = std::max(last_released_, entry.timestamp_ms);
+
+    if (!s.entries.empty()) {
+        std::push_heap(heap_.begin(), heap_.end(), later);
+    } else {
+        heap_.pop_back();
+        if (!s.open) {
+            free_.push_back(stream);
+        }
+    }
+}
+
+}  // namespace loggerlib
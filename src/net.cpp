@@ -0,0 +1,70 @@
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <loggerlib/net.hpp>
+#include <stdexcept>
+
+namespace loggerlib {
+
+int connect_tcp(const std::string &host, int port) {
+    int sockfd;                 // socket file descriptor
+    struct addrinfo hints;      // for getaddrinfo search
+    struct addrinfo *servinfo;  // search results
+    struct addrinfo *p;         // iterating through servinfo
+    int rv;                     // error code
+
+    memset(&hints, 0, sizeof hints);  // to prevent trash
+    hints.ai_family = AF_UNSPEC;      // ipv4 or ipv6
+    hints.ai_socktype = SOCK_STREAM;  // TCP-socket
+
+    if ((rv = getaddrinfo(
+             host.c_str(), std::to_string(port).c_str(), &hints, &servinfo
+         )) != 0) {
+        throw std::runtime_error(
+            std::string("getaddrinfo: ") + gai_strerror(rv)
+        );
+    }
+
+    // iterating in servinfo trying to create socket & connect
+    for (p = servinfo; p != NULL; p = p->ai_next) {
+        if ((sockfd = socket(p->ai_family, p->ai_socktype, p->ai_protocol)) ==
+            -1) {
+            continue;
+        }
+
+        if (connect(sockfd, p->ai_addr, p->ai_addrlen) == -1) {
+            close(sockfd);
+            continue;
+        }
+
+        break;
+    }
+
+    freeaddrinfo(servinfo);
+
+    // couldn't connect by no address in servinfo
+    if (p == NULL) {
+        throw std::runtime_error("Socket connection failed");
+    }
+    return sockfd;
+}
+
+bool send_all(int sockfd, const char *data, std::size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(sockfd, data, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+}  // namespace loggerlib
@@ -0,0 +1,33 @@
+#include <loggerlib/pattern.hpp>
+
+namespace loggerlib {
+
+namespace {
+
+// pattern::compile() target growing as needed
+struct DynamicProgram {
+    std::vector<pattern::Op> &ops;
+    std::string &text;
+
+    void push_op(pattern::Op op) {
+        ops.push_back(op);
+    }
+    void push_char(char ch) {
+        text.push_back(ch);
+    }
+    char char_at(std::size_t pos) const {
+        return text[pos];
+    }
+    std::size_t text_size() const {
+        return text.size();
+    }
+};
+
+}  // namespace
+
+Pattern::Pattern(std::string_view pattern) : pattern_(pattern) {
+    DynamicProgram program{ops_, text_};
+    pattern::compile(pattern_, program);
+}
+
+}  // namespace loggerlib
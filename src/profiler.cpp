@@ -0,0 +1,199 @@
+#include <loggerlib/profiler.hpp>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <thread>
+
+namespace loggerlib {
+
+namespace detail {
+
+std::atomic<bool> profiling_enabled{false};
+
+}  // namespace detail
+
+namespace {
+
+struct SiteRecord {
+    enum State { EMPTY = 0, CLAIMED, READY };
+
+    std::atomic<int> state{EMPTY};
+    const char *file = nullptr;  // key: string literal pointers and line
+    std::uint32_t line = 0;
+    std::uint32_t column = 0;
+    const char *function = nullptr;
+
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> filtered{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::uint64_t> cycles{0};
+};
+
+// Open addressing, sites are never removed. Sites beyond the capacity share
+// the overflow record.
+constexpr std::size_t SITE_TABLE_SIZE = 4096;
+
+std::array<SiteRecord, SITE_TABLE_SIZE> sites;
+SiteRecord overflow_site;
+
+bool same_site(const SiteRecord &record, const SourceLocation &location) {
+    return record.file == location.file && record.line == location.line &&
+           record.column == location.column;
+}
+
+SiteRecord &intern(const SourceLocation &location) {
+    auto hash = reinterpret_cast<std::uintptr_t>(location.file) ^
+                (std::uintptr_t{location.line} * 0x9E3779B97F4A7C15ull) ^
+                location.column;
+    for (std::size_t probe = 0; probe < SITE_TABLE_SIZE; ++probe) {
+        auto &record = sites[(hash + probe) % SITE_TABLE_SIZE];
+
+        int state = record.state.load(std::memory_order_acquire);
+        if (state == SiteRecord::EMPTY &&
+            record.state.compare_exchange_strong(
+                state, SiteRecord::CLAIMED, std::memory_order_acquire
+            )) {
+            record.file = location.file;
+            record.line = location.line;
+            record.column = location.column;
+            record.function = location.function;
+            record.state.store(SiteRecord::READY, std::memory_order_release);
+            return record;
+        }
+
+        // another thread is filling the slot in, it takes a few stores
+        while (state == SiteRecord::CLAIMED) {
+            std::this_thread::yield();
+            state = record.state.load(std::memory_order_acquire);
+        }
+        if (same_site(record, location)) {
+            return record;
+        }
+    }
+    return overflow_site;
+}
+
+CallSite snapshot(const SiteRecord &record) {
+    return CallSite{
+        record.file ? record.file : "(other)",
+        record.line,
+        record.function ? record.function : "",
+        record.calls.load(std::memory_order_relaxed),
+        record.filtered.load(std::memory_order_relaxed),
+        record.bytes.load(std::memory_order_relaxed),
+        record.cycles.load(std::memory_order_relaxed),
+    };
+}
+
+}  // namespace
+
+void Profiler::enable() {
+    detail::profiling_enabled.store(true);
+}
+
+void Profiler::disable() {
+    detail::profiling_enabled.store(false);
+}
+
+void Profiler::reset() {
+    auto zero = [](SiteRecord &record) {
+        record.calls.store(0);
+        record.filtered.store(0);
+        record.bytes.store(0);
+        record.cycles.store(0);
+    };
+    for (auto &record : sites) {
+        zero(record);
+    }
+    zero(overflow_site);
+}
+
+std::vector<CallSite> Profiler::top(std::size_t count) {
+    std::vector<CallSite> result;
+    for (const auto &record : sites) {
+        if (record.state.load(std::memory_order_acquire) != SiteRecord::READY) {
+            continue;
+        }
+
+        // a header's site has one record per translation unit
+        auto site = snapshot(record);
+        auto same = std::find_if(result.begin(), result.end(), [&](const auto &s) {
+            return s.line == site.line && s.file == site.file;
+        });
+        if (same == result.end()) {
+            result.push_back(std::move(site));
+        } else {
+            same->calls += site.calls;
+            same->filtered += site.filtered;
+            same->bytes += site.bytes;
+            same->cycles += site.cycles;
+        }
+    }
+    auto other = snapshot(overflow_site);
+    if (other.calls + other.filtered > 0) {
+        result.push_back(std::move(other));
+    }
+
+    std::sort(result.begin(), result.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.cycles != rhs.cycles ? lhs.cycles > rhs.cycles
+                                        : lhs.calls > rhs.calls;
+    });
+    result.erase(
+        std::remove_if(
+            result.begin(), result.end(),
+            [](const auto &site) { return site.calls + site.filtered == 0; }
+        ),
+        result.end()
+    );
+    if (result.size() > count) {
+        result.resize(count);
+    }
+    return result;
+}
+
+void Profiler::report(std::ostream &out, std::size_t count) {
+    out << std::setw(14) << "cycles" << std::setw(10) << "calls"
+        << std::setw(10) << "filtered" << std::setw(12) << "bytes"
+        << std::setw(10) << "cyc/call"
+        << "  site\n";
+    for (const auto &site : top(count)) {
+        out << std::setw(14) << site.cycles << std::setw(10) << site.calls
+            << std::setw(10) << site.filtered << std::setw(12) << site.bytes
+            << std::setw(10) << (site.calls ? site.cycles / site.calls : 0)
+            << "  " << site.file << ':' << site.line << ' ' << site.function
+            << '\n';
+    }
+}
+
+void Profiler::record_filtered(const SourceLocation &location) {
+    intern(location).filtered.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Profiler::record_call(
+    const SourceLocation &location,
+    std::size_t bytes,
+    std::uint64_t cycles
+) {
+    auto &record = intern(location);
+    record.calls.fetch_add(1, std::memory_order_relaxed);
+    record.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    record.cycles.fetch_add(cycles, std::memory_order_relaxed);
+}
+
+std::uint64_t Profiler::cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()
+    )
+        .count();
+#endif
+}
+
+}  // namespace loggerlib
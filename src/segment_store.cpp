@@ -0,0 +1,531 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <filesystem>
+#include <loggerlib/io.hpp>
+#include <loggerlib/segment_store.hpp>
+#include <stdexcept>
+#include <utility>
+
+namespace loggerlib {
+
+namespace {
+
+constexpr std::int64_t MINUTE_MS = 60 * 1000;
+constexpr std::size_t TRAILER_SIZE = 8;
+
+std::int64_t minute_of(std::int64_t timestamp_ms) {
+    // rounds down for times before the epoch too
+    return timestamp_ms / MINUTE_MS -
+           (timestamp_ms % MINUTE_MS < 0 ? 1 : 0);
+}
+
+bool read_at(int fd, char *data, std::size_t size, std::uint64_t offset) {
+    while (size > 0) {
+        ssize_t got = pread(fd, data, size, static_cast<off_t>(offset));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        data += got;
+        size -= static_cast<std::size_t>(got);
+        offset += static_cast<std::uint64_t>(got);
+    }
+    return true;
+}
+
+std::string read_file(int fd) {
+    struct stat st{};
+    if (fstat(fd, &st) != 0) {
+        throw std::runtime_error("Cannot stat segment");
+    }
+    std::string data(static_cast<std::size_t>(st.st_size), '\0');
+    if (!read_at(fd, data.data(), data.size(), 0)) {
+        throw std::runtime_error("Cannot read segment");
+    }
+    return data;
+}
+
+// Footer body, without the trailer. Returns the data end.
+std::optional<std::uint64_t>
+parse_footer(std::string_view body, SegmentSummary &summary) {
+    if (body.empty() ||
+        static_cast<std::uint8_t>(body[0]) != segment::VERSION) {
+        return std::nullopt;
+    }
+    const char *pos = body.data() + 1;
+    const char *end = body.data() + body.size();
+
+    std::uint64_t data_end;
+    std::uint64_t min_ms;
+    std::uint64_t max_ms;
+    std::uint64_t minutes;
+    if (!wire::get_varint(pos, end, data_end) ||
+        !wire::get_varint(pos, end, summary.records) ||
+        !wire::get_varint(pos, end, summary.levels[0]) ||
+        !wire::get_varint(pos, end, summary.levels[1]) ||
+        !wire::get_varint(pos, end, summary.levels[2]) ||
+        !wire::get_varint(pos, end, min_ms) ||
+        !wire::get_varint(pos, end, max_ms) ||
+        !wire::get_varint(pos, end, summary.bytes) ||
+        !wire::get_varint(pos, end, summary.min_length) ||
+        !wire::get_varint(pos, end, summary.max_length) ||
+        !wire::get_varint(pos, end, minutes)) {
+        return std::nullopt;
+    }
+    summary.min_ms = wire::unzigzag(min_ms);
+    summary.max_ms = wire::unzigzag(max_ms);
+
+    std::int64_t minute = 0;
+    for (std::uint64_t i = 0; i < minutes; ++i) {
+        std::uint64_t delta;
+        std::uint64_t count;
+        if (!wire::get_varint(pos, end, delta) ||
+            !wire::get_varint(pos, end, count)) {
+            return std::nullopt;
+        }
+        minute += wire::unzigzag(delta);
+        summary.minutes.emplace_hint(summary.minutes.end(), minute, count);
+    }
+    return data_end;
+}
+
+// Decode whole frames of segment data from HEADER_SIZE up to end. Returns
+// where the frames stop: at end, or before a torn or malformed frame.
+template <typename OnRecord>
+std::uint64_t
+scan_frames(std::string_view data, std::uint64_t end, OnRecord on_record) {
+    wire::Decoder decoder;
+    wire::Record record;
+    std::vector<wire::Record> frame_records;
+    std::uint64_t pos = segment::HEADER_SIZE;
+    while (pos + wire::FRAME_HEADER_SIZE <= end) {
+        std::uint64_t length = wire::get_u32_le(data.data() + pos);
+        if (length == 0 || length > wire::MAX_FRAME_SIZE ||
+            pos + 4 + length > end) {
+            break;
+        }
+        decoder.feed(data.data() + pos, static_cast<std::size_t>(4 + length));
+        frame_records.clear();
+        try {
+            while (decoder.next(record)) {
+                frame_records.push_back(std::move(record));
+            }
+        } catch (const std::runtime_error &) {
+            break;
+        }
+        for (auto &frame_record : frame_records) {
+            on_record(frame_record);
+        }
+        pos += 4 + length;
+    }
+    return pos;
+}
+
+}  // namespace
+
+void SegmentSummary::add(
+    LogLevel level,
+    std::int64_t timestamp_ms,
+    std::size_t length
+) {
+    ++records;
+    ++levels[static_cast<int>(level)];
+    min_ms = std::min(min_ms, timestamp_ms);
+    max_ms = std::max(max_ms, timestamp_ms);
+    bytes += length;
+    min_length = std::min<std::uint64_t>(min_length, length);
+    max_length = std::max<std::uint64_t>(max_length, length);
+
+    // records come mostly in time order, so the last minute is tried first
+    std::int64_t minute = minute_of(timestamp_ms);
+    if (!minutes.empty() && std::prev(minutes.end())->first == minute) {
+        ++std::prev(minutes.end())->second;
+    } else {
+        ++minutes[minute];
+    }
+}
+
+void SegmentSummary::merge(const SegmentSummary &other) {
+    records += other.records;
+    for (std::size_t i = 0; i < levels.size(); ++i) {
+        levels[i] += other.levels[i];
+    }
+    min_ms = std::min(min_ms, other.min_ms);
+    max_ms = std::max(max_ms, other.max_ms);
+    bytes += other.bytes;
+    min_length = std::min(min_length, other.min_length);
+    max_length = std::max(max_length, other.max_length);
+    for (const auto &[minute, count] : other.minutes) {
+        minutes[minute] += count;
+    }
+}
+
+std::uint64_t SegmentSummary::since(std::int64_t from_ms) const {
+    std::uint64_t count = 0;
+    for (auto it = minutes.lower_bound(minute_of(from_ms)); it != minutes.end();
+         ++it) {
+        count += it->second;
+    }
+    return count;
+}
+
+namespace segment {
+
+std::string make_header() {
+    std::string out(MAGIC, sizeof(MAGIC));
+    out.push_back(static_cast<char>(VERSION));
+    out.append(3, '\0');
+    return out;
+}
+
+std::string make_footer(std::uint64_t data_end, const SegmentSummary &summary) {
+    std::string body;
+    body.push_back(static_cast<char>(VERSION));
+    wire::put_varint(body, data_end);
+    wire::put_varint(body, summary.records);
+    for (auto count : summary.levels) {
+        wire::put_varint(body, count);
+    }
+    wire::put_varint(body, wire::zigzag(summary.min_ms));
+    wire::put_varint(body, wire::zigzag(summary.max_ms));
+    wire::put_varint(body, summary.bytes);
+    wire::put_varint(body, summary.min_length);
+    wire::put_varint(body, summary.max_length);
+    wire::put_varint(body, summary.minutes.size());
+    std::int64_t minute = 0;
+    for (const auto &[next, count] : summary.minutes) {
+        wire::put_varint(body, wire::zigzag(next - minute));
+        wire::put_varint(body, count);
+        minute = next;
+    }
+
+    wire::put_u32_le(body, static_cast<std::uint32_t>(body.size()));
+    body.append(FOOTER_MAGIC, sizeof(FOOTER_MAGIC));
+    return body;
+}
+
+std::optional<SegmentSummary> read_footer(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return std::nullopt;
+    }
+    struct stat st{};
+    char trailer[TRAILER_SIZE];
+    std::optional<SegmentSummary> result;
+    if (fstat(fd, &st) == 0 &&
+        static_cast<std::uint64_t>(st.st_size) >= HEADER_SIZE + TRAILER_SIZE &&
+        read_at(fd, trailer, TRAILER_SIZE, st.st_size - TRAILER_SIZE) &&
+        std::equal(trailer + 4, trailer + 8, FOOTER_MAGIC)) {
+        auto size = static_cast<std::uint64_t>(st.st_size);
+        std::uint64_t length = wire::get_u32_le(trailer);
+        std::string body(static_cast<std::size_t>(length), '\0');
+        SegmentSummary summary;
+        if (length <= size - HEADER_SIZE - TRAILER_SIZE &&
+            read_at(fd, body.data(), body.size(),
+                    size - TRAILER_SIZE - length)) {
+            auto data_end = parse_footer(body, summary);
+            if (data_end && *data_end + length + TRAILER_SIZE == size) {
+                result = std::move(summary);
+            }
+        }
+    }
+    close(fd);
+    return result;
+}
+
+std::vector<wire::Record> read(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        throw std::runtime_error("Cannot open segment: " + path);
+    }
+    std::string data;
+    try {
+        data = read_file(fd);
+    } catch (const std::runtime_error &) {
+        close(fd);
+        throw std::runtime_error("Cannot read segment: " + path);
+    }
+    close(fd);
+    if (data.size() < HEADER_SIZE || data.compare(0, 4, MAGIC, 4) != 0 ||
+        static_cast<std::uint8_t>(data[4]) != VERSION) {
+        throw std::runtime_error("Not a segment: " + path);
+    }
+
+    // a sealed segment is read up to its footer
+    std::uint64_t end = data.size();
+    if (data.size() >= HEADER_SIZE + TRAILER_SIZE &&
+        data.compare(data.size() - 4, 4, FOOTER_MAGIC, 4) == 0) {
+        std::uint64_t length = wire::get_u32_le(data.data() + data.size() - 8);
+        SegmentSummary summary;
+        if (length <= data.size() - HEADER_SIZE - TRAILER_SIZE) {
+            auto data_end = parse_footer(
+                std::string_view(data).substr(
+                    data.size() - TRAILER_SIZE - length, length
+                ),
+                summary
+            );
+            if (data_end && *data_end + length + TRAILER_SIZE == data.size()) {
+                end = *data_end;
+            }
+        }
+    }
+
+    std::vector<wire::Record> records;
+    scan_frames(data, end, [&records](wire::Record &record) {
+        records.push_back(std::move(record));
+    });
+    return records;
+}
+
+}  // namespace segment
+
+SegmentStore::SegmentStore(std::string dir, SegmentStoreOptions options)
+    : dir_(std::move(dir)),
+      options_(options),
+      encoder_(options.compression) {
+    std::error_code error;
+    std::filesystem::create_directories(dir_, error);
+    if (error) {
+        throw std::runtime_error("Cannot create segment directory: " + dir_);
+    }
+
+    for (const auto &path : segments()) {
+        auto summary = segment::read_footer(path);
+        if (!summary) {
+            // left open by a crash: cut after the last whole frame and seal
+            int fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+            if (fd == -1) {
+                throw std::runtime_error("Cannot open segment: " + path);
+            }
+            summary.emplace();
+            std::uint64_t end = segment::HEADER_SIZE;
+            try {
+                std::string data = read_file(fd);
+                if (data.size() >= segment::HEADER_SIZE &&
+                    data.compare(0, 4, segment::MAGIC, 4) == 0) {
+                    end = scan_frames(
+                        data, data.size(),
+                        [&summary](const wire::Record &record) {
+                            summary->add(
+                                record.level, record.timestamp_ms,
+                                record.message.size()
+                            );
+                        }
+                    );
+                }
+            } catch (const std::runtime_error &) {
+                close(fd);
+                throw std::runtime_error("Cannot read segment: " + path);
+            }
+            std::string footer = segment::make_footer(end, *summary);
+            bool sealed =
+                ftruncate(fd, static_cast<off_t>(end)) == 0 &&
+                pwrite(fd, footer.data(), footer.size(), static_cast<off_t>(end)
+                ) == static_cast<ssize_t>(footer.size()) &&
+                (options_.fsync == FsyncPolicy::NEVER || fsync(fd) == 0);
+            close(fd);
+            if (!sealed) {
+                throw std::runtime_error("Cannot seal segment: " + path);
+            }
+        }
+        sealed_.merge(*summary);
+
+        auto name = std::filesystem::path(path).stem().string();
+        number_ = std::max<std::uint64_t>(number_, std::stoull(name));
+    }
+    seq_ = sealed_.records;
+
+    open_segment();
+}
+
+SegmentStore::~SegmentStore() {
+    std::unique_lock lock(mutex_);
+    committed_cv_.wait(lock, [this]() { return !committing_; });
+    try {
+        if (!failed_ && pending_.records > 0) {
+            commit(lock);
+        }
+    } catch (const std::runtime_error &) {
+        // the last batch is lost, the segment is sealed with what it has
+    }
+
+    // no descriptor if sealing or creating the next segment failed, the
+    // next start seals what the file holds
+    if (fd_ == -1) {
+        return;
+    }
+    // a segment without frames is not kept
+    if (written_ <= segment::HEADER_SIZE) {
+        close(fd_);
+        std::remove(segment_path(number_).c_str());
+        return;
+    }
+    try {
+        seal_segment(segment_);
+    } catch (const std::runtime_error &) {
+        // sealed on the next start
+    }
+}
+
+void SegmentStore::append(std::vector<wire::Record> records) {
+    std::unique_lock lock(mutex_);
+    if (failed_) {
+        throw std::runtime_error("Segment store failed");
+    }
+    for (auto &record : records) {
+        record.seq = ++seq_;
+        encoder_.add(record);
+        pending_.add(record.level, record.timestamp_ms, record.message.size());
+    }
+
+    // the records go with the next commit; whoever finds no commit running
+    // writes it, together with records appended meanwhile
+    std::uint64_t ticket = next_commit_;
+    while (committed_ < ticket) {
+        if (failed_) {
+            throw std::runtime_error("Segment store failed");
+        }
+        if (committing_) {
+            committed_cv_.wait(lock);
+        } else {
+            commit(lock);
+        }
+    }
+}
+
+void SegmentStore::commit(std::unique_lock<std::mutex> &lock) {
+    std::string frame = encoder_.finish();
+    std::uint64_t commit_number = next_commit_++;
+    writing_ = std::move(pending_);
+    pending_ = SegmentSummary();
+
+    // the frame that crosses segment_size ends the segment, deltas of the
+    // records appended meanwhile restart for the next one. The summaries
+    // move on only once the frame is written and the segment sealed.
+    std::optional<SegmentSummary> full;
+    if (segment_bytes_ + frame.size() + segment::HEADER_SIZE >=
+        options_.segment_size) {
+        full = segment_;
+        full->merge(writing_);
+        encoder_ = wire::Encoder(options_.compression);
+    }
+    committing_ = true;
+    lock.unlock();
+
+    bool written = false;
+    bool sealed = false;
+    bool ok = false;
+    try {
+        written = write_all(fd_, frame.data(), frame.size());
+        if (written) {
+            written_ += frame.size();
+        }
+        ok = written && (options_.fsync != FsyncPolicy::COMMIT ||
+                         fdatasync(fd_) == 0);
+        if (ok && full) {
+            seal_segment(*full);
+            sealed = true;
+            open_segment();
+        }
+    } catch (const std::runtime_error &) {
+        ok = false;
+    }
+
+    lock.lock();
+    if (sealed) {
+        sealed_.merge(*full);
+        segment_ = SegmentSummary();
+        segment_bytes_ = 0;
+    } else if (written) {
+        segment_.merge(writing_);
+        segment_bytes_ += frame.size();
+    }
+    writing_ = SegmentSummary();
+    committing_ = false;
+    committed_ = commit_number;
+    failed_ = failed_ || !ok;
+    committed_cv_.notify_all();
+    if (!ok) {
+        throw std::runtime_error(
+            "Cannot write segment: " + segment_path(number_)
+        );
+    }
+}
+
+void SegmentStore::open_segment() {
+    ++number_;
+    written_ = 0;
+    std::string path = segment_path(number_);
+    fd_ = open(
+        path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644
+    );
+    std::string header = segment::make_header();
+    if (fd_ == -1 || !write_all(fd_, header.data(), header.size())) {
+        throw std::runtime_error("Cannot create segment: " + path);
+    }
+    written_ = header.size();
+    if (options_.fsync != FsyncPolicy::NEVER) {
+        sync_dir();
+    }
+}
+
+void SegmentStore::seal_segment(const SegmentSummary &summary) {
+    std::string footer = segment::make_footer(written_, summary);
+    bool ok = write_all(fd_, footer.data(), footer.size()) &&
+              (options_.fsync == FsyncPolicy::NEVER || fsync(fd_) == 0);
+    close(fd_);
+    fd_ = -1;
+    if (!ok) {
+        throw std::runtime_error(
+            "Cannot seal segment: " + segment_path(number_)
+        );
+    }
+}
+
+void SegmentStore::sync_dir() {
+    int fd = open(dir_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd != -1) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+SegmentSummary SegmentStore::summary() const {
+    std::lock_guard lock(mutex_);
+    SegmentSummary result = sealed_;
+    result.merge(segment_);
+    result.merge(writing_);
+    result.merge(pending_);
+    return result;
+}
+
+std::vector<std::string> SegmentStore::segments() const {
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto &file : std::filesystem::directory_iterator(dir_, error)) {
+        auto name = file.path().filename().string();
+        if (name.size() == 16 && name.compare(12, 4, ".seg") == 0 &&
+            name.find_first_not_of("0123456789") == 12) {
+            paths.push_back(file.path().string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+std::string SegmentStore::segment_path(std::uint64_t number) const {
+    char name[32];
+    std::snprintf(
+        name, sizeof(name), "%012llu.seg",
+        static_cast<unsigned long long>(number)
+    );
+    return dir_ + "/" + name;
+}
+
+}  // namespace loggerlib
@@ -0,0 +1,113 @@
+#include "shedder.hpp"
+#include <algorithm>
+
+namespace loggerlib::detail {
+
+Shedder::Shedder(const SheddingOptions &options) : options_(options) {}
+
+void Shedder::set_options(const SheddingOptions &options) {
+    std::lock_guard lock(mutex_);
+    options_ = options;
+}
+
+void Shedder::reset() {
+    std::lock_guard lock(mutex_);
+    floor_ = 0;
+    calm_since_.reset();
+    window_latency_ns_.store(0);
+    has_report_.store(false);
+}
+
+void Shedder::record_write(std::chrono::steady_clock::duration latency) {
+    auto ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+    auto current = window_latency_ns_.load(std::memory_order_relaxed);
+    while (ns > current && !window_latency_ns_.compare_exchange_weak(
+                               current, ns, std::memory_order_relaxed
+                           )) {
+    }
+}
+
+void Shedder::count(LogLevel level) {
+    shed_[static_cast<int>(level)].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::uint64_t Shedder::shed(LogLevel level) const {
+    return shed_[static_cast<int>(level)].load(std::memory_order_relaxed);
+}
+
+bool Shedder::due(std::chrono::steady_clock::time_point now) {
+    auto next = next_check_.load(std::memory_order_relaxed);
+    if (now.time_since_epoch().count() < next) {
+        return false;
+    }
+
+    std::chrono::steady_clock::duration interval;
+    {
+        std::lock_guard lock(mutex_);
+        interval = options_.interval;
+    }
+    return next_check_.compare_exchange_strong(
+        next, (now + interval).time_since_epoch().count(),
+        std::memory_order_relaxed
+    );
+}
+
+int Shedder::evaluate(
+    std::chrono::steady_clock::time_point now,
+    std::size_t backlog
+) {
+    std::lock_guard lock(mutex_);
+    auto latency = std::chrono::nanoseconds(window_latency_ns_.exchange(0));
+
+    bool pressure = latency > options_.latency_budget ||
+                    backlog > options_.backlog_budget;
+    bool calm = latency.count() <=
+                    options_.recovery_ratio *
+                        std::chrono::nanoseconds(options_.latency_budget).count() &&
+                backlog <= options_.recovery_ratio * options_.backlog_budget;
+
+    if (pressure) {
+        calm_since_.reset();
+        if (floor_ == 0) {
+            episode_start_ = now;
+            for (std::size_t i = 0; i < shed_.size(); ++i) {
+                episode_shed_[i] = shed_[i].load(std::memory_order_relaxed);
+            }
+        }
+        floor_ = std::min(floor_ + 1, 2);
+    } else if (!calm || floor_ == 0) {
+        calm_since_.reset();
+    } else if (!calm_since_) {
+        calm_since_ = now;
+    } else if (now - *calm_since_ >= options_.recovery) {
+        calm_since_ = now;
+        if (--floor_ == 0) {
+            auto lasted = std::chrono::duration_cast<std::chrono::milliseconds>(
+                now - episode_start_
+            );
+            report_ = "Load shedding ended after " +
+                      std::to_string(lasted.count()) + " ms: shed " +
+                      std::to_string(shed(LogLevel::DEBUG) - episode_shed_[0]) +
+                      " DEBUG, " +
+                      std::to_string(shed(LogLevel::INFO) - episode_shed_[1]) +
+                      " INFO messages";
+            has_report_.store(true, std::memory_order_release);
+        }
+    }
+    return floor_;
+}
+
+std::optional<std::string> Shedder::take_report() {
+    if (!has_report_.load(std::memory_order_acquire)) {
+        return std::nullopt;
+    }
+
+    std::lock_guard lock(mutex_);
+    if (!has_report_.exchange(false)) {
+        return std::nullopt;
+    }
+    return std::move(report_);
+}
+
+}  // namespace loggerlib::detail
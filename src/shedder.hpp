@@ -0,0 +1,58 @@
+#ifndef LOGGERLIB_SRC_SHEDDER_HPP_
+#define LOGGERLIB_SRC_SHEDDER_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <loggerlib/level.hpp>
+#include <loggerlib/shedding.hpp>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace loggerlib::detail {
+
+// Load shedding controller. Levels below floor() are shed: 0 - none,
+// 1 - DEBUG, 2 - DEBUG and INFO.
+class Shedder {
+public:
+    explicit Shedder(const SheddingOptions &options);
+
+    void set_options(const SheddingOptions &options);
+    // Back to no shedding, counters are kept
+    void reset();
+
+    void record_write(std::chrono::steady_clock::duration latency);
+    void count(LogLevel level);
+    std::uint64_t shed(LogLevel level) const;
+
+    // Whether an interval passed since the last evaluate(), true for one
+    // caller only
+    bool due(std::chrono::steady_clock::time_point now);
+    // Check the pressure of the past interval, returns the new floor
+    int evaluate(std::chrono::steady_clock::time_point now, std::size_t backlog);
+
+    // Summary of the episode that ended, once
+    std::optional<std::string> take_report();
+
+private:
+    mutable std::mutex mutex_;  // evaluate() against set_options()/reset()
+    SheddingOptions options_;
+
+    std::atomic<std::chrono::steady_clock::rep> next_check_{0};
+    std::atomic<std::int64_t> window_latency_ns_{0};
+    std::array<std::atomic<std::uint64_t>, 3> shed_{};
+
+    int floor_ = 0;
+    std::optional<std::chrono::steady_clock::time_point> calm_since_;
+    std::chrono::steady_clock::time_point episode_start_;
+    std::array<std::uint64_t, 3> episode_shed_{};  // shed_ at the start
+
+    std::atomic<bool> has_report_{false};
+    std::string report_;
+};
+
+}  // namespace loggerlib::detail
+
+#endif  // LOGGERLIB_SRC_SHEDDER_HPP_
@@ -0,0 +1,37 @@
+#ifndef LOGGERLIB_SRC_SOURCE_HPP_
+#define LOGGERLIB_SRC_SOURCE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace loggerlib::detail {
+
+struct Parked;
+
+// Something a Backend thread can drain, implemented by asynchronous loggers
+class Source {
+public:
+    enum State { IDLE = 0, QUEUED, RUNNING, RUNNING_AGAIN };
+
+    virtual ~Source() = default;
+
+    // Write one batch, returns true if a full batch is still waiting.
+    // Coroutines without an executor it made room for are added to
+    // resumed, to run once run_mutex is released.
+    virtual bool drain(std::vector<Parked> &resumed) = 0;
+    // Whether anything queued waits longer than the flush interval
+    virtual bool due(std::chrono::steady_clock::time_point now) const = 0;
+    virtual bool empty() const = 0;
+
+    // Queued at most once, drained by one thread at a time
+    std::atomic<int> state{IDLE};
+    // Held while draining, detach() takes it to wait for the running drain
+    std::mutex run_mutex;
+    bool detached = false;
+};
+
+}  // namespace loggerlib::detail
+
+#endif  // LOGGERLIB_SRC_SOURCE_HPP_
@@ -0,0 +1,207 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <loggerlib/io.hpp>
+#include <loggerlib/time_index.hpp>
+#include <loggerlib/wire.hpp>
+#include <stdexcept>
+#include "indexer.hpp"
+#include "lanes.hpp"
+
+namespace loggerlib {
+
+namespace time_index {
+
+std::string make_header() {
+    std::string out(MAGIC, sizeof(MAGIC));
+    out.push_back(static_cast<char>(VERSION));
+    out.append(3, '\0');
+    return out;
+}
+
+void put_entry(std::string &out, const Entry &entry) {
+    wire::put_u64_le(out, entry.offset);
+    wire::put_u64_le(out, entry.length);
+    wire::put_u64_le(out, static_cast<std::uint64_t>(entry.min_ms));
+    wire::put_u64_le(out, static_cast<std::uint64_t>(entry.max_ms));
+    out.push_back(static_cast<char>(entry.levels));
+    out.append(7, '\0');
+}
+
+std::optional<Entry> parse_entry(std::string_view data) {
+    if (data.size() < ENTRY_SIZE) {
+        return std::nullopt;
+    }
+    Entry entry;
+    entry.offset = wire::get_u64_le(data.data());
+    entry.length = wire::get_u64_le(data.data() + 8);
+    entry.min_ms =
+        static_cast<std::int64_t>(wire::get_u64_le(data.data() + 16));
+    entry.max_ms =
+        static_cast<std::int64_t>(wire::get_u64_le(data.data() + 24));
+    entry.levels = static_cast<std::uint8_t>(data[32]);
+    return entry;
+}
+
+std::optional<std::vector<Entry>> load(const std::string &log_path) {
+    std::ifstream file(sidecar_path(log_path), std::ios::binary);
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+    std::string data(
+        (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()
+    );
+    if (data.size() < HEADER_SIZE || data.compare(0, 4, MAGIC, 4) != 0 ||
+        static_cast<std::uint8_t>(data[4]) != VERSION) {
+        return std::nullopt;
+    }
+
+    std::vector<Entry> entries;
+    std::uint64_t end = 0;
+    for (std::size_t pos = HEADER_SIZE; pos + ENTRY_SIZE <= data.size();
+         pos += ENTRY_SIZE) {
+        auto entry = parse_entry(std::string_view(data).substr(pos));
+        if (entry->offset < end) {
+            return std::nullopt;
+        }
+        end = entry->offset + entry->length;
+        entries.push_back(*entry);
+    }
+    return entries;
+}
+
+std::vector<Range> lookup(
+    const std::vector<Entry> &entries,
+    std::uint64_t file_size,
+    std::int64_t from_ms,
+    std::int64_t to_ms,
+    LogLevel min_level
+) {
+    // levels at or above min_level
+    auto wanted = static_cast<std::uint8_t>(~(level_bit(min_level) - 1));
+    std::vector<Range> ranges;
+    auto add = [&](std::uint64_t offset, std::uint64_t end) {
+        end = std::min(end, file_size);
+        if (offset >= end) {
+            return;
+        }
+        if (!ranges.empty() &&
+            ranges.back().offset + ranges.back().length == offset) {
+            ranges.back().length += end - offset;
+        } else {
+            ranges.push_back(Range{offset, end - offset});
+        }
+    };
+
+    // bytes no entry covers are scanned as well
+    std::uint64_t covered = 0;
+    for (const auto &entry : entries) {
+        add(covered, entry.offset);
+        if ((entry.levels & wanted) != 0 && entry.max_ms >= from_ms &&
+            entry.min_ms < to_ms) {
+            add(entry.offset, entry.offset + entry.length);
+        }
+        covered = entry.offset + entry.length;
+    }
+    add(covered, file_size);
+    return ranges;
+}
+
+}  // namespace time_index
+
+namespace detail {
+
+Extent extent_of(const std::vector<Message> &batch) {
+    Extent extent{batch.front().timestamp_ms, batch.front().timestamp_ms, 0};
+    for (const auto &message : batch) {
+        extent.min_ms = std::min(extent.min_ms, message.timestamp_ms);
+        extent.max_ms = std::max(extent.max_ms, message.timestamp_ms);
+        extent.levels |= time_index::level_bit(message.level);
+    }
+    return extent;
+}
+
+Indexer::Indexer(
+    const std::string &log_path,
+    std::uint64_t file_size,
+    const TimeIndexOptions &options
+)
+    : options_(options), end_(file_size) {
+    options_.bucket = std::max(options_.bucket, std::chrono::milliseconds(1));
+    options_.region_bytes = std::max<std::size_t>(options_.region_bytes, 1);
+
+    // entries past the end belong to a log that was truncated or replaced
+    auto entries = time_index::load(log_path);
+    bool fresh = !entries ||
+                 (!entries->empty() &&
+                  entries->back().offset + entries->back().length > file_size);
+
+    std::string path = time_index::sidecar_path(log_path);
+    int flags = O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC;
+    fd_ = open(path.c_str(), fresh ? flags | O_TRUNC : flags, 0644);
+    if (fd_ == -1) {
+        throw std::runtime_error("Cannot open time index: " + path);
+    }
+
+    if (fresh) {
+        auto header = time_index::make_header();
+        write_all(fd_, header.data(), header.size());
+    } else {
+        // drop a torn entry
+        auto size = time_index::HEADER_SIZE +
+                    entries->size() * time_index::ENTRY_SIZE;
+        if (ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+            close(fd_);
+            throw std::runtime_error("Cannot open time index: " + path);
+        }
+    }
+}
+
+Indexer::~Indexer() {
+    close_region();
+    close(fd_);
+}
+
+std::int64_t Indexer::bucket_of(std::int64_t timestamp_ms) const {
+    auto bucket = options_.bucket.count();
+    auto index = timestamp_ms / bucket;
+    return timestamp_ms < 0 && timestamp_ms % bucket != 0 ? index - 1 : index;
+}
+
+void Indexer::add(std::uint64_t length, const Extent &extent) {
+    // a region covers one bucket, late records of a batch may reach back
+    if (open_ && (bucket_of(extent.max_ms) != region_bucket_ ||
+                  region_.length >= options_.region_bytes)) {
+        close_region();
+    }
+
+    if (!open_) {
+        region_ = time_index::Entry{
+            end_, 0, extent.min_ms, extent.max_ms, extent.levels
+        };
+        region_bucket_ = bucket_of(extent.max_ms);
+        open_ = true;
+    } else {
+        region_.min_ms = std::min(region_.min_ms, extent.min_ms);
+        region_.max_ms = std::max(region_.max_ms, extent.max_ms);
+        region_.levels |= extent.levels;
+    }
+    region_.length += length;
+    end_ += length;
+}
+
+void Indexer::close_region() {
+    if (!open_) {
+        return;
+    }
+    entry_.clear();
+    time_index::put_entry(entry_, region_);
+    write_all(fd_, entry_.data(), entry_.size());
+    open_ = false;
+}
+
+}  // namespace detail
+
+}  // namespace loggerlib
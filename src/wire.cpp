@@ -0,0 +1,276 @@
+#include <cstring>
+#include <loggerlib/wire.hpp>
+#include <stdexcept>
+#include <vector>
+
+namespace loggerlib::wire {
+
+namespace {
+
+// LZ77 parameters
+constexpr std::size_t MIN_MATCH = 4;
+constexpr std::size_t HASH_BITS = 12;
+constexpr std::size_t MAX_OFFSET = 64 * 1024;
+
+// Don't try to compress tiny batches
+constexpr std::size_t MIN_COMPRESS_SIZE = 256;
+
+std::uint32_t read_u32(const char *p) {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+std::uint32_t hash4(const char *p) {
+    return (read_u32(p) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+}  // namespace
+
+std::string make_hello(const Hello &hello) {
+    std::string out(MAGIC, sizeof(MAGIC));
+    out.push_back(static_cast<char>(hello.version));
+    out.push_back(static_cast<char>(hello.flags));
+    return out;
+}
+
+std::optional<Hello> parse_hello(std::string_view data) {
+    if (data.size() < HELLO_SIZE ||
+        std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        return std::nullopt;
+    }
+    return Hello{
+        static_cast<std::uint8_t>(data[4]), static_cast<std::uint8_t>(data[5])
+    };
+}
+
+void put_varint(std::string &out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool get_varint(const char *&pos, const char *end, std::uint64_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < end; shift += 7) {
+        auto byte = static_cast<unsigned char>(*pos++);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Token stream: varint literal length, literals, then (unless at the end)
+// varint (match length - MIN_MATCH) and varint offset.
+std::string compress(std::string_view data) {
+    std::string out;
+    out.reserve(data.size() / 2 + 16);
+
+    const char *begin = data.data();
+    const char *end = begin + data.size();
+    const char *pos = begin;
+    const char *literal = begin;
+    std::vector<std::uint32_t> table(std::size_t(1) << HASH_BITS, 0);
+
+    while (end - pos >= static_cast<std::ptrdiff_t>(MIN_MATCH)) {
+        auto h = hash4(pos);
+        const char *candidate = begin + table[h];
+        table[h] = static_cast<std::uint32_t>(pos - begin);
+
+        if (candidate >= pos ||
+            static_cast<std::size_t>(pos - candidate) > MAX_OFFSET ||
+            read_u32(candidate) != read_u32(pos)) {
+            ++pos;
+            continue;
+        }
+
+        std::size_t len = MIN_MATCH;
+        while (pos + len < end && candidate[len] == pos[len]) {
+            ++len;
+        }
+
+        put_varint(out, static_cast<std::uint64_t>(pos - literal));
+        out.append(literal, pos);
+        put_varint(out, len - MIN_MATCH);
+        put_varint(out, static_cast<std::uint64_t>(pos - candidate));
+
+        pos += len;
+        literal = pos;
+    }
+
+    put_varint(out, static_cast<std::uint64_t>(end - literal));
+    out.append(literal, end);
+    return out;
+}
+
+std::string decompress(std::string_view data, std::size_t raw_size) {
+    std::string out;
+    out.reserve(raw_size);
+
+    const char *pos = data.data();
+    const char *end = pos + data.size();
+
+    while (pos < end) {
+        std::uint64_t literal_len;
+        if (!get_varint(pos, end, literal_len) ||
+            literal_len > static_cast<std::uint64_t>(end - pos) ||
+            out.size() + literal_len > raw_size) {
+            throw std::runtime_error("Corrupted compressed block");
+        }
+        out.append(pos, literal_len);
+        pos += literal_len;
+
+        if (pos == end) {
+            break;
+        }
+
+        std::uint64_t match_len;
+        std::uint64_t offset;
+        if (!get_varint(pos, end, match_len) ||
+            !get_varint(pos, end, offset) || offset == 0 ||
+            offset > out.size() ||
+            out.size() + match_len + MIN_MATCH > raw_size) {
+            throw std::runtime_error("Corrupted compressed block");
+        }
+        // byte by byte: the match may overlap its own output
+        std::size_t from = out.size() - offset;
+        for (std::uint64_t i = 0; i < match_len + MIN_MATCH; ++i) {
+            out.push_back(out[from + i]);
+        }
+    }
+
+    if (out.size() != raw_size) {
+        throw std::runtime_error("Corrupted compressed block");
+    }
+    return out;
+}
+
+Encoder::Encoder(bool compression) : compression_(compression) {}
+
+void Encoder::add(const Record &record) {
+    put_varint(
+        payload_, ((record.seq - last_seq_) << 2) |
+                      static_cast<std::uint64_t>(record.level)
+    );
+    put_varint(payload_, zigzag(record.timestamp_ms - last_ts_));
+    put_varint(payload_, record.message.size());
+    payload_ += record.message;
+
+    last_seq_ = record.seq;
+    last_ts_ = record.timestamp_ms;
+}
+
+bool Encoder::empty() const {
+    return payload_.empty();
+}
+
+std::string Encoder::finish() {
+    std::uint8_t flags = 0;
+    std::string body;
+
+    if (compression_ && payload_.size() >= MIN_COMPRESS_SIZE) {
+        std::string packed = compress(payload_);
+        std::string raw_size;
+        put_varint(raw_size, payload_.size());
+
+        if (packed.size() + raw_size.size() < payload_.size()) {
+            flags |= FLAG_COMPRESSED;
+            body = std::move(raw_size);
+            body += packed;
+        }
+    }
+    if (!(flags & FLAG_COMPRESSED)) {
+        body = std::move(payload_);
+    }
+    payload_.clear();
+
+    std::string frame;
+    frame.reserve(FRAME_HEADER_SIZE + body.size());
+    put_u32_le(frame, static_cast<std::uint32_t>(body.size() + 1));
+    frame.push_back(static_cast<char>(flags));
+    frame += body;
+    return frame;
+}
+
+void Decoder::feed(const char *data, std::size_t size) {
+    // drop consumed prefix before growing the buffer
+    if (input_pos_ > 0 && input_pos_ * 2 >= input_.size()) {
+        input_.erase(0, input_pos_);
+        input_pos_ = 0;
+    }
+    input_.append(data, size);
+}
+
+bool Decoder::decode_frame() {
+    std::size_t available = input_.size() - input_pos_;
+    if (available < FRAME_HEADER_SIZE) {
+        return false;
+    }
+
+    const char *head = input_.data() + input_pos_;
+    std::size_t frame_len = get_u32_le(head);
+    if (frame_len == 0 || frame_len > MAX_FRAME_SIZE) {
+        throw std::runtime_error("Invalid frame length");
+    }
+    if (available < 4 + frame_len) {
+        return false;
+    }
+
+    auto flags = static_cast<std::uint8_t>(head[4]);
+    const char *pos = head + FRAME_HEADER_SIZE;
+    const char *end = head + 4 + frame_len;
+
+    if (flags & FLAG_COMPRESSED) {
+        std::uint64_t raw_size;
+        if (!get_varint(pos, end, raw_size) || raw_size > MAX_FRAME_SIZE) {
+            throw std::runtime_error("Invalid compressed frame");
+        }
+        batch_ = decompress(
+            std::string_view(pos, static_cast<std::size_t>(end - pos)),
+            static_cast<std::size_t>(raw_size)
+        );
+    } else {
+        batch_.assign(pos, end);
+    }
+
+    batch_pos_ = 0;
+    input_pos_ += 4 + frame_len;
+    return true;
+}
+
+bool Decoder::next(Record &record) {
+    while (batch_pos_ >= batch_.size()) {
+        if (!decode_frame()) {
+            return false;
+        }
+    }
+
+    const char *pos = batch_.data() + batch_pos_;
+    const char *end = batch_.data() + batch_.size();
+
+    std::uint64_t header;
+    std::uint64_t ts_delta;
+    std::uint64_t len;
+    if (!get_varint(pos, end, header) || !get_varint(pos, end, ts_delta) ||
+        !get_varint(pos, end, len) ||
+        len > static_cast<std::uint64_t>(end - pos) || (header & 3) > 2) {
+        throw std::runtime_error("Malformed record");
+    }
+
+    last_seq_ += header >> 2;
+    last_ts_ += unzigzag(ts_delta);
+
+    record.seq = last_seq_;
+    record.level = static_cast<LogLevel>(header & 3);
+    record.timestamp_ms = last_ts_;
+    record.message.assign(pos, len);
+
+    batch_pos_ = static_cast<std::size_t>(pos + len - batch_.data());
+    return true;
+}
+
+}  // namespace loggerlib::wire
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <loggerlib/archive.hpp>
+#include <mytest.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace loggerlib;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::time_t BASE = 1'750'000'000;
+
+std::string line(
+    std::time_t seconds,
+    const char *tag,
+    const std::string &text
+) {
+    std::tm tm;
+    localtime_r(&seconds, &tm);
+    char prefix[32];
+    std::strftime(prefix, sizeof(prefix), "[%Y-%m-%d %H:%M:%S] ", &tm);
+    return prefix + std::string(tag) + text + "\n";
+}
+
+std::string sample_log() {
+    const char *tags[] = {"DEBUG: ", "INFO:  ", "ERROR: "};
+    std::string log = "no timestamp here\n";
+    for (int i = 0; i < 100; ++i) {
+        log += line(
+            BASE + i, tags[i % 3],
+            "request " + std::to_string(i) + " took " +
+                std::to_string(i * 7 % 13) + "ms"
+        );
+        if (i % 10 == 0) {
+            log += "  at handler:42\n";
+        }
+    }
+    return log;
+}
+
+std::string pack(const std::string &path, const std::string &log) {
+    ArchiveOptions options;
+    options.block_records = 16;
+    archive::Writer writer(path, options);
+    std::size_t pos = 0;
+    while (pos < log.size()) {
+        std::size_t next = std::min(log.find('\n', pos), log.size() - 1) + 1;
+        writer.add_line(std::string_view(log).substr(pos, next - pos));
+        pos = next;
+    }
+    writer.finish();
+    return path;
+}
+
+}  // namespace
+
+TEST_CASE("Archive gives back the text it was written from") {
+    const std::string path = "temp_archive.lga";
+    const std::string log = sample_log();
+    pack(path, log);
+    CHECK(fs::file_size(path) < log.size());
+
+    archive::Reader reader(path);
+    CHECK(reader.blocks().size() == 7);  // 101 records
+    std::string text;
+    for (const auto &block : reader.blocks()) {
+        reader.text(block, text);
+    }
+    CHECK(text == log);
+
+    // only the records selected
+    const auto &block = reader.blocks()[1];
+    std::vector<bool> keep(block.records, false);
+    keep[0] = true;
+    text.clear();
+    reader.text(block, text, &keep);
+    CHECK(text == line(BASE + 15, "DEBUG: ", "request 15 took 1ms"));
+
+    // the last line had no '\n', in a record of its own or a continuation
+    for (const char *tail : {"[no newline", "  at handler:43"}) {
+        std::string unterminated = log + tail;
+        pack(path, unterminated);
+        archive::Reader again(path);
+        text.clear();
+        for (const auto &block : again.blocks()) {
+            again.text(block, text);
+        }
+        CHECK(text == unterminated);
+    }
+
+    fs::remove(path);
+}
+
+TEST_CASE("Archive block headers describe their records") {
+    const std::string path = "temp_archive_blocks.lga";
+    pack(path, sample_log());
+
+    archive::Reader reader(path);
+    const auto &first = reader.blocks().front();
+    // the leading raw line takes the time of no record, 0
+    CHECK(first.records == 16);
+    CHECK(first.min_ms == 0);
+    CHECK(first.max_ms == (BASE + 14) * 1000);
+    CHECK(first.counts[archive::RAW] == 1);
+    CHECK(first.counts[0] + first.counts[1] + first.counts[2] == 15);
+
+    const auto &second = reader.blocks()[1];
+    CHECK(second.min_ms == (BASE + 15) * 1000);
+    CHECK(second.levels == 0b0111);
+
+    auto stamps = reader.timestamps(second);
+    auto levels = reader.levels(second);
+    CHECK(stamps.size() == 16);
+    CHECK(stamps[1] == (BASE + 16) * 1000);
+    CHECK(levels[0] == 0);  // 15 % 3, DEBUG
+    CHECK(levels[2] == 2);
+
+    // levels fill the whole block
+    std::uint32_t total = 0;
+    for (const auto &block : reader.blocks()) {
+        for (auto count : block.counts) {
+            total += count;
+        }
+    }
+    CHECK(total == 101);
+
+    fs::remove(path);
+}
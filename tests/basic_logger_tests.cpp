@@ -0,0 +1,86 @@
+#include <filesystem>
+#include <loggerlib/basic_logger.hpp>
+#include <mytest.hpp>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "helpers.hpp"
+
+namespace fs = std::filesystem;
+using namespace loggerlib;
+
+TEST_CASE("BasicLogger single-threaded file logger writes Logger lines") {
+    const std::string filepath = "temp_basic_logger.txt";
+    {
+        BasicLogger<FileSink, SingleThreaded> logger(
+            FileSink(filepath), LogLevel::INFO
+        );
+        logger.log("hidden", LogLevel::DEBUG);
+        logger.log("info", LogLevel::INFO);
+        logger.log<LogLevel::ERROR>("error");
+    }
+
+    auto lines = read_lines(filepath);
+    CHECK(lines.size() == 2);
+    if (lines.size() == 2) {
+        std::regex info(R"(\[\d{4}-\d{2}-\d{2} \d{2}:\d{2}:\d{2}\] INFO:  info)");
+        CHECK(std::regex_match(lines[0], info));
+        CHECK(std::regex_match(lines[1], std::regex(R"(\[.*\] ERROR: error)")));
+    }
+    fs::remove(filepath);
+}
+
+TEST_CASE("BasicLogger MinLevel filters regardless of the runtime level") {
+    const std::string filepath = "temp_basic_logger_min.txt";
+    {
+        BasicLogger<FileSink, SingleThreaded, MessageOnlyFormat, LogLevel::INFO>
+            logger(FileSink(filepath), LogLevel::DEBUG);
+        CHECK(!logger.is_enabled(LogLevel::DEBUG));
+        CHECK(logger.is_enabled(LogLevel::INFO));
+
+        bool evaluated = false;
+        logger.log(
+            [&] {
+                evaluated = true;
+                return std::string("debug");
+            },
+            LogLevel::DEBUG
+        );
+        CHECK(!evaluated);
+
+        logger.log<LogLevel::DEBUG>("debug");
+        logger.log("info", LogLevel::INFO);
+        logger.set_level(LogLevel::ERROR);
+        CHECK(logger.get_level() == LogLevel::ERROR);
+        logger.log("info again", LogLevel::INFO);
+        logger.log([] { return "error"; }, LogLevel::ERROR);
+    }
+
+    auto lines = read_lines(filepath);
+    CHECK(lines == std::vector<std::string>({"info", "error"}));
+    fs::remove(filepath);
+}
+
+TEST_CASE("GenericLogger writes to a file sink chosen at runtime") {
+    const std::string filepath = "temp_generic_logger.txt";
+    {
+        GenericLogger logger(FileSink(filepath), LogLevel::DEBUG);
+        logger.log("debug", LogLevel::DEBUG);
+    }
+
+    auto lines = read_lines(filepath);
+    CHECK(lines.size() == 1);
+    if (lines.size() == 1) {
+        CHECK(std::regex_match(lines[0], std::regex(R"(\[.*\] DEBUG: debug)")));
+    }
+    fs::remove(filepath);
+
+    try {
+        GenericLogger logger(FileSink("\\/?<>*|.forbidden/log"));
+        CHECK_MESSAGE(false, "FileSink didn't throw");
+    } catch (const std::runtime_error &e) {
+        CHECK(std::string(e.what()).rfind("Cannot open log file: ", 0) == 0);
+    }
+}
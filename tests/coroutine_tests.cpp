@@ -0,0 +1,156 @@
+#include <chrono>
+#include <filesystem>
+#include <loggerlib/executor.hpp>
+#include <loggerlib/logger.hpp>
+#include <loggerlib/task.hpp>
+#include <mytest.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "helpers.hpp"
+
+namespace fs = std::filesystem;
+using namespace loggerlib;
+
+namespace {
+
+Task produce(Logger &logger, int count, int &done) {
+    for (int i = 0; i < count; ++i) {
+        co_await logger.log_async(std::to_string(i), LogLevel::INFO);
+    }
+    ++done;
+}
+
+}  // namespace
+
+TEST_CASE("log_async suspends the coroutine, not the thread, on a full lane") {
+    const std::string filepath = "temp_logger_coroutine.txt";
+    {
+        // nothing is drained unless the test flushes
+        BackendOptions manual_options;
+        manual_options.threads = 0;  // nothing drains but flush()
+        Backend manual(manual_options);
+
+        AsyncOptions options;
+        options.backend = &manual;
+        options.lanes[1] = {4, OverflowPolicy::BLOCK, false};
+
+        Logger logger(filepath, LogLevel::INFO);
+        logger.set_pattern("%v");
+        logger.enable_async(options);
+
+        EventLoop loop;
+        int done = 0;
+        int ticks = 0;
+        loop.post([&] { produce(logger, 10, done); });
+        loop.post([&] { ++ticks; });
+
+        // 4 queued, the 5th parks and the loop goes on
+        loop.poll();
+        CHECK(done == 0);
+        CHECK(ticks == 1);
+        CHECK(read_lines(filepath).empty());
+
+        for (int round = 0; round < 10 && done == 0; ++round) {
+            logger.flush();
+            loop.poll();
+        }
+        CHECK(done == 1);
+        CHECK(logger.dropped(LogLevel::INFO) == 0);
+        logger.flush();
+    }
+
+    std::vector<std::string> expected;
+    for (int i = 0; i < 10; ++i) {
+        expected.push_back(std::to_string(i));
+    }
+    CHECK(read_lines(filepath) == expected);
+    fs::remove(filepath);
+}
+
+TEST_CASE("log_async resumes on the caller's executor") {
+    const std::string filepath = "temp_logger_coroutine_executor.txt";
+    std::size_t lines = 0;
+    {
+        // outlives the logger: a Backend thread may still be posting to it
+        EventLoop loop;
+
+        AsyncOptions options;
+        options.lanes[1] = {2, OverflowPolicy::BLOCK, false};
+        options.flush_interval = std::chrono::milliseconds(1);
+
+        Logger logger(filepath, LogLevel::INFO);
+        logger.enable_async(options);
+
+        int done = 0;
+        auto loop_thread = std::this_thread::get_id();
+        bool resumed_elsewhere = false;
+
+        auto check_thread = [&]() -> Task {
+            for (int i = 0; i < 100; ++i) {
+                co_await logger.log_async("message", LogLevel::INFO);
+                resumed_elsewhere |= std::this_thread::get_id() != loop_thread;
+            }
+            ++done;
+            loop.stop();
+        };
+        loop.post([&] { check_thread(); });
+        loop.run();
+
+        CHECK(done == 1);
+        CHECK(!resumed_elsewhere);
+        logger.flush();
+        lines = read_lines(filepath).size();
+    }
+    CHECK(lines == 100);
+    fs::remove(filepath);
+}
+
+TEST_CASE("log_async without async mode writes at once") {
+    const std::string filepath = "temp_logger_coroutine_sync.txt";
+    {
+        Logger logger(filepath, LogLevel::INFO);
+        EventLoop loop;
+        int done = 0;
+        loop.post([&] { produce(logger, 3, done); });
+        loop.poll();
+        CHECK(done == 1);
+    }
+    CHECK(read_lines(filepath).size() == 3);
+    fs::remove(filepath);
+}
+
+TEST_CASE("log_async without an executor resumes outside the logger's locks") {
+    const std::string filepath = "temp_logger_coroutine_inline.txt";
+    {
+        BackendOptions manual_options;
+        manual_options.threads = 0;  // nothing drains but flush()
+        Backend manual(manual_options);
+
+        AsyncOptions options;
+        options.backend = &manual;
+        options.lanes[1] = {1, OverflowPolicy::BLOCK, false};
+
+        Logger logger(filepath, LogLevel::INFO);
+        logger.set_pattern("%v");
+        logger.enable_async(options);
+
+        // started outside any executor, so flush() resumes it in place
+        int done = 0;
+        auto flushing = [&]() -> Task {
+            co_await logger.log_async("queued", LogLevel::INFO);
+            co_await logger.log_async("parked", LogLevel::INFO);
+            logger.flush();
+            ++done;
+        };
+        flushing();
+        CHECK(done == 0);
+
+        logger.flush();
+        CHECK(done == 1);
+        std::vector<std::string> expected = {"queued", "parked"};
+        CHECK(read_lines(filepath) == expected);
+    }
+    fs::remove(filepath);
+}
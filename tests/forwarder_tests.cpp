@@ -0,0 +1,215 @@
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <loggerlib/forwarder.hpp>
+#include <mutex>
+#include <mytest.hpp>
+#include <string>
+#include <thread>
+
+using namespace loggerlib;
+
+namespace {
+
+// Accepts connections one after another and keeps all the bytes
+class Collector {
+public:
+    Collector() {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        // a paused collector stops the sender soon
+        int buffer_size = 4096;
+        setsockopt(
+            listen_fd_, SOL_SOCKET, SO_RCVBUF, &buffer_size,
+            sizeof(buffer_size)
+        );
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+        socklen_t length = sizeof(addr);
+        getsockname(
+            listen_fd_, reinterpret_cast<sockaddr *>(&addr), &length
+        );
+        port_ = ntohs(addr.sin_port);
+        listen(listen_fd_, 4);
+
+        thread_ = std::thread([this]() {
+            while (true) {
+                int client = accept(listen_fd_, nullptr, nullptr);
+                if (client < 0) {
+                    return;
+                }
+                char buffer[4096];
+                ssize_t got;
+                while (true) {
+                    while (paused_.load()) {
+                        std::this_thread::sleep_for(
+                            std::chrono::milliseconds(1)
+                        );
+                    }
+                    if ((got = recv(client, buffer, sizeof(buffer), 0)) <= 0) {
+                        break;
+                    }
+                    std::lock_guard lock(mutex_);
+                    received_.append(buffer, static_cast<std::size_t>(got));
+                }
+                close(client);
+            }
+        });
+    }
+    ~Collector() {
+        shutdown(listen_fd_, SHUT_RDWR);
+        close(listen_fd_);
+        thread_.join();
+    }
+
+    int port() const {
+        return port_;
+    }
+
+    // Stop reading, the sender's socket fills up
+    void set_paused(bool paused) {
+        paused_.store(paused);
+    }
+
+    // Wait until size bytes arrived, returns them
+    std::string wait_for(std::size_t size) {
+        auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < until) {
+            {
+                std::lock_guard lock(mutex_);
+                if (received_.size() >= size) {
+                    return received_;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::lock_guard lock(mutex_);
+        return received_;
+    }
+
+private:
+    int listen_fd_;
+    int port_ = 0;
+    std::thread thread_;
+    std::atomic<bool> paused_{false};
+    std::mutex mutex_;
+    std::string received_;
+};
+
+void append(const std::string &filepath, const std::string &text) {
+    std::ofstream file(filepath, std::ios::app);
+    file << text;
+}
+
+}  // namespace
+
+TEST_CASE("Forwarder ships a growing file across rotation") {
+    const std::string filepath = "temp_forwarder.log";
+    const std::string rotated = "temp_forwarder.log.1";
+    std::remove(filepath.c_str());
+    std::remove(rotated.c_str());
+    std::remove((filepath + ".fwd").c_str());
+
+    Collector collector;
+    std::string expected;
+    {
+        Forwarder forwarder(filepath, "127.0.0.1", collector.port());
+        CHECK(forwarder.pump() == 0);  // no file yet
+        CHECK(forwarder.connected());
+
+        append(filepath, "first line\n");
+        expected += "first line\n";
+        CHECK(forwarder.pump() == 11);
+        CHECK(collector.wait_for(expected.size()) == expected);
+
+        // renamed away after one more line, a new file takes its place
+        append(filepath, "last of the old file\n");
+        std::rename(filepath.c_str(), rotated.c_str());
+        append(filepath, "new file\n");
+        expected += "last of the old file\nnew file\n";
+        forwarder.pump();
+        CHECK(collector.wait_for(expected.size()) == expected);
+        CHECK(forwarder.offset() == 9);
+
+        // rotated while the forwarder is stuck on a full socket: a writer
+        // still holding the old file appends to it after the rename
+        std::string bulk(8 << 20, 'x');
+        bulk.back() = '\n';
+        append(filepath, bulk);
+        collector.set_paused(true);
+        std::thread pumping([&forwarder]() { forwarder.pump(); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::rename(filepath.c_str(), rotated.c_str());
+        append(rotated, "appended after the rename\n");
+        append(filepath, "newest file\n");
+        collector.set_paused(false);
+        pumping.join();
+        forwarder.pump();
+        expected += bulk + "appended after the rename\nnewest file\n";
+        CHECK(collector.wait_for(expected.size()) == expected);
+        CHECK(forwarder.offset() == 12);
+    }
+
+    // the forwarder runs in a thread and wakes on inotify events
+    {
+        Forwarder forwarder(filepath, "127.0.0.1", collector.port());
+        std::thread runner([&forwarder]() { forwarder.run(); });
+        append(filepath, "seen by run\n");
+        expected += "seen by run\n";
+        CHECK(collector.wait_for(expected.size()) == expected);
+        forwarder.stop();
+        runner.join();
+    }
+
+    std::remove(filepath.c_str());
+    std::remove(rotated.c_str());
+    std::remove((filepath + ".fwd").c_str());
+}
+
+TEST_CASE("Forwarder resumes at the saved offset after a restart") {
+    const std::string filepath = "temp_forwarder_resume.log";
+    std::remove(filepath.c_str());
+    std::remove((filepath + ".fwd").c_str());
+
+    Collector collector;
+    append(filepath, "one\ntwo\n");
+    {
+        Forwarder forwarder(filepath, "127.0.0.1", collector.port());
+        forwarder.pump();
+    }
+    CHECK(collector.wait_for(8) == "one\ntwo\n");
+
+    // written while no forwarder ran
+    append(filepath, "three\n");
+    {
+        Forwarder forwarder(filepath, "127.0.0.1", collector.port());
+        CHECK(forwarder.pump() == 6);
+        CHECK(forwarder.offset() == 14);
+    }
+    CHECK(collector.wait_for(14) == "one\ntwo\nthree\n");
+
+    // a file replaced in between is read from its start
+    std::remove(filepath.c_str());
+    append(filepath, "four\n");
+    {
+        Forwarder forwarder(filepath, "127.0.0.1", collector.port());
+        CHECK(forwarder.pump() == 5);
+    }
+    CHECK(collector.wait_for(19) == "one\ntwo\nthree\nfour\n");
+
+    bool thrown = false;
+    try {
+        Forwarder forwarder("/nonexistent/dir/log", "127.0.0.1", 1);
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    CHECK(thrown);
+
+    std::remove(filepath.c_str());
+    std::remove((filepath + ".fwd").c_str());
+}
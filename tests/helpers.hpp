@@ -0,0 +1,19 @@
+#ifndef LOGGERLIB_TESTS_HELPERS_HPP_
+#define LOGGERLIB_TESTS_HELPERS_HPP_
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Lines of a file, without their '\n'
+inline std::vector<std::string> read_lines(const std::string &filepath) {
+    std::ifstream f(filepath);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(f, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+#endif  // LOGGERLIB_TESTS_HELPERS_HPP_
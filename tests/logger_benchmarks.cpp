@@ -0,0 +1,153 @@
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <loggerlib/basic_logger.hpp>
+#include <loggerlib/logger.hpp>
+#include <loggerlib/pattern.hpp>
+#include <mytest.hpp>
+#include <sstream>
+#include <string>
+
+using namespace loggerlib;
+
+namespace {
+
+const char *const BENCH_FILE = "temp_logger_bench.txt";
+
+std::string dump(std::uint64_t value) {
+    return "{id: " + std::to_string(value) + ", state: running}";
+}
+
+}  // namespace
+
+// Filtered lazy calls should cost the same as an empty branch
+BENCHMARK("Filtered DEBUG calls") {
+    {
+        Logger logger(BENCH_FILE, LogLevel::INFO);
+        volatile int threshold = static_cast<int>(LogLevel::INFO);
+        mytest::measure("empty branch", [&](std::uint64_t i) {
+            if (static_cast<int>(LogLevel::DEBUG) >= threshold) {
+                mytest::do_not_optimize(dump(i));
+            }
+        });
+        mytest::measure("eager log(\"state=\" + dump())", [&](std::uint64_t i) {
+            logger.log("state=" + dump(i), LogLevel::DEBUG);
+        });
+        mytest::measure("lazy log([] { ... })", [&](std::uint64_t i) {
+            logger.log([&] { return "state=" + dump(i); }, LogLevel::DEBUG);
+        });
+        mytest::measure("LOGGERLIB_DEBUG macro", [&](std::uint64_t i) {
+            LOGGERLIB_DEBUG(logger, "state=" + dump(i));
+        });
+        mytest::measure("debug() << stream", [&](std::uint64_t i) {
+            logger.debug() << "state=" << i;
+        });
+    }
+    std::remove(BENCH_FILE);
+}
+
+// Single thread writing to a file through each configuration
+BENCHMARK("Single-threaded file logging") {
+    {
+        Logger logger(BENCH_FILE, LogLevel::INFO);
+        mytest::measure("Logger", [&] {
+            logger.log("request handled", LogLevel::INFO);
+        });
+    }
+    std::remove(BENCH_FILE);
+    {
+        GenericLogger logger(FileSink(BENCH_FILE), LogLevel::INFO);
+        mytest::measure("GenericLogger", [&] {
+            logger.log("request handled", LogLevel::INFO);
+        });
+    }
+    std::remove(BENCH_FILE);
+    {
+        BasicLogger<FileSink, MultiThreaded> logger(
+            FileSink(BENCH_FILE), LogLevel::INFO
+        );
+        mytest::measure("BasicLogger<FileSink, MultiThreaded>", [&] {
+            logger.log("request handled", LogLevel::INFO);
+        });
+    }
+    std::remove(BENCH_FILE);
+    {
+        BasicLogger<FileSink, SingleThreaded> logger(
+            FileSink(BENCH_FILE), LogLevel::INFO
+        );
+        mytest::measure("BasicLogger<FileSink, SingleThreaded>", [&] {
+            logger.log("request handled", LogLevel::INFO);
+        });
+    }
+    std::remove(BENCH_FILE);
+}
+
+BENCHMARK("Filtered DEBUG calls by configuration") {
+    {
+        GenericLogger logger(FileSink(BENCH_FILE), LogLevel::INFO);
+        mytest::measure("GenericLogger runtime level", [&] {
+            logger.log("state", LogLevel::DEBUG);
+        });
+    }
+    {
+        BasicLogger<FileSink, SingleThreaded, DefaultFormat, LogLevel::INFO>
+            logger(FileSink(BENCH_FILE), LogLevel::INFO);
+        mytest::measure("BasicLogger MinLevel=INFO", [&] {
+            logger.log<LogLevel::DEBUG>("state");
+        });
+    }
+    std::remove(BENCH_FILE);
+}
+
+// Line formatting alone, the fixed format of the original Logger::log()
+// against compiled layouts
+BENCHMARK("Line layouts") {
+    std::string out;
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch()
+    )
+                   .count();
+    auto at = [now](std::uint64_t i) {
+        return now + static_cast<std::int64_t>(i / 1000);
+    };
+
+    mytest::measure("fixed put_time + switch", [&](std::uint64_t i) {
+        std::time_t in_time = at(i) / 1000;
+        std::tm buf;
+        localtime_r(&in_time, &buf);
+        std::ostringstream oss;
+        oss << std::put_time(&buf, "%Y-%m-%d %H:%M:%S");
+        out.clear();
+        out += '[' + oss.str() + "] ";
+        out += "INFO:  ";
+        out += "request handled";
+        out += '\n';
+        mytest::do_not_optimize(out);
+    });
+
+    Pattern fixed(DEFAULT_PATTERN);
+    mytest::measure("Pattern(DEFAULT_PATTERN)", [&](std::uint64_t i) {
+        out.clear();
+        fixed.format(out, {"request handled", LogLevel::INFO, at(i)});
+        mytest::do_not_optimize(out);
+    });
+
+    Pattern custom("%Y-%m-%d %H:%M:%S.%e [%t] %l: %v");
+    mytest::measure("Pattern with ms and thread id", [&](std::uint64_t i) {
+        out.clear();
+        custom.format(out, {"request handled", LogLevel::INFO, at(i)});
+        mytest::do_not_optimize(out);
+    });
+
+    static constexpr auto LAYOUT =
+        compile_pattern("%Y-%m-%d %H:%M:%S.%e [%t] %l: %v");
+    mytest::measure(
+        "compile_pattern with ms and thread id",
+        [&](std::uint64_t i) {
+            out.clear();
+            LAYOUT.format(out, {"request handled", LogLevel::INFO, at(i)});
+            mytest::do_not_optimize(out);
+        }
+    );
+}
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <chrono>
+#include <loggerlib/merge.hpp>
+#include <mytest.hpp>
+#include <string>
+#include <vector>
+
+using namespace loggerlib;
+
+namespace {
+
+merge::Entry entry(std::int64_t ts, std::uint64_t seq) {
+    return {ts, seq, std::to_string(ts) + "/" + std::to_string(seq)};
+}
+
+std::vector<std::string> pop_all(Merger &merger) {
+    std::vector<std::string> texts;
+    merge::Entry popped;
+    while (merger.pop(popped)) {
+        texts.push_back(popped.text);
+    }
+    return texts;
+}
+
+}  // namespace
+
+TEST_CASE("Merger orders streams by timestamp within the window") {
+    MergeOptions options;
+    options.window = std::chrono::milliseconds(10);
+    Merger merger(options);
+    auto first = merger.add_stream();
+    auto second = merger.add_stream();
+
+    merger.push(first, entry(100, 0));
+    merger.push(first, entry(120, 1));
+    // the second stream has sent nothing yet, so nothing is released
+    CHECK(pop_all(merger).empty());
+
+    merger.push(second, entry(105, 0));
+    merger.push(second, entry(100, 1));  // late but within the window
+    merger.push(second, entry(130, 2));
+    std::vector<std::string> released = {"100/0", "100/1", "105/0"};
+    CHECK(pop_all(merger) == released);
+    CHECK(merger.pending() == 2);
+
+    // nothing older than 135 - 10 comes any more
+    CHECK(*merger.lagging() == first);
+    merger.close_stream(first);
+    merger.advance(135);
+    released = {"120/1"};
+    CHECK(pop_all(merger) == released);
+
+    // a record beyond the window is released as soon as possible
+    merger.push(second, entry(90, 3));
+    released = {"90/3"};
+    CHECK(pop_all(merger) == released);
+    CHECK(merger.late() == 1);
+
+    merger.close_stream(second);
+    CHECK(!merger.lagging());
+    released = {"130/2"};
+    CHECK(pop_all(merger) == released);
+    CHECK(merger.pending() == 0);
+    CHECK(merger.add_stream() < 2);  // drained ids are reused
+}
+
+TEST_CASE("LineSplitter reassembles lines and keeps continuations") {
+    merge::LineSplitter splitter;
+    merge::Entry line;
+
+    std::string text =
+        "[2025-07-23 14:51:49] INFO:  first\n"
+        "[2025-07-23 14:51:50] ERROR: multi\n"
+        "line\n"
+        "[2025-07-23 15:00:01] DEBUG: tail";
+    std::vector<merge::Entry> lines;
+    // fed in pieces that split lines anywhere
+    for (std::size_t i = 0; i < text.size(); i += 7) {
+        std::size_t size = std::min<std::size_t>(7, text.size() - i);
+        splitter.feed(text.data() + i, size);
+        while (splitter.next(line)) {
+            lines.push_back(line);
+        }
+    }
+    CHECK(lines.size() == 3);
+    CHECK(splitter.finish(line));
+    lines.push_back(line);
+    CHECK(!splitter.finish(line));
+
+    CHECK(lines[0].text == "[2025-07-23 14:51:49] INFO:  first\n");
+    CHECK(lines[1].timestamp_ms - lines[0].timestamp_ms == 1000);
+    CHECK(lines[2].text == "line\n");
+    CHECK(lines[2].timestamp_ms == lines[1].timestamp_ms);
+    CHECK(lines[2].seq == 2);
+    CHECK(lines[3].timestamp_ms - lines[0].timestamp_ms == 492000);
+    CHECK(lines[3].text == "[2025-07-23 15:00:01] DEBUG: tail\n");
+}
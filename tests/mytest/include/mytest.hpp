@@ -1,8 +1,16 @@
 #ifndef MYTEST_HPP_
 #define MYTEST_HPP_
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <optional>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 // NOLINTBEGIN(cppcoreguidelines-macro-usage)
 #define MYTEST_INTERNAL_CAT_IMPL(s1, s2) s1##s2
@@ -21,6 +29,12 @@
     static void func();                                          \
     MYTEST_INTERNAL_REGISTER_FUNCTION(func, name);               \
     static void func()
+#define MYTEST_INTERNAL_CREATE_AND_REGISTER_AS(func, name, registrar) \
+    static void func();                                               \
+    MYTEST_INTERNAL_RUN_EXPR_BEFORE_MAIN(                             \
+        ::mytest::registrar(&(func), #name)                           \
+    );                                                                \
+    static void func()
 
 #define CHECK(expr) \
     ::mytest::check(bool(expr), #expr, __FILE__, __LINE__, ::std::nullopt)
@@ -34,6 +48,22 @@
         MYTEST_INTERNAL_ANONYMOUS(MYTEST_INTERNAL_ANON_FUNC_), name \
     )
 
+// Runs alone after the others, for test cases that use process-wide
+// state or depend on timing
+#define TEST_CASE_SERIAL(name)                                            \
+    MYTEST_INTERNAL_CREATE_AND_REGISTER_AS(                               \
+        MYTEST_INTERNAL_ANONYMOUS(MYTEST_INTERNAL_ANON_FUNC_), name,      \
+        register_serial_test                                              \
+    )
+
+// Run only with --bench, one at a time. The body sets up and calls
+// mytest::measure() for each operation it times.
+#define BENCHMARK(name)                                                   \
+    MYTEST_INTERNAL_CREATE_AND_REGISTER_AS(                               \
+        MYTEST_INTERNAL_ANONYMOUS(MYTEST_INTERNAL_ANON_BENCH_), name,     \
+        register_benchmark                                                \
+    )
+
 #define SUBCASE(name)                                         \
     if (const ::mytest::Subcase &                             \
             MYTEST_INTERNAL_ANONYMOUS(MYTEST_ANON_SUBCASE_) = \
@@ -45,6 +75,8 @@ namespace mytest {
 
 using func_ptr = void (*)();
 
+struct TestRun;
+
 struct Subcase {
     explicit Subcase(const std::string &name);
     ~Subcase();
@@ -63,6 +95,8 @@ private:
 struct TestCase {
     func_ptr func;
     std::string name;
+    bool benchmark = false;
+    bool serial = false;  // benchmarks are always
 };
 
 void check(
@@ -74,7 +108,120 @@ void check(
 );
 
 void register_test(func_ptr func, const std::string &name);
+void register_serial_test(func_ptr func, const std::string &name);
+void register_benchmark(func_ptr func, const std::string &name);
+
+// Keeps the compiler from dropping the computation of value
+template <typename T>
+inline void do_not_optimize(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+namespace detail {
+
+// Run of the test case the calling thread works for, null outside any
+TestRun *thread_run();
+void set_thread_run(TestRun *run);
+
+using Clock = std::chrono::steady_clock;
+
+// Calibration stops doubling the iterations here, for operations the
+// compiler removed altogether
+constexpr std::uint64_t MAX_ITERATIONS = std::uint64_t(1) << 40;
+
+// Run func iterations times, returns the nanoseconds taken. func may take
+// the iteration number.
+template <typename F>
+double time_loop(F &func, std::uint64_t iterations) {
+    auto start = Clock::now();
+    for (std::uint64_t i = 0; i < iterations; ++i) {
+        // the loop stays even if func compiles to nothing
+        do_not_optimize(i);
+        if constexpr (std::is_invocable_v<F &, std::uint64_t>) {
+            func(i);
+        } else {
+            func();
+        }
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start)
+        .count();
+}
+
+// Warmup and calibration targets, see measure()
+std::chrono::nanoseconds warmup_time();
+std::chrono::nanoseconds sample_time();
+unsigned samples();
+
+// Print the statistics of the samples, nanoseconds per operation
+void report(
+    const std::string &label,
+    std::vector<double> &samples,
+    std::uint64_t iterations
+);
+
+}  // namespace detail
+
+// std::thread whose CHECKs count for the test case that started it. With
+// plain std::thread they are blamed on a test case only if it is the one
+// in flight.
+class thread : public std::thread {
+public:
+    thread() noexcept = default;
+
+    template <typename F, typename... Args>
+    explicit thread(F &&func, Args &&...args)
+        : std::thread(
+              [run = detail::thread_run()](auto &&func, auto &&...args) {
+                  detail::set_thread_run(run);
+                  std::invoke(
+                      std::forward<decltype(func)>(func),
+                      std::forward<decltype(args)>(args)...
+                  );
+              },
+              std::forward<F>(func), std::forward<Args>(args)...
+          ) {}
+};
+
+// Time func: warmup for warmup_time(), calibrate the iterations so that a
+// sample takes sample_time(), then report min/median/stddev per operation
+// over samples() samples
+template <typename F>
+void measure(const std::string &label, F &&func) {
+    double warmup = static_cast<double>(detail::warmup_time().count());
+    double target = static_cast<double>(detail::sample_time().count());
+
+    // warmup, doubling the iterations, which also estimates the cost
+    std::uint64_t iterations = 1;
+    std::uint64_t timed = 1;
+    double spent = 0;
+    double elapsed = 0;
+    while (spent < warmup || elapsed < target / 16) {
+        timed = iterations;
+        elapsed = detail::time_loop(func, timed);
+        spent += elapsed;
+        if (elapsed < target / 2) {
+            iterations *= 2;
+        }
+        if (iterations > detail::MAX_ITERATIONS) {
+            break;
+        }
+    }
+    double per_op = elapsed / static_cast<double>(timed);
+    iterations = static_cast<std::uint64_t>(target / std::max(per_op, 0.01));
+    iterations = std::clamp<std::uint64_t>(
+        iterations, 1, detail::MAX_ITERATIONS
+    );
+
+    std::vector<double> samples;
+    for (unsigned s = 0; s < detail::samples(); ++s) {
+        samples.push_back(
+            detail::time_loop(func, iterations) /
+            static_cast<double>(iterations)
+        );
+    }
+    detail::report(label, samples, iterations);
+}
 
 }  // namespace mytest
 
-#endif  // MYTEST_HPP_
\ No newline at end of file
+#endif  // MYTEST_HPP_
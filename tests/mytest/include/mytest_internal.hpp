@@ -1,7 +1,10 @@
 #ifndef MYTEST_INTERNAL_HPP_
 #define MYTEST_INTERNAL_HPP_
 
+#include <mutex>
 #include <queue>
+#include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -9,10 +12,8 @@
 
 namespace mytest {
 
-struct TestManager {
-    void add_test_case(const TestCase &test_case);
-
-    int run_tests();
+// State of one test case being run, owned by the thread running it
+struct TestRun {
     void report_failure();
     std::vector<std::string> &get_running_subcases();
 
@@ -26,16 +27,18 @@ struct TestManager {
     void block_level();
     bool has_fully_traversed();
 
-private:
-    std::vector<TestCase> test_cases;
-
-    void start_new_test_case();
     void start_new_iteration();
     bool is_continuable();
+    bool failed();
 
-    unsigned tests_total = 0;
-    unsigned tests_passed = 0;
+    // Printed when the test case ends. Checks may come from threads the
+    // test started, so both are guarded.
+    std::mutex mutex;
+    std::ostringstream output;
+    // Runs the test case body, the only thread that knows the subcases
+    std::thread::id owner = std::this_thread::get_id();
 
+private:
     int subcases_depth = 0;
     std::unordered_map<int, bool> is_blocked;
     std::unordered_map<int, int> subcases_traversed;
@@ -45,10 +48,54 @@ private:
     bool current_test_failed = false;
 };
 
+struct RunOptions {
+    unsigned jobs = 1;        // worker threads
+    bool fork = false;        // each test case in its own process
+    bool benchmarks = false;  // run the benchmarks instead of the tests
+    std::string filter;       // substring of the names to run
+};
+
+struct TestResult {
+    bool passed = false;
+    double seconds = 0;  // wall time
+    std::string output;
+};
+
+struct TestManager {
+    void add_test_case(const TestCase &test_case);
+
+    int run_tests(const RunOptions &options);
+
+    // Run of the calling thread. Plain std::threads started by a test have
+    // none: their checks go to the only run in flight, if there is one.
+    TestRun *current_run();
+    // A failed check no test case can be blamed for: printed at once, it
+    // fails the whole run
+    void report_orphan_failure(const std::string &text);
+    void set_solo_run(TestRun *run);
+
+private:
+    std::vector<TestCase> test_cases;
+
+    TestResult run_test_case(const TestCase &test_case);
+    TestResult run_forked(const TestCase &test_case);
+    // The subcase iterations, in the calling thread
+    void execute(const TestCase &test_case, TestRun &run);
+
+    std::mutex runs_mutex;
+    std::unordered_set<TestRun *> runs_in_flight;
+    TestRun *solo_run = nullptr;  // set in forked children
+    std::size_t orphan_failures = 0;
+};
+
 bool operator<(const TestCase &lhs, const TestCase &rhs);
 
+namespace detail {
+void set_samples(unsigned samples);
+}  // namespace detail
+
 TestManager &get_test_manager();
 
 }  // namespace mytest
 
-#endif  // MYTEST_INTERNAL_HPP
\ No newline at end of file
+#endif  // MYTEST_INTERNAL_HPP
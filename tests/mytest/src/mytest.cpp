@@ -1,76 +1,114 @@
 #include "mytest.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
 #include <iostream>
 #include <vector>
 #include "mytest_internal.hpp"
 
 namespace mytest {
 
-void TestManager::add_test_case(const TestCase &test_case) {
-    test_cases.push_back(test_case);
-}
+namespace {
+
+thread_local TestRun *thread_run = nullptr;
 
-void TestManager::report_failure() {
+constexpr auto WARMUP_TIME = std::chrono::milliseconds(100);
+constexpr auto SAMPLE_TIME = std::chrono::milliseconds(10);
+unsigned benchmark_samples = 20;
+
+}  // namespace
+
+void TestRun::report_failure() {
     current_test_failed = true;
 }
 
-std::vector<std::string> &TestManager::get_running_subcases() {
+std::vector<std::string> &TestRun::get_running_subcases() {
     return running_subcases_stack;
 }
 
-void TestManager::increase_depth() {
+void TestRun::increase_depth() {
     subcases_depth++;
 }
 
-void TestManager::increase_subcases_amount() {
+void TestRun::increase_subcases_amount() {
     subcases_amount[subcases_depth]++;
 }
 
-bool TestManager::is_up_to_execute() {
+bool TestRun::is_up_to_execute() {
     return !is_blocked[subcases_depth] &&
            subcases_amount[subcases_depth] > subcases_traversed[subcases_depth];
 }
 
-void TestManager::push_to_stack(const std::string &name) {
+void TestRun::push_to_stack(const std::string &name) {
     running_subcases_stack.push_back(name);
 }
 
-void TestManager::clear_level() {
+void TestRun::clear_level() {
     subcases_traversed[subcases_depth] = 0;
     subcases_amount[subcases_depth] = 0;
 }
 
-void TestManager::decrease_depth() {
+void TestRun::decrease_depth() {
     subcases_depth--;
 }
 
-void TestManager::block_level() {
+void TestRun::block_level() {
     is_blocked[subcases_depth] = true;
 }
 
-void TestManager::increase_traversed_subcases() {
+void TestRun::increase_traversed_subcases() {
     subcases_traversed[subcases_depth - 1]++;
 }
 
-bool TestManager::has_fully_traversed() {
+bool TestRun::has_fully_traversed() {
     return subcases_amount[subcases_depth] ==
            subcases_traversed[subcases_depth];
 }
 
-void TestManager::start_new_test_case() {
-    current_test_failed = false;
-    subcases_traversed.clear();
-}
-
-void TestManager::start_new_iteration() {
+void TestRun::start_new_iteration() {
     is_blocked.clear();
     subcases_amount.clear();
     running_subcases_stack.clear();
 }
 
-bool TestManager::is_continuable() {
+bool TestRun::is_continuable() {
+    std::lock_guard lock(mutex);
     return subcases_traversed[0] != subcases_amount[0] && !current_test_failed;
 }
 
+bool TestRun::failed() {
+    std::lock_guard lock(mutex);
+    return current_test_failed;
+}
+
+void TestManager::add_test_case(const TestCase &test_case) {
+    test_cases.push_back(test_case);
+}
+
+TestRun *TestManager::current_run() {
+    if (thread_run) {
+        return thread_run;
+    }
+    if (solo_run) {
+        return solo_run;
+    }
+    std::lock_guard lock(runs_mutex);
+    return runs_in_flight.size() == 1 ? *runs_in_flight.begin() : nullptr;
+}
+
+void TestManager::report_orphan_failure(const std::string &text) {
+    std::lock_guard lock(runs_mutex);
+    ++orphan_failures;
+    std::cerr << text
+              << "    \033[33mmessage:\033[0m failed in a thread of no known"
+                 " test case, start it with mytest::thread\n"
+              << std::flush;
+}
+
+void TestManager::set_solo_run(TestRun *run) {
+    solo_run = run;
+}
+
 // cppcheck-suppress[unusedFunction]
 void check(
     bool expr,
@@ -82,16 +120,29 @@ void check(
     if (expr) {
         return;
     }
-    ::mytest::get_test_manager().report_failure();
     // Colorized error output
-    std::cerr << "\033[1;31mCHECK(" << expr_str << ") failed at "
-              << file << ":" << line << "\033[0m" << std::endl;
+    std::ostringstream text;
+    text << "\033[1;31mCHECK(" << expr_str << ") failed at " << file << ":"
+         << line << "\033[0m\n";
     if (msg.has_value()) {
-        std::cerr << "    \033[33mmessage:\033[0m " << msg.value() << std::endl;
+        text << "    \033[33mmessage:\033[0m " << msg.value() << "\n";
+    }
+
+    auto &test_manager = get_test_manager();
+    TestRun *run = test_manager.current_run();
+    if (!run) {
+        test_manager.report_orphan_failure(text.str());
+        return;
     }
-    for (const auto &subcase : get_test_manager().get_running_subcases()) {
-        std::cerr << "    \033[36min subcase:\033[0m " << subcase << std::endl;
+    // subcases are only known in the thread running the test
+    if (std::this_thread::get_id() == run->owner) {
+        for (const auto &subcase : run->get_running_subcases()) {
+            text << "    \033[36min subcase:\033[0m " << subcase << "\n";
+        }
     }
+    std::lock_guard lock(run->mutex);
+    run->report_failure();
+    run->output << text.str();
 }
 
 // cppcheck-suppress[unusedFunction]
@@ -99,30 +150,40 @@ void register_test(func_ptr func, const std::string &name) {
     get_test_manager().add_test_case(TestCase{func, name});
 }
 
+// cppcheck-suppress[unusedFunction]
+void register_serial_test(func_ptr func, const std::string &name) {
+    get_test_manager().add_test_case(TestCase{func, name, false, true});
+}
+
+// cppcheck-suppress[unusedFunction]
+void register_benchmark(func_ptr func, const std::string &name) {
+    get_test_manager().add_test_case(TestCase{func, name, true, true});
+}
+
 bool operator<(const TestCase &lhs, const TestCase &rhs) {
     return lhs.name < rhs.name;
 }
 
 Subcase::Subcase(const std::string &name) {
-    auto &test_manager = get_test_manager();
-    test_manager.increase_subcases_amount();
-    if (!test_manager.is_up_to_execute()) {
+    auto &test_run = *thread_run;
+    test_run.increase_subcases_amount();
+    if (!test_run.is_up_to_execute()) {
         return;
     }
-    test_manager.push_to_stack(name);
-    test_manager.increase_depth();
+    test_run.push_to_stack(name);
+    test_run.increase_depth();
     executing_ = true;
 }
 
 Subcase::~Subcase() {
-    auto &test_manager = get_test_manager();
+    auto &test_run = *thread_run;
     if (executing_) {
-        if (test_manager.has_fully_traversed()) {
-            test_manager.clear_level();
-            test_manager.increase_traversed_subcases();
+        if (test_run.has_fully_traversed()) {
+            test_run.clear_level();
+            test_run.increase_traversed_subcases();
         }
-        test_manager.decrease_depth();
-        test_manager.block_level();
+        test_run.decrease_depth();
+        test_run.block_level();
     }
 }
 
@@ -135,4 +196,89 @@ TestManager &get_test_manager() {
     return test_manager;
 }
 
+namespace detail {
+
+TestRun *thread_run() {
+    return mytest::thread_run;
+}
+
+void set_thread_run(TestRun *run) {
+    mytest::thread_run = run;
+}
+
+std::chrono::nanoseconds warmup_time() {
+    return WARMUP_TIME;
+}
+
+std::chrono::nanoseconds sample_time() {
+    return SAMPLE_TIME;
+}
+
+unsigned samples() {
+    return benchmark_samples;
+}
+
+void set_samples(unsigned samples) {
+    benchmark_samples = std::max(samples, 1U);
+}
+
+namespace {
+
+// Nanoseconds in the unit that keeps them readable
+std::string format_time(double ns) {
+    const char *unit = "ns";
+    if (ns >= 1e6) {
+        ns /= 1e6;
+        unit = "ms";
+    } else if (ns >= 1e3) {
+        ns /= 1e3;
+        unit = "us";
+    }
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(2) << ns << " " << unit;
+    return text.str();
+}
+
+}  // namespace
+
+// cppcheck-suppress[unusedFunction]
+void report(
+    const std::string &label,
+    std::vector<double> &samples,
+    std::uint64_t iterations
+) {
+    std::sort(samples.begin(), samples.end());
+    double mean = 0;
+    for (double sample : samples) {
+        mean += sample;
+    }
+    mean /= static_cast<double>(samples.size());
+    double variance = 0;
+    for (double sample : samples) {
+        variance += (sample - mean) * (sample - mean);
+    }
+    variance /= static_cast<double>(samples.size());
+    std::size_t middle = samples.size() / 2;
+    double median = samples.size() % 2 == 1
+                        ? samples[middle]
+                        : (samples[middle - 1] + samples[middle]) / 2;
+
+    std::ostringstream text;
+    text << "    " << std::left << std::setw(40) << label << std::right
+         << " min " << format_time(samples.front()) << ", median "
+         << format_time(median) << ", stddev "
+         << format_time(std::sqrt(variance)) << " (" << samples.size()
+         << " x " << iterations << " iterations)\n";
+
+    TestRun *run = get_test_manager().current_run();
+    if (!run) {
+        std::cout << text.str() << std::flush;
+        return;
+    }
+    std::lock_guard lock(run->mutex);
+    run->output << text.str();
+}
+
+}  // namespace detail
+
 }  // namespace mytest
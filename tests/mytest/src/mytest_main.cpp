@@ -1,45 +1,276 @@
+#include <sys/wait.h>
+#include <unistd.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iomanip>
 #include <iostream>
+#include <string>
+#include <thread>
 #include "mytest.hpp"
 #include "mytest_internal.hpp"
 
 namespace mytest {
-int TestManager::run_tests() {
-    std::sort(test_cases.begin(), test_cases.end());
-    tests_total = test_cases.size();
 
-    for (const auto &test_case : test_cases) {
-        start_new_test_case();
+namespace {
+
+constexpr std::size_t SLOWEST_SHOWN = 5;
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(
+               std::chrono::steady_clock::now() - start
+    )
+        .count();
+}
+
+std::string format_seconds(double seconds) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(2);
+    if (seconds < 1) {
+        text << seconds * 1000 << " ms";
+    } else {
+        text << seconds << " s";
+    }
+    return text.str();
+}
+
+}  // namespace
+
+void TestManager::execute(const TestCase &test_case, TestRun &run) {
+    auto note = [&run](const std::string &text) {
+        std::lock_guard lock(run.mutex);
+        run.output << text;
+    };
+    try {
         // Colorized start
-        std::cerr << "\033[1;34mRunning " << test_case.name << "...\033[0m" << std::endl;
+        note("\033[1;34mRunning " + test_case.name + "...\033[0m\n");
         test_case.func();
 
-        while (is_continuable()) {
-            start_new_iteration();
-            std::cerr << "\033[1;33m...another subcase... \033[0m" << std::endl;
+        while (run.is_continuable()) {
+            run.start_new_iteration();
+            note("\033[1;33m...another subcase... \033[0m\n");
             test_case.func();
         }
+    } catch (const std::exception &e) {
+        note(std::string("\033[1;31mThrew: ") + e.what() + "\033[0m\n");
+        std::lock_guard lock(run.mutex);
+        run.report_failure();
+    }
+}
 
-        if (!current_test_failed) {
-            tests_passed++;
-            std::cerr << "\033[1;32m[PASS]\033[0m " << test_case.name << std::endl;
-        } else {
-            std::cerr << "\033[1;31m[FAIL]\033[0m " << test_case.name << std::endl;
+TestResult TestManager::run_test_case(const TestCase &test_case) {
+    TestRun run;
+    {
+        std::lock_guard lock(runs_mutex);
+        runs_in_flight.insert(&run);
+    }
+    detail::set_thread_run(&run);
+    auto start = std::chrono::steady_clock::now();
+    execute(test_case, run);
+
+    TestResult result;
+    result.seconds = seconds_since(start);
+    detail::set_thread_run(nullptr);
+    {
+        std::lock_guard lock(runs_mutex);
+        runs_in_flight.erase(&run);
+    }
+    result.passed = !run.failed();
+    result.output = run.output.str();
+    return result;
+}
+
+// The child writes its output to an unlinked file: a pipe would also be
+// inherited by the children other workers fork, and hold back the EOF
+TestResult TestManager::run_forked(const TestCase &test_case) {
+    TestResult result;
+    std::FILE *file = std::tmpfile();
+    if (!file) {
+        result.output = "\033[1;31mCannot create the output file\033[0m\n";
+        return result;
+    }
+    int fd = fileno(file);
+
+    auto start = std::chrono::steady_clock::now();
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        TestRun run;
+        set_solo_run(&run);
+        detail::set_thread_run(&run);
+        execute(test_case, run);
+        std::cout.flush();
+        auto output = run.output.str();
+        const char *data = output.data();
+        std::size_t size = output.size();
+        while (size > 0) {
+            ssize_t written = write(fd, data, size);
+            if (written <= 0) {
+                break;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        _exit(run.failed() ? 1 : 0);
+    }
+
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid) {
+        status = -1;
+    }
+    result.seconds = seconds_since(start);
+
+    char buffer[4096];
+    ssize_t got;
+    lseek(fd, 0, SEEK_SET);
+    while ((got = read(fd, buffer, sizeof(buffer))) > 0) {
+        result.output.append(buffer, static_cast<std::size_t>(got));
+    }
+    std::fclose(file);
+
+    result.passed = status != -1 && WIFEXITED(status) &&
+                    WEXITSTATUS(status) == 0;
+    if (status == -1) {
+        result.output += "\033[1;31mCannot fork the test case\033[0m\n";
+    } else if (WIFSIGNALED(status)) {
+        result.output += "\033[1;31mKilled by signal " +
+                         std::to_string(WTERMSIG(status)) + " (" +
+                         strsignal(WTERMSIG(status)) + ")\033[0m\n";
+    }
+    return result;
+}
+
+int TestManager::run_tests(const RunOptions &options) {
+    std::sort(test_cases.begin(), test_cases.end());
+    std::vector<const TestCase *> selected;
+    for (const auto &test_case : test_cases) {
+        if (test_case.benchmark == options.benchmarks &&
+            test_case.name.find(options.filter) != std::string::npos) {
+            selected.push_back(&test_case);
+        }
+    }
+
+    // serial test cases and benchmarks go alone, after the others
+    std::stable_partition(
+        selected.begin(), selected.end(),
+        [](const TestCase *test_case) { return !test_case->serial; }
+    );
+    std::size_t parallel = static_cast<std::size_t>(std::count_if(
+        selected.begin(), selected.end(),
+        [](const TestCase *test_case) { return !test_case->serial; }
+    ));
+    unsigned jobs = std::max(options.jobs, 1U);
+    jobs = std::min<unsigned>(jobs, std::max<std::size_t>(parallel, 1));
+
+    std::vector<TestResult> results(selected.size());
+    std::atomic<std::size_t> next{0};
+    std::mutex print_mutex;
+    auto worker = [&](std::size_t end) {
+        std::size_t i;
+        while ((i = next.fetch_add(1)) < end) {
+            const auto &test_case = *selected[i];
+            auto &result = results[i];
+            result = options.fork ? run_forked(test_case)
+                                  : run_test_case(test_case);
+
+            std::lock_guard lock(print_mutex);
+            std::cerr << result.output;
+            if (result.passed) {
+                std::cerr << "\033[1;32m[PASS]\033[0m ";
+            } else {
+                std::cerr << "\033[1;31m[FAIL]\033[0m ";
+            }
+            std::cerr << test_case.name << " ("
+                      << format_seconds(result.seconds) << ")" << std::endl;
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned j = 1; j < jobs; ++j) {
+        workers.emplace_back(worker, parallel);
+    }
+    worker(parallel);
+    for (auto &thread : workers) {
+        thread.join();
+    }
+    next.store(parallel);
+    worker(selected.size());
+    double elapsed = seconds_since(start);
+
+    std::size_t tests_total = selected.size();
+    std::size_t tests_passed = 0;
+    std::vector<std::size_t> order;
+    for (std::size_t i = 0; i < tests_total; ++i) {
+        tests_passed += results[i].passed ? 1 : 0;
+        order.push_back(i);
+    }
+
+    // Slowest test cases
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return results[a].seconds > results[b].seconds;
+    });
+    if (!options.benchmarks && tests_total > SLOWEST_SHOWN) {
+        std::cerr << "\nSlowest:\n";
+        for (std::size_t i = 0; i < SLOWEST_SHOWN; ++i) {
+            std::cerr << "    " << format_seconds(results[order[i]].seconds)
+                      << "  " << selected[order[i]]->name << "\n";
         }
     }
 
     // Summary
-    if (tests_passed == tests_total) {
-        std::cerr << "\n\033[1;32m===== All tests passed: " \
-                  << tests_passed << "/" << tests_total << " =====\033[0m" << std::endl;
-    } else {
-        std::cerr << "\n\033[1;31m===== Tests passed: " \
-                  << tests_passed << "/" << tests_total << " =====\033[0m" << std::endl;
+    std::size_t orphans;
+    {
+        std::lock_guard lock(runs_mutex);
+        orphans = orphan_failures;
+    }
+    if (orphans > 0) {
+        std::cerr << "\n\033[1;31m" << orphans
+                  << " check(s) failed outside the test cases\033[0m\n";
     }
-    return tests_passed == tests_total ? 0 : 1;
+    bool all = tests_passed == tests_total && orphans == 0;
+    const char *kind = options.benchmarks ? (all ? "benchmarks" : "Benchmarks")
+                                          : (all ? "tests" : "Tests");
+    std::cerr << (all ? "\n\033[1;32m===== All " : "\n\033[1;31m===== ")
+              << kind << " passed: " << tests_passed << "/" << tests_total
+              << " in " << format_seconds(elapsed) << ", " << jobs
+              << (jobs == 1 ? " worker" : " workers")
+              << (options.fork ? ", forked" : "") << " =====\033[0m"
+              << std::endl;
+    return all ? 0 : 1;
 }
 }  // namespace mytest
 
-int main() {
-    return ::mytest::get_test_manager().run_tests();
-}
\ No newline at end of file
+int main(int argc, char *argv[]) {
+    ::mytest::RunOptions options;
+    options.jobs = std::max(std::thread::hardware_concurrency(), 1U);
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if ((arg == "-j" || arg == "--jobs") && has_value) {
+            options.jobs = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--fork") {
+            options.fork = true;
+        } else if (arg == "--bench") {
+            options.benchmarks = true;
+        } else if (arg == "--samples" && has_value) {
+            ::mytest::detail::set_samples(
+                static_cast<unsigned>(std::stoul(argv[++i]))
+            );
+        } else if (arg.rfind('-', 0) != 0 && options.filter.empty()) {
+            options.filter = arg;
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [-j N] [--fork] [--bench] [--samples N] [FILTER]\n"
+                         "Runs the test cases whose names contain FILTER on N"
+                         " workers (one per core by default), each in its own"
+                         " process with --fork. --bench runs the benchmarks"
+                         " instead, one at a time, taking N samples.\n";
+            return 1;
+        }
+    }
+    return ::mytest::get_test_manager().run_tests(options);
+}
@@ -0,0 +1,160 @@
+#include <unistd.h>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <loggerlib/logger.hpp>
+#include <loggerlib/pattern.hpp>
+#include <mytest.hpp>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+using namespace loggerlib;
+
+namespace {
+
+// 2024-03-05 07:08:09.042 local time
+std::int64_t sample_timestamp_ms() {
+    std::tm tm{};
+    tm.tm_year = 2024 - 1900;
+    tm.tm_mon = 2;
+    tm.tm_mday = 5;
+    tm.tm_hour = 7;
+    tm.tm_min = 8;
+    tm.tm_sec = 9;
+    tm.tm_isdst = -1;
+    return static_cast<std::int64_t>(std::mktime(&tm)) * 1000 + 42;
+}
+
+std::string render(const Pattern &pattern, LineFields fields) {
+    std::string out;
+    pattern.format(out, fields);
+    return out;
+}
+
+}  // namespace
+
+TEST_CASE("Pattern default layout matches the original line format") {
+    Pattern pattern;
+    auto ts = sample_timestamp_ms();
+    CHECK(
+        render(pattern, {"hello", LogLevel::INFO, ts}) ==
+        "[2024-03-05 07:08:09] INFO:  hello\n"
+    );
+    CHECK(
+        render(pattern, {"boom", LogLevel::ERROR, ts}) ==
+        "[2024-03-05 07:08:09] ERROR: boom\n"
+    );
+    CHECK(
+        render(pattern, {"x", LogLevel::DEBUG, ts}) ==
+        "[2024-03-05 07:08:09] DEBUG: x\n"
+    );
+}
+
+TEST_CASE("Pattern renders milliseconds, thread, pid and name") {
+    Pattern pattern("%Y-%m-%d %H:%M:%S.%e [%t] %P %n %l| %v 100%%");
+    CHECK(pattern.str() == "%Y-%m-%d %H:%M:%S.%e [%t] %P %n %l| %v 100%%");
+
+    auto line = render(
+        pattern, {"msg", LogLevel::INFO, sample_timestamp_ms(), 77, "app"}
+    );
+    CHECK(
+        line == "2024-03-05 07:08:09.042 [77] " + std::to_string(getpid()) +
+                    " app INFO|  msg 100%\n"
+    );
+
+    // thread id 0 is the calling thread
+    auto own = render(Pattern("%t"), {"", LogLevel::INFO, 0});
+    CHECK(own == std::to_string(current_thread_id()) + "\n");
+}
+
+TEST_CASE("Pattern rejects unknown and trailing fields") {
+    for (const char *bad : {"%q", "abc %"}) {
+        try {
+            Pattern pattern(bad);
+            CHECK_MESSAGE(false, "Invalid pattern was accepted");
+        } catch (const std::runtime_error &e) {
+            CHECK(std::string(e.what()).rfind("Invalid log pattern", 0) == 0);
+        }
+    }
+}
+
+TEST_CASE("compile_pattern matches the runtime Pattern") {
+    static constexpr auto LAYOUT = compile_pattern("%H:%M:%S.%e %l %v");
+    static_assert(LAYOUT.op_count == 10);
+
+    LineFields fields{"same", LogLevel::DEBUG, sample_timestamp_ms()};
+    std::string out;
+    LAYOUT.format(out, fields);
+    CHECK(out == render(Pattern("%H:%M:%S.%e %l %v"), fields));
+    CHECK(out == "07:08:09.042 DEBUG same\n");
+
+    // every level field takes three padded names, the text grows past the
+    // pattern length several times
+    static constexpr auto LEVELS = compile_pattern("%l%l%l%l%l%l%l%l%l|");
+    static_assert(LEVELS.text_length == 9 * 15 + 4);
+    out.clear();
+    LEVELS.format(out, fields);
+    CHECK(out == render(Pattern("%l%l%l%l%l%l%l%l%l|"), fields));
+}
+
+TEST_CASE("Logger writes lines with a custom pattern") {
+    const std::string filepath = "temp_logger_pattern.txt";
+    {
+        Logger logger(filepath, LogLevel::INFO);
+        logger.set_name("worker");
+        logger.set_pattern("%n %l %v");
+        logger.log("sync", LogLevel::INFO);
+
+        logger.enable_async();
+        logger.log("async", LogLevel::INFO);
+        logger.flush();
+
+        try {
+            logger.set_pattern("%Z");
+            CHECK_MESSAGE(false, "Invalid pattern was accepted");
+        } catch (const std::runtime_error &) {
+        }
+        logger.log("kept", LogLevel::ERROR);
+    }
+
+    std::ifstream f(filepath);
+    std::string content((std::istreambuf_iterator<char>(f)), {});
+    CHECK(content == "worker INFO  sync\nworker INFO  async\nworker ERROR kept\n");
+    fs::remove(filepath);
+}
+
+TEST_CASE("Logger changes the pattern while the backend writes") {
+    const std::string filepath = "temp_logger_pattern_switch.txt";
+    const int messages = 2000;
+    {
+        Logger logger(filepath, LogLevel::INFO);
+        AsyncOptions options;
+        options.batch_size = 8;
+        logger.enable_async(options);
+
+        std::thread producer([&logger]() {
+            for (int i = 0; i < messages; ++i) {
+                logger.log("message", LogLevel::INFO);
+            }
+        });
+        for (int i = 0; i < 200; ++i) {
+            logger.set_pattern(i % 2 ? "%l %v" : "%n: %l %v");
+            logger.set_name("worker " + std::to_string(i));
+        }
+        producer.join();
+    }
+
+    std::ifstream f(filepath);
+    std::regex line_re(R"((worker \d+: )?INFO  message)");
+    std::string line;
+    int lines = 0;
+    while (std::getline(f, line)) {
+        CHECK(std::regex_match(line, line_re));
+        ++lines;
+    }
+    CHECK(lines == messages);
+    fs::remove(filepath);
+}
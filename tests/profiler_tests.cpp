@@ -0,0 +1,121 @@
+#include <atomic>
+#include <filesystem>
+#include <loggerlib/executor.hpp>
+#include <loggerlib/logger.hpp>
+#include <loggerlib/profiler.hpp>
+#include <loggerlib/task.hpp>
+#include <mytest.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace loggerlib;
+
+namespace {
+
+const CallSite *find_site(const std::vector<CallSite> &sites, unsigned line) {
+    for (const auto &site : sites) {
+        if (site.line == line && site.file.find("profiler_tests.cpp") !=
+                                     std::string::npos) {
+            return &site;
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+TEST_CASE_SERIAL(
+    "Profiler counts calls, filtered calls and bytes per call site"
+) {
+    const std::string filepath = "temp_logger_profiler.txt";
+    {
+        Logger logger(filepath, LogLevel::INFO);
+        Profiler::reset();
+        Profiler::enable();
+
+        // every thread stores the same lines
+        std::atomic<unsigned> eager_line{0};
+        std::atomic<unsigned> macro_line{0};
+        std::atomic<unsigned> stream_line{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&]() {
+                for (int i = 0; i < 100; ++i) {
+                    auto level = i % 2 ? LogLevel::INFO : LogLevel::DEBUG;
+                    eager_line = __LINE__ + 1;
+                    logger.log("0123456789", level);
+                    macro_line = __LINE__ + 1;
+                    LOGGERLIB_DEBUG(logger, "never");
+                    stream_line = __LINE__ + 1;
+                    logger.info() << "id=" << i;
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        Profiler::disable();
+        logger.log("not counted", LogLevel::INFO);
+
+        auto sites = Profiler::top(100);
+        const auto *eager = find_site(sites, eager_line.load());
+        const auto *macro = find_site(sites, macro_line.load());
+        const auto *stream = find_site(sites, stream_line.load());
+        CHECK(eager && macro && stream);
+        if (eager && macro && stream) {
+            CHECK(eager->calls == 200);
+            CHECK(eager->filtered == 200);
+            CHECK(eager->bytes == 2000);
+            CHECK(eager->cycles > 0);
+            CHECK(macro->calls == 0);
+            CHECK(macro->filtered == 400);
+            CHECK(stream->calls == 400);
+            CHECK(!stream->function.empty());
+        }
+        for (std::size_t i = 1; i < sites.size(); ++i) {
+            CHECK(sites[i - 1].cycles >= sites[i].cycles);
+        }
+
+        // test cases run in parallel may add sites of their own
+        std::ostringstream report;
+        Profiler::report(report, sites.size());
+        CHECK(report.str().find("profiler_tests.cpp:") != std::string::npos);
+
+        Profiler::reset();
+        CHECK(Profiler::top().empty());
+    }
+    fs::remove(filepath);
+}
+
+TEST_CASE_SERIAL("Profiler puts log_async written by log() at its call site") {
+    const std::string filepath = "temp_logger_profiler_async.txt";
+    {
+        Logger logger(filepath, LogLevel::INFO);
+        Profiler::reset();
+        Profiler::enable();
+
+        // synchronous mode falls back to log()
+        unsigned line = 0;
+        auto produce = [&]() -> Task {
+            line = __LINE__ + 1;
+            co_await logger.log_async("0123456789", LogLevel::INFO);
+        };
+        EventLoop loop;
+        loop.post([&] { produce(); });
+        loop.poll();
+        Profiler::disable();
+
+        auto sites = Profiler::top(100);
+        const auto *site = find_site(sites, line);
+        CHECK(site != nullptr);
+        if (site) {
+            CHECK(site->calls == 1);
+            CHECK(site->bytes == 10);
+        }
+        Profiler::reset();
+    }
+    fs::remove(filepath);
+}
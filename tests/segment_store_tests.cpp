@@ -0,0 +1,197 @@
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <csignal>
+#include <filesystem>
+#include <loggerlib/segment_store.hpp>
+#include <mytest.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace loggerlib;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<wire::Record> make_records(int count, LogLevel level, int from) {
+    std::vector<wire::Record> records;
+    for (int i = 0; i < count; ++i) {
+        wire::Record record;
+        record.level = level;
+        record.timestamp_ms = 1'750'000'000'000 + (from + i) * 1000;
+        record.message = "message " + std::to_string(from + i) + "\n";
+        records.push_back(std::move(record));
+    }
+    return records;
+}
+
+}  // namespace
+
+TEST_CASE("SegmentStore rebuilds its summary from segment footers") {
+    const std::string dir = "temp_segments";
+    fs::remove_all(dir);
+
+    SegmentStoreOptions options;
+    options.segment_size = 4096;
+    {
+        SegmentStore store(dir, options);
+        // group commits of concurrent appends
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&store, t]() {
+                for (int i = 0; i < 50; ++i) {
+                    store.append(make_records(
+                        5, t == 0 ? LogLevel::ERROR : LogLevel::INFO,
+                        t * 1000 + i * 5
+                    ));
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        CHECK(store.summary().records == 1000);
+    }
+
+    {
+        SegmentStore store(dir, options);
+        auto segments = store.segments();
+        CHECK(segments.size() > 2);
+
+        std::size_t read = 0;
+        std::uint64_t last_seq = 0;
+        bool ordered = true;
+        for (const auto &path : segments) {
+            // all but the one just opened are sealed
+            CHECK(
+                path == segments.back() ||
+                segment::read_footer(path).has_value()
+            );
+            for (const auto &record : segment::read(path)) {
+                ordered = ordered && record.seq == last_seq + 1;
+                last_seq = record.seq;
+                ++read;
+            }
+        }
+        CHECK(read == 1000);
+        CHECK(ordered);
+
+        auto summary = store.summary();
+        CHECK(summary.records == 1000);
+        CHECK(summary.levels[2] == 250);
+        CHECK(summary.levels[1] == 750);
+        CHECK(summary.min_ms == 1'750'000'000'000);
+        CHECK(summary.max_ms == 1'750'000'000'000 + 3249 * 1000);
+        CHECK(summary.min_length == 10);  // "message 0\n"
+        CHECK(summary.max_length == 13);
+
+        // the next run continues the numbering
+        store.append(make_records(1, LogLevel::DEBUG, 5000));
+        CHECK(store.summary().records == 1001);
+    }
+    CHECK(SegmentStore(dir, options).summary().levels[0] == 1);
+
+    fs::remove_all(dir);
+}
+
+TEST_CASE("SegmentStore seals a segment cut short by a crash") {
+    const std::string dir = "temp_segments_crash";
+    const std::string copy_dir = "temp_segments_crash_copy";
+    fs::remove_all(dir);
+    fs::remove_all(copy_dir);
+    fs::create_directories(copy_dir);
+
+    SegmentStoreOptions options;
+    options.fsync = FsyncPolicy::COMMIT;
+    {
+        SegmentStore store(dir, options);
+        store.append(make_records(10, LogLevel::INFO, 0));
+        store.append(make_records(10, LogLevel::ERROR, 10));
+
+        // the open segment as a crash leaves it, the last frame torn
+        auto path = store.segments().back();
+        auto copy = copy_dir + "/" + fs::path(path).filename().string();
+        fs::copy_file(path, copy);
+        fs::resize_file(copy, fs::file_size(copy) - 3);
+        CHECK(!segment::read_footer(copy).has_value());
+        CHECK(segment::read(copy).size() == 10);
+    }
+
+    {
+        SegmentStore store(copy_dir, options);
+        auto summary = store.summary();
+        CHECK(summary.records == 10);
+        CHECK(summary.levels[1] == 10);
+        CHECK(segment::read_footer(store.segments().front()).has_value());
+    }
+
+    fs::remove_all(dir);
+    fs::remove_all(copy_dir);
+}
+
+TEST_CASE("SegmentStore keeps the segment whose rotation failed") {
+    const std::string dir = "temp_segments_full";
+    fs::remove_all(dir);
+
+    SegmentStoreOptions options;
+    options.segment_size = 4096;
+    options.fsync = FsyncPolicy::COMMIT;
+
+    // the child can't grow a file past the segment size, so the commit
+    // that crosses it fails; the exit code is the batches stored
+    pid_t pid = fork();
+    if (pid == 0) {
+        int stored = 0;
+        try {
+            std::signal(SIGXFSZ, SIG_IGN);
+            rlimit limit{options.segment_size, options.segment_size};
+            setrlimit(RLIMIT_FSIZE, &limit);
+            SegmentStore store(dir, options);
+            for (; stored < 200; ++stored) {
+                store.append(make_records(5, LogLevel::INFO, stored * 5));
+            }
+        } catch (const std::runtime_error &) {
+        }
+        _exit(stored);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    CHECK(WIFEXITED(status));
+    int batches = WEXITSTATUS(status);
+    CHECK(batches > 0 && batches < 200);
+
+    {
+        SegmentStore store(dir, options);
+        std::size_t read = 0;
+        for (const auto &path : store.segments()) {
+            read += segment::read(path).size();
+        }
+        CHECK(read == static_cast<std::size_t>(batches) * 5);
+        CHECK(store.summary().records == read);
+    }
+
+    fs::remove_all(dir);
+}
+
+TEST_CASE("SegmentSummary counts records per minute") {
+    SegmentSummary first;
+    SegmentSummary second;
+    const std::int64_t hour = 1'750'000'000'000 / 3'600'000 * 3'600'000;
+    first.add(LogLevel::INFO, hour + 10, 5);
+    first.add(LogLevel::INFO, hour + 59'999, 7);
+    second.add(LogLevel::DEBUG, hour + 60'000, 3);
+    second.add(LogLevel::ERROR, hour + 3'600'000, 9);
+    first.merge(second);
+
+    CHECK(first.records == 4);
+    CHECK(first.minutes.size() == 3);
+    CHECK(first.since(hour) == 4);
+    CHECK(first.since(hour + 30'000) == 4);  // whole minutes
+    CHECK(first.since(hour + 60'000) == 2);
+    CHECK(first.since(hour + 3'600'001) == 1);
+    CHECK(first.min_length == 3);
+    CHECK(first.max_length == 9);
+    CHECK(first.bytes == 24);
+}
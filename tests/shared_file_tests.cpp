@@ -0,0 +1,152 @@
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <loggerlib/logger.hpp>
+#include <map>
+#include <mytest.hpp>
+#include <string>
+#include <vector>
+
+using namespace loggerlib;
+
+namespace {
+
+// Record i of a writer, every 40th is long enough to be chunked
+std::string shared_record(int pid, int i) {
+    std::size_t length = i % 40 == 0 ? 3 * SHARED_WRITE_SIZE : 16 + i % 200;
+    return "pid=" + std::to_string(pid) + " i=" + std::to_string(i) + " " +
+           std::string(length, static_cast<char>('a' + i % 26));
+}
+
+bool ends_with(const std::string &text, std::string_view suffix) {
+    return text.size() >= suffix.size() &&
+           text.compare(text.size() - suffix.size(), suffix.size(), suffix) ==
+               0;
+}
+
+// Glue chunked records back together, keyed by the writer's pid
+std::map<int, std::vector<std::string>>
+reassemble(const std::string &filepath, bool &well_formed) {
+    std::map<int, std::vector<std::string>> records;
+    std::map<int, std::string> open;
+    std::ifstream file(filepath);
+    std::string line;
+    well_formed = true;
+
+    while (std::getline(file, line)) {
+        well_formed &= line.size() < SHARED_WRITE_SIZE;
+        int pid = 0;
+        std::string body;
+        if (!line.empty() && line[0] == '+') {
+            auto space = line.find(' ');
+            pid = std::stoi(line.substr(1, space - 1));
+            well_formed &= open.count(pid) == 1;
+            body = open[pid] + line.substr(space + 1);
+            open.erase(pid);
+        } else if (line.rfind("pid=", 0) == 0) {
+            pid = std::stoi(line.substr(4));
+            well_formed &= open.count(pid) == 0;
+            body = line;
+        } else {
+            well_formed = false;
+            continue;
+        }
+
+        if (ends_with(body, CONTINUATION_SUFFIX)) {
+            body.resize(body.size() - CONTINUATION_SUFFIX.size());
+            open[pid] = body;
+        } else {
+            records[pid].push_back(body);
+        }
+    }
+    well_formed &= open.empty();
+    return records;
+}
+
+}  // namespace
+
+TEST_CASE("Shared file mode keeps records of forked writers whole") {
+    const std::string filepath = "temp_logger_shared.txt";
+    std::remove(filepath.c_str());
+    const int writers = 8;
+    const int records = 300;
+
+    std::vector<pid_t> children;
+    for (int w = 0; w < writers; ++w) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            int code = 0;
+            try {
+                Logger logger(filepath, LogLevel::INFO, FileMode::SHARED);
+                logger.set_pattern("%v");
+                for (int i = 0; i < records; ++i) {
+                    logger.log(shared_record(getpid(), i), LogLevel::INFO);
+                }
+            } catch (...) {
+                code = 1;
+            }
+            _exit(code);
+        }
+        children.push_back(pid);
+    }
+
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+
+    bool well_formed = false;
+    auto written = reassemble(filepath, well_formed);
+    CHECK(well_formed);
+    CHECK(written.size() == static_cast<std::size_t>(writers));
+    for (pid_t pid : children) {
+        const auto &lines = written[pid];
+        CHECK(lines.size() == static_cast<std::size_t>(records));
+        bool intact = lines.size() == static_cast<std::size_t>(records);
+        for (std::size_t i = 0; intact && i < lines.size(); ++i) {
+            intact = lines[i] == shared_record(pid, static_cast<int>(i));
+        }
+        CHECK_MESSAGE(intact, "records of " + std::to_string(pid));
+    }
+    CHECK(std::remove(filepath.c_str()) == 0);
+}
+
+TEST_CASE("Shared file mode packs async batches into whole-line writes") {
+    const std::string filepath = "temp_logger_shared_async.txt";
+    std::remove(filepath.c_str());
+    {
+        Logger logger(filepath, LogLevel::DEBUG, FileMode::SHARED);
+        logger.set_pattern("%v");
+        logger.enable_async();
+        for (int i = 0; i < 200; ++i) {
+            logger.log(shared_record(getpid(), i), LogLevel::INFO);
+        }
+        logger.flush();
+    }
+
+    bool well_formed = false;
+    auto written = reassemble(filepath, well_formed);
+    CHECK(well_formed);
+    const auto &lines = written[getpid()];
+    CHECK(lines.size() == 200);
+    bool intact = lines.size() == 200;
+    for (std::size_t i = 0; intact && i < lines.size(); ++i) {
+        intact = lines[i] == shared_record(getpid(), static_cast<int>(i));
+    }
+    CHECK(intact);
+    CHECK(std::remove(filepath.c_str()) == 0);
+}
+
+TEST_CASE("Shared file ctor throws when the file can't be opened") {
+    bool thrown = false;
+    try {
+        Logger logger(
+            "/nonexistent/dir/log.txt", LogLevel::INFO, FileMode::SHARED
+        );
+    } catch (const std::runtime_error &e) {
+        thrown = std::string(e.what()).rfind("Cannot open log file", 0) == 0;
+    }
+    CHECK(thrown);
+}
@@ -1,7 +1,9 @@
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <unistd.h>
+#include <atomic>
 #include <chrono>
 #include <cstring>
 #include <exception>
@@ -9,12 +11,16 @@
 #include <fstream>
 #include <iostream>
 #include <loggerlib/logger.hpp>
+#include <memory>
 #include <mytest.hpp>
 #include <regex>
 #include <stdexcept>
 #include <thread>
 #include <typeinfo>
 #include <vector>
+
+#include "helpers.hpp"
+
 namespace fs = std::filesystem;
 using namespace loggerlib;
 
@@ -177,7 +183,7 @@ TEST_CASE("Logger destructor closes socket") {
     int server_fd = start_test_server(port);
     std::vector<int> conn_fd_holder;
 
-    std::thread server_thread([&]() {
+    mytest::thread server_thread([&]() {
         sockaddr_in client_addr{};
         socklen_t addr_len = sizeof(client_addr);
         int conn_fd = accept(server_fd, (sockaddr *)&client_addr, &addr_len);
@@ -284,4 +290,614 @@ TEST_CASE(
     std::regex re(R"(\d{4}-\d{2}-\d{2} \d{2}:\d{2}:\d{2})");
     CHECK(std::regex_match(ts, re));
     std::remove("temp_timestamp.txt");
-}
\ No newline at end of file
+}
+TEST_CASE("Logger.log sends binary frames after negotiation") {
+    int port;
+    int server_fd = start_test_server(port);
+    std::vector<wire::Record> received;
+    std::thread server_thread([&]() {
+        int conn_fd = accept(server_fd, nullptr, nullptr);
+        char hello[wire::HELLO_SIZE];
+        recv(conn_fd, hello, sizeof(hello), MSG_WAITALL);
+        auto reply = wire::make_hello({wire::VERSION, 0});
+        send(conn_fd, reply.data(), reply.size(), 0);
+
+        wire::Decoder decoder;
+        wire::Record record;
+        char buf[1024];
+        int n;
+        while ((n = recv(conn_fd, buf, sizeof(buf), 0)) > 0) {
+            decoder.feed(buf, n);
+            while (decoder.next(record)) {
+                received.push_back(record);
+            }
+        }
+        close(conn_fd);
+        close(server_fd);
+    });
+
+    {
+        Logger logger("127.0.0.1", port, LogLevel::INFO, WireFormat::BINARY);
+        logger.log("filtered", LogLevel::DEBUG);
+        logger.log("first", LogLevel::INFO);
+        logger.log("second", LogLevel::ERROR);
+    }
+    server_thread.join();
+
+    CHECK(received.size() == 2);
+    if (received.size() == 2) {
+        CHECK(received[0].message == "first");
+        CHECK(received[0].level == LogLevel::INFO);
+        CHECK(received[1].message == "second");
+        CHECK(received[1].level == LogLevel::ERROR);
+        CHECK(received[1].seq == received[0].seq + 1);
+        CHECK(received[1].timestamp_ms >= received[0].timestamp_ms);
+    }
+}
+
+TEST_CASE("Logger binary ctor throws when server rejects protocol") {
+    int port;
+    int server_fd = start_test_server(port);
+    std::thread server_thread([&]() {
+        int conn_fd = accept(server_fd, nullptr, nullptr);
+        char hello[wire::HELLO_SIZE];
+        recv(conn_fd, hello, sizeof(hello), MSG_WAITALL);
+        auto reply = wire::make_hello({0, 0});
+        send(conn_fd, reply.data(), reply.size(), 0);
+        close(conn_fd);
+        close(server_fd);
+    });
+
+    try {
+        Logger logger("127.0.0.1", port, LogLevel::INFO, WireFormat::BINARY);
+        CHECK_MESSAGE(false, "Ctor didn't throw on rejected negotiation");
+    } catch (const std::runtime_error &e) {
+        CHECK(std::string(e.what()) == "Wire protocol negotiation failed");
+    }
+    server_thread.join();
+}
+
+TEST_CASE("Logger backtrace writes buffered messages ahead of ERROR") {
+    const std::string filepath = "temp_logger_backtrace.txt";
+    {
+        Logger logger(filepath, LogLevel::INFO);
+        logger.enable_backtrace(2);
+        logger.log("debug 1", LogLevel::DEBUG);
+        logger.log("debug 2", LogLevel::DEBUG);
+        logger.log("debug 3", LogLevel::DEBUG);
+        logger.log("info", LogLevel::INFO);
+        CHECK(read_lines(filepath).size() == 1);
+
+        logger.log("error", LogLevel::ERROR);
+        logger.log("error again", LogLevel::ERROR);
+    }
+
+    auto lines = read_lines(filepath);
+    CHECK(lines.size() == 5);
+    if (lines.size() == 5) {
+        CHECK(std::regex_match(lines[0], std::regex(R"(\[.*\] INFO:  info)")));
+        CHECK(std::regex_match(
+            lines[1], std::regex(R"(\[.*\] DEBUG: debug 2)")
+        ));
+        CHECK(std::regex_match(
+            lines[2], std::regex(R"(\[.*\] DEBUG: debug 3)")
+        ));
+        CHECK(std::regex_match(lines[3], std::regex(R"(\[.*\] ERROR: error)")));
+    }
+    CHECK(std::remove(filepath.c_str()) == 0);
+}
+
+TEST_CASE("Logger backtrace collects other threads and can be disabled") {
+    const std::string filepath = "temp_logger_backtrace_mt.txt";
+    {
+        Logger logger(filepath, LogLevel::ERROR);
+        logger.enable_backtrace(8);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&logger, t]() {
+                logger.log("from " + std::to_string(t), LogLevel::INFO);
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        logger.dump_backtrace();
+        CHECK(read_lines(filepath).size() == 4);
+
+        logger.disable_backtrace();
+        logger.log("not buffered", LogLevel::DEBUG);
+        logger.log("error", LogLevel::ERROR);
+    }
+
+    CHECK(read_lines(filepath).size() == 5);
+    CHECK(std::remove(filepath.c_str()) == 0);
+}
+
+TEST_CASE("Logger backtrace signal-safe dump uses the line format") {
+    const std::string filepath = "temp_logger_backtrace_sig.txt";
+    const std::string dumppath = "temp_logger_backtrace_dump.txt";
+    {
+        Logger logger(filepath, LogLevel::ERROR);
+        logger.enable_backtrace(4);
+        logger.log("before crash", LogLevel::DEBUG);
+        logger.log(std::string(1000, 'x'), LogLevel::INFO);
+
+        std::ofstream(dumppath).close();
+        int fd = ::open(dumppath.c_str(), O_WRONLY);
+        logger.dump_backtrace_signal_safe(fd);
+        ::close(fd);
+    }
+
+    auto lines = read_lines(dumppath);
+    CHECK(lines.size() == 2);
+    if (lines.size() == 2) {
+        CHECK(std::regex_match(
+            lines[0],
+            std::regex(
+                R"(\[\d{4}-\d{2}-\d{2} \d{2}:\d{2}:\d{2}\] DEBUG: before crash)"
+            )
+        ));
+        CHECK(std::regex_match(lines[1], std::regex(R"(\[.*\] INFO:  x+\.\.\.)"))
+        );
+        // same timestamp rendering as the regular path
+        CHECK(lines[0].substr(1, 10) ==
+              Logger(filepath).get_current_timestamp().substr(0, 10));
+    }
+    CHECK(std::remove(filepath.c_str()) == 0);
+    CHECK(std::remove(dumppath.c_str()) == 0);
+}
+
+TEST_CASE("Logger lazy API builds messages only when the level passes") {
+    const std::string filepath = "temp_logger_lazy.txt";
+    int evaluated = 0;
+    auto make = [&evaluated](const std::string &text) {
+        ++evaluated;
+        return text;
+    };
+    {
+        Logger logger(filepath, LogLevel::INFO);
+
+        SUBCASE("Callable overload") {
+            logger.log([&] { return make("lazy debug"); }, LogLevel::DEBUG);
+            logger.log([&] { return make("lazy info"); }, LogLevel::INFO);
+            CHECK(evaluated == 1);
+        }
+
+        SUBCASE("Macros") {
+            LOGGERLIB_DEBUG(logger, make("macro debug"));
+            LOGGERLIB_ERROR(logger, make("macro error"));
+            CHECK(evaluated == 1);
+        }
+
+        SUBCASE("Stream form") {
+            logger.debug() << "stream debug " << 1;
+            logger.info() << "stream info " << std::hex << 255;
+            logger.info() << "stream info " << 255;
+        }
+    }
+
+    auto lines = read_lines(filepath);
+    bool ok = lines.size() == 1 || lines.size() == 2;
+    CHECK(ok);
+    if (lines.size() == 1) {
+        CHECK(
+            std::regex_match(lines[0], std::regex(R"(\[.*\] INFO:  lazy info)")) ||
+            std::regex_match(
+                lines[0], std::regex(R"(\[.*\] ERROR: macro error)")
+            )
+        );
+    } else if (lines.size() == 2) {
+        // manipulators don't leak into the next message
+        CHECK(std::regex_match(
+            lines[0], std::regex(R"(\[.*\] INFO:  stream info ff)")
+        ));
+        CHECK(std::regex_match(
+            lines[1], std::regex(R"(\[.*\] INFO:  stream info 255)")
+        ));
+    }
+    CHECK(std::remove(filepath.c_str()) == 0);
+}
+
+TEST_CASE("Logger.is_enabled follows level and backtrace mode") {
+    const std::string filepath = "temp_logger_enabled.txt";
+    Logger logger(filepath, LogLevel::INFO);
+    CHECK(!logger.is_enabled(LogLevel::DEBUG));
+    CHECK(logger.is_enabled(LogLevel::INFO));
+    logger.enable_backtrace(4);
+    CHECK(logger.is_enabled(LogLevel::DEBUG));
+    std::remove(filepath.c_str());
+}
+
+TEST_CASE("Logger async mode writes ERROR through ahead of queued messages") {
+    const std::string filepath = "temp_logger_lanes.txt";
+    {
+        Logger logger(filepath, LogLevel::DEBUG);
+        AsyncOptions options;
+        options.flush_interval = std::chrono::seconds(10);
+        logger.enable_async(options);
+
+        logger.log("queued debug", LogLevel::DEBUG);
+        logger.log("queued info", LogLevel::INFO);
+        logger.log("urgent", LogLevel::ERROR);
+
+        auto lines = read_lines(filepath);
+        CHECK(lines.size() == 1);
+        if (lines.size() == 1) {
+            CHECK(std::regex_match(
+                lines[0], std::regex(R"(\[.*\] ERROR: urgent)")
+            ));
+        }
+
+        logger.flush();
+        lines = read_lines(filepath);
+        CHECK(lines.size() == 3);
+        if (lines.size() == 3) {
+            CHECK(std::regex_match(
+                lines[1], std::regex(R"(\[.*\] DEBUG: queued debug)")
+            ));
+            CHECK(std::regex_match(
+                lines[2], std::regex(R"(\[.*\] INFO:  queued info)")
+            ));
+        }
+    }
+    CHECK(std::remove(filepath.c_str()) == 0);
+}
+
+TEST_CASE("Logger async lanes apply overflow policies") {
+    const std::string filepath = "temp_logger_overflow.txt";
+    AsyncOptions options;
+    options.flush_interval = std::chrono::seconds(10);
+    options.batch_size = 100;
+
+    // nothing is written until the logger is destroyed
+    BackendOptions manual_options;
+    manual_options.threads = 0;  // nothing drains but flush()
+    Backend manual(manual_options);
+    options.backend = &manual;
+
+    SUBCASE("Drop newest") {
+        {
+            options.lanes[0] = {2, OverflowPolicy::DROP_NEWEST, false};
+            Logger logger(filepath, LogLevel::DEBUG);
+            logger.enable_async(options);
+            for (int i = 0; i < 5; ++i) {
+                logger.log("debug " + std::to_string(i), LogLevel::DEBUG);
+            }
+            CHECK(logger.dropped(LogLevel::DEBUG) == 3);
+        }
+        auto lines = read_lines(filepath);
+        CHECK(lines.size() == 2);
+        if (lines.size() == 2) {
+            CHECK(std::regex_match(lines[1], std::regex(R"(.* debug 1)")));
+        }
+    }
+
+    SUBCASE("Drop oldest") {
+        {
+            options.lanes[0] = {2, OverflowPolicy::DROP_OLDEST, false};
+            Logger logger(filepath, LogLevel::DEBUG);
+            logger.enable_async(options);
+            for (int i = 0; i < 5; ++i) {
+                logger.log("debug " + std::to_string(i), LogLevel::DEBUG);
+            }
+            CHECK(logger.dropped(LogLevel::DEBUG) == 3);
+        }
+        auto lines = read_lines(filepath);
+        CHECK(lines.size() == 2);
+        if (lines.size() == 2) {
+            CHECK(std::regex_match(lines[0], std::regex(R"(.* debug 3)")));
+        }
+    }
+
+    SUBCASE("Block loses nothing") {
+        {
+            options.lanes[1] = {1, OverflowPolicy::BLOCK, false};
+            options.flush_interval = std::chrono::milliseconds(1);
+            options.backend = nullptr;
+            Logger logger(filepath, LogLevel::DEBUG);
+            logger.enable_async(options);
+
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 4; ++t) {
+                threads.emplace_back([&logger]() {
+                    for (int i = 0; i < 50; ++i) {
+                        logger.log("info", LogLevel::INFO);
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            CHECK(logger.dropped(LogLevel::INFO) == 0);
+        }
+        CHECK(read_lines(filepath).size() == 200);
+    }
+
+    CHECK(std::remove(filepath.c_str()) == 0);
+}
+
+TEST_CASE("Backend drains many loggers with a few threads") {
+    const int loggers_count = 8;
+    const int messages = 2000;
+    std::vector<std::string> paths;
+    {
+        BackendOptions backend_options;
+        backend_options.threads = 2;
+        backend_options.cpu_affinity = {0};
+        Backend backend(backend_options);
+        CHECK(backend.threads() == 2);
+
+        AsyncOptions options;
+        options.backend = &backend;
+        options.batch_size = 64;
+
+        std::vector<std::unique_ptr<Logger>> loggers;
+        for (int i = 0; i < loggers_count; ++i) {
+            paths.push_back("temp_backend_" + std::to_string(i) + ".txt");
+            loggers.push_back(std::make_unique<Logger>(paths.back()));
+            loggers.back()->enable_async(options);
+        }
+
+        std::vector<std::thread> producers;
+        for (int i = 0; i < loggers_count; ++i) {
+            producers.emplace_back([&, i]() {
+                // logger 0 is busy, the rest are quiet
+                int count = i == 0 ? messages : messages / 20;
+                for (int j = 0; j < count; ++j) {
+                    loggers[i]->log("message", LogLevel::INFO);
+                }
+            });
+        }
+        for (auto &producer : producers) {
+            producer.join();
+        }
+
+        CHECK(backend.shutdown(std::chrono::seconds(10)));
+        for (int i = 0; i < loggers_count; ++i) {
+            std::size_t expected = i == 0 ? messages : messages / 20;
+            CHECK(read_lines(paths[i]).size() == expected);
+        }
+    }
+    for (const auto &path : paths) {
+        CHECK(std::remove(path.c_str()) == 0);
+    }
+}
+
+TEST_CASE("Backend ticks don't outlive async mode of a logger") {
+    const std::string filepath = "temp_backend_ticks.txt";
+    const int rounds = 300;
+    {
+        // threads look for due loggers nonstop
+        BackendOptions backend_options;
+        backend_options.threads = 2;
+        backend_options.tick = std::chrono::milliseconds(0);
+        Backend backend(backend_options);
+
+        AsyncOptions options;
+        options.backend = &backend;
+        options.flush_interval = std::chrono::milliseconds(0);
+
+        Logger logger(filepath);
+        for (int i = 0; i < rounds; ++i) {
+            logger.enable_async(options);
+            logger.log("round " + std::to_string(i), LogLevel::INFO);
+            logger.log("again", LogLevel::INFO);
+            logger.disable_async();
+        }
+    }
+    CHECK(read_lines(filepath).size() == 2 * rounds);
+    CHECK(std::remove(filepath.c_str()) == 0);
+}
+
+TEST_CASE("Backend leaves full lanes to the producers after shutdown") {
+    const std::string before = "temp_backend_shutdown_before.txt";
+    const std::string after = "temp_backend_shutdown_after.txt";
+    const int messages = 500;
+    {
+        Backend backend;
+        AsyncOptions options;
+        options.backend = &backend;
+        options.flush_interval = std::chrono::seconds(10);
+        options.lanes[1] = {8, OverflowPolicy::BLOCK, false};
+
+        Logger attached(before);
+        attached.enable_async(options);
+        attached.log("queued", LogLevel::INFO);
+        CHECK(backend.shutdown(std::chrono::milliseconds::max()));
+
+        // no thread drains the lanes, BLOCK producers must not wait forever
+        Logger late(after);
+        late.enable_async(options);
+        std::vector<std::thread> producers;
+        for (auto *logger : {&attached, &late}) {
+            producers.emplace_back([logger]() {
+                for (int i = 0; i < messages; ++i) {
+                    logger->log("message", LogLevel::INFO);
+                }
+            });
+        }
+        for (auto &producer : producers) {
+            producer.join();
+        }
+    }
+    CHECK(read_lines(before).size() == messages + 1);
+    CHECK(read_lines(after).size() == messages);
+    CHECK(std::remove(before.c_str()) == 0);
+    CHECK(std::remove(after.c_str()) == 0);
+}
+
+TEST_CASE("Logger switches async mode while other threads log") {
+    const std::string filepath = "temp_logger_switch.txt";
+    const int producers_count = 3;
+    const int messages = 20000;
+    {
+        Logger logger(filepath);
+        AsyncOptions options;
+        options.batch_size = 16;
+        options.lanes[1].capacity = 32;  // producers block now and then
+
+        std::atomic<int> running{producers_count};
+        std::vector<std::thread> producers;
+        for (int t = 0; t < producers_count; ++t) {
+            producers.emplace_back([&]() {
+                for (int i = 0; i < messages; ++i) {
+                    logger.log("message", LogLevel::INFO);
+                }
+                running.fetch_sub(1);
+            });
+        }
+        while (running.load() > 0) {
+            logger.enable_async(options);
+            std::this_thread::yield();
+            logger.disable_async();
+        }
+        for (auto &producer : producers) {
+            producer.join();
+        }
+    }
+    CHECK(read_lines(filepath).size() == producers_count * messages);
+    CHECK(std::remove(filepath.c_str()) == 0);
+}
+
+TEST_CASE("Logger flush waits for batches a Backend thread is writing") {
+    const std::string filepath = "temp_logger_flush_race.txt";
+    const int rounds = 200;
+    const int per_round = 4;
+    // long messages keep a Backend thread formatting a batch it took for a
+    // while, the yield lets flush() come in between
+    const std::string message(256 * 1024, 'x');
+    {
+        BackendOptions backend_options;
+        backend_options.threads = 2;
+        Backend backend(backend_options);
+
+        AsyncOptions options;
+        options.backend = &backend;
+        options.batch_size = 1;
+
+        Logger logger(filepath);
+        logger.set_pattern("%v");
+        logger.enable_async(options);
+
+        int short_flushes = 0;
+        for (int i = 0; i < rounds; ++i) {
+            for (int j = 0; j < per_round; ++j) {
+                logger.log(message, LogLevel::INFO);
+            }
+            std::this_thread::yield();
+            logger.flush();
+            auto expected = (i + 1) * per_round * (message.size() + 1);
+            short_flushes += fs::file_size(filepath) != expected;
+        }
+        CHECK(short_flushes == 0);
+    }
+    CHECK(std::remove(filepath.c_str()) == 0);
+}
+
+TEST_CASE("Logger async mode drains buffers of exited threads") {
+    const std::string filepath = "temp_logger_staging.txt";
+    {
+        Logger logger(filepath, LogLevel::DEBUG);
+        AsyncOptions options;
+        options.batch_size = 16;
+        logger.enable_async(options);
+
+        for (int round = 0; round < 10; ++round) {
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 8; ++t) {
+                threads.emplace_back([&logger]() {
+                    for (int i = 0; i < 25; ++i) {
+                        logger.log("staged", LogLevel::INFO);
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+        }
+        logger.flush();
+    }
+
+    auto lines = read_lines(filepath);
+    CHECK(lines.size() == 2000);
+    CHECK(std::remove(filepath.c_str()) == 0);
+}
+
+TEST_CASE_SERIAL(
+    "Logger sheds DEBUG, then INFO under backlog and recovers"
+) {
+    const std::string filepath = "temp_logger_shedding.txt";
+    {
+        // nothing is drained unless the test flushes
+        BackendOptions manual_options;
+        manual_options.threads = 0;  // nothing drains but flush()
+        Backend manual(manual_options);
+
+        AsyncOptions async_options;
+        async_options.backend = &manual;
+        SheddingOptions options;
+        options.backlog_budget = 10;
+        options.interval = std::chrono::milliseconds(1);
+        options.recovery = std::chrono::milliseconds(5);
+
+        Logger logger(filepath, LogLevel::DEBUG);
+        logger.set_pattern("%l %v");
+        logger.enable_async(async_options);
+        logger.enable_shedding(options);
+
+        auto log_for = [&](LogLevel level, std::chrono::milliseconds period) {
+            auto until = std::chrono::steady_clock::now() + period;
+            while (std::chrono::steady_clock::now() < until) {
+                logger.log("message", level);
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        };
+
+        // backlog above the budget: one step per interval
+        log_for(LogLevel::INFO, std::chrono::milliseconds(20));
+        CHECK(logger.effective_level() == LogLevel::ERROR);
+        CHECK(logger.get_level() == LogLevel::DEBUG);
+        CHECK(!logger.is_enabled(LogLevel::INFO));
+        CHECK(logger.is_enabled(LogLevel::ERROR));
+        CHECK(logger.shed(LogLevel::INFO) > 0);
+
+        // a query counts nothing, a dropped lazy message does
+        auto counted = logger.shed(LogLevel::INFO);
+        CHECK(!logger.is_enabled(LogLevel::INFO));
+        CHECK(logger.shed(LogLevel::INFO) == counted);
+        LOGGERLIB_INFO(logger, "lazy");
+        logger.info() << "stream";
+        CHECK(logger.shed(LogLevel::INFO) == counted + 2);
+
+        // queue drained: back one step per calm recovery period
+        logger.flush();
+        auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (logger.effective_level() != LogLevel::DEBUG &&
+               std::chrono::steady_clock::now() < until) {
+            logger.log("shed", LogLevel::DEBUG);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        CHECK(logger.effective_level() == LogLevel::DEBUG);
+        logger.log("after", LogLevel::DEBUG);
+        logger.flush();
+        CHECK(logger.shed(LogLevel::DEBUG) > 0);
+    }
+
+    auto lines = read_lines(filepath);
+    CHECK(!lines.empty());
+    if (!lines.empty()) {
+        CHECK(lines.back() == "DEBUG after");
+        bool reported = false;
+        for (const auto &line : lines) {
+            reported |= std::regex_match(
+                line,
+                std::regex(R"(INFO  Load shedding ended after \d+ ms: shed \d+ DEBUG, \d+ INFO messages)")
+            );
+            CHECK(line.find("shed") == std::string::npos ||
+                  line.rfind("INFO  Load shedding", 0) == 0);
+        }
+        CHECK(reported);
+    }
+    fs::remove(filepath);
+}
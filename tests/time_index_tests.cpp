@@ -0,0 +1,150 @@
+#include <sys/stat.h>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <loggerlib/logger.hpp>
+#include <loggerlib/time_index.hpp>
+#include <mytest.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace loggerlib;
+
+namespace {
+
+std::uint64_t file_size(const std::string &filepath) {
+    struct stat st{};
+    stat(filepath.c_str(), &st);
+    return static_cast<std::uint64_t>(st.st_size);
+}
+
+// Entries follow each other without gaps from offset 0
+bool contiguous(const std::vector<time_index::Entry> &entries) {
+    std::uint64_t end = 0;
+    for (const auto &entry : entries) {
+        if (entry.offset != end || entry.length == 0 ||
+            entry.min_ms > entry.max_ms) {
+            return false;
+        }
+        end += entry.length;
+    }
+    return true;
+}
+
+void remove_log(const std::string &filepath) {
+    std::remove(filepath.c_str());
+    std::remove(time_index::sidecar_path(filepath).c_str());
+}
+
+}  // namespace
+
+TEST_CASE("Time index covers the log with one region per bucket") {
+    const std::string filepath = "temp_logger_time_index.txt";
+    remove_log(filepath);
+
+    TimeIndexOptions options;
+    options.bucket = std::chrono::milliseconds(20);
+    {
+        Logger logger(filepath, LogLevel::DEBUG);
+        logger.enable_time_index(options);
+        for (int phase = 0; phase < 3; ++phase) {
+            for (int i = 0; i < 10; ++i) {
+                logger.log("info", LogLevel::INFO);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(25));
+        }
+        logger.log("error", LogLevel::ERROR);
+    }
+
+    auto entries = time_index::load(filepath);
+    CHECK(entries.has_value());
+    if (!entries) {
+        return;
+    }
+    CHECK(entries->size() >= 4);
+    CHECK(contiguous(*entries));
+    if (!entries->empty()) {
+        const auto &last = entries->back();
+        CHECK(last.offset + last.length == file_size(filepath));
+        CHECK(last.levels == time_index::level_bit(LogLevel::ERROR));
+    }
+
+    // regions of one bucket, the ERROR one is found by level alone
+    constexpr auto any_time = std::numeric_limits<std::int64_t>::max();
+    auto ranges = time_index::lookup(
+        *entries, file_size(filepath), -any_time, any_time, LogLevel::ERROR
+    );
+    CHECK(ranges.size() == 1);
+    if (ranges.size() == 1) {
+        CHECK(ranges[0].offset == entries->back().offset);
+    }
+    remove_log(filepath);
+}
+
+TEST_CASE("Time index continues an existing sidecar and drops a stale one") {
+    const std::string filepath = "temp_logger_time_index_reopen.txt";
+    remove_log(filepath);
+
+    for (int run = 0; run < 2; ++run) {
+        Logger logger(filepath, LogLevel::DEBUG);
+        logger.enable_time_index();
+        logger.log("run", LogLevel::INFO);
+    }
+    auto entries = time_index::load(filepath);
+    CHECK(entries && entries->size() == 2 && contiguous(*entries));
+
+    // the log is replaced, its old entries point past the end
+    std::remove(filepath.c_str());
+    {
+        Logger logger(filepath, LogLevel::DEBUG);
+        logger.enable_time_index();
+        logger.log("new", LogLevel::INFO);
+    }
+    entries = time_index::load(filepath);
+    CHECK(entries && entries->size() == 1 && contiguous(*entries));
+
+    bool thrown = false;
+    try {
+        Logger shared(filepath, LogLevel::DEBUG, FileMode::SHARED);
+        shared.enable_time_index();
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    remove_log(filepath);
+}
+
+TEST_CASE("Time index lookup merges regions and keeps unindexed bytes") {
+    std::vector<time_index::Entry> entries = {
+        {0, 100, 1000, 1999, time_index::level_bit(LogLevel::INFO)},
+        {100, 50, 2000, 2999, time_index::level_bit(LogLevel::INFO)},
+        // 150..200 written without the index
+        {200, 100, 3000, 3999, time_index::level_bit(LogLevel::DEBUG)},
+        {300, 100, 4000, 4999, time_index::level_bit(LogLevel::ERROR)},
+    };
+
+    auto ranges =
+        time_index::lookup(entries, 450, 1500, 2500, LogLevel::DEBUG);
+    CHECK(ranges.size() == 2);
+    if (ranges.size() == 2) {
+        CHECK(ranges[0].offset == 0 && ranges[0].length == 200);
+        CHECK(ranges[1].offset == 400 && ranges[1].length == 50);
+    }
+
+    ranges = time_index::lookup(entries, 450, 3000, 5000, LogLevel::INFO);
+    CHECK(ranges.size() == 2);
+    if (ranges.size() == 2) {
+        CHECK(ranges[0].offset == 150 && ranges[0].length == 50);
+        CHECK(ranges[1].offset == 300 && ranges[1].length == 150);
+    }
+
+    // one entry serialized and parsed back
+    std::string data;
+    time_index::put_entry(data, entries[3]);
+    CHECK(data.size() == time_index::ENTRY_SIZE);
+    auto parsed = time_index::parse_entry(data);
+    CHECK(parsed && parsed->offset == 300 && parsed->length == 100 &&
+          parsed->min_ms == 4000 && parsed->max_ms == 4999 &&
+          parsed->levels == time_index::level_bit(LogLevel::ERROR));
+}
@@ -0,0 +1,108 @@
+#include <loggerlib/wire.hpp>
+#include <mytest.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace loggerlib;
+
+TEST_CASE("wire varint and zigzag round trip") {
+    std::vector<std::uint64_t> values = {0, 1, 127, 128, 300, 1ull << 35,
+                                         ~0ull};
+    std::string buf;
+    for (auto v : values) {
+        wire::put_varint(buf, v);
+    }
+
+    const char *pos = buf.data();
+    const char *end = pos + buf.size();
+    for (auto v : values) {
+        std::uint64_t got;
+        CHECK(wire::get_varint(pos, end, got));
+        CHECK(got == v);
+    }
+    CHECK(pos == end);
+
+    for (std::int64_t v : {0ll, -1ll, 1ll, -123456789ll, 987654321ll}) {
+        CHECK(wire::unzigzag(wire::zigzag(v)) == v);
+    }
+}
+
+TEST_CASE("wire compress/decompress round trip") {
+    SUBCASE("Repetitive data shrinks") {
+        std::string data;
+        for (int i = 0; i < 200; ++i) {
+            data += "request handled in " + std::to_string(i % 7) + " ms\n";
+        }
+        auto packed = wire::compress(data);
+        CHECK(packed.size() < data.size() / 4);
+        CHECK(wire::decompress(packed, data.size()) == data);
+    }
+
+    SUBCASE("Short and empty data") {
+        for (std::string data : {"", "a", "abc", "abcdabcdabcd"}) {
+            CHECK(wire::decompress(wire::compress(data), data.size()) == data);
+        }
+    }
+
+    SUBCASE("Corrupted data throws") {
+        std::string packed = wire::compress("hello hello hello hello");
+        try {
+            wire::decompress(packed, 1000);
+            CHECK_MESSAGE(false, "Didn't throw on wrong size");
+        } catch (const std::runtime_error &) {
+        }
+    }
+}
+
+TEST_CASE("wire encoder/decoder round trip") {
+    for (bool compression : {false, true}) {
+        wire::Encoder encoder(compression);
+        std::vector<wire::Record> sent;
+        std::string stream;
+
+        for (int batch = 0; batch < 3; ++batch) {
+            for (int i = 0; i < 50; ++i) {
+                wire::Record record{
+                    static_cast<std::uint64_t>(batch * 50 + i),
+                    static_cast<LogLevel>(i % 3),
+                    1700000000000 + batch * 1000 - i,  // not monotonic
+                    "message #" + std::to_string(i)
+                };
+                encoder.add(record);
+                sent.push_back(record);
+            }
+            stream += encoder.finish();
+        }
+
+        // feed byte by byte to exercise partial frames
+        wire::Decoder decoder;
+        std::vector<wire::Record> received;
+        wire::Record record;
+        for (char c : stream) {
+            decoder.feed(&c, 1);
+            while (decoder.next(record)) {
+                received.push_back(record);
+            }
+        }
+
+        CHECK(received.size() == sent.size());
+        bool same = received.size() == sent.size();
+        for (std::size_t i = 0; same && i < sent.size(); ++i) {
+            same = received[i].seq == sent[i].seq &&
+                   received[i].level == sent[i].level &&
+                   received[i].timestamp_ms == sent[i].timestamp_ms &&
+                   received[i].message == sent[i].message;
+        }
+        CHECK_MESSAGE(same, "Decoded records differ from encoded ones");
+    }
+}
+
+TEST_CASE("wire hello parsing") {
+    auto hello = wire::parse_hello(wire::make_hello({1, wire::FLAG_COMPRESSED})
+    );
+    CHECK(hello.has_value());
+    CHECK(hello->version == 1);
+    CHECK(hello->flags == wire::FLAG_COMPRESSED);
+    CHECK(!wire::parse_hello("[2025-07").has_value());
+}
@@ -0,0 +1,373 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <limits>
+#include <loggerlib/archive.hpp>
+#include <loggerlib/io.hpp>
+#include <loggerlib/level.hpp>
+#include <loggerlib/merge.hpp>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace loggerlib;
+
+namespace {
+
+constexpr std::size_t OUTPUT_BUFFER = 1 << 20;
+
+enum class Unit { NONE = 0, MINUTE, HOUR, DAY };
+
+struct Options {
+    std::int64_t from_ms = std::numeric_limits<std::int64_t>::min();
+    std::int64_t to_ms = std::numeric_limits<std::int64_t>::max();
+    LogLevel level = LogLevel::DEBUG;
+    bool has_level = false;
+    Unit by = Unit::NONE;
+    std::size_t block_records = ArchiveOptions().block_records;
+    bool stats = false;
+};
+
+void usage(const char *name) {
+    std::cerr
+        << "Usage: " << name << " pack <archive> <log file>... [--block N]\n"
+        << "       " << name
+        << " cat <archive> [--from TIME] [--to TIME]"
+           " [--level DEBUG|INFO|ERROR] [--stats]\n"
+        << "       " << name
+        << " count <archive> [--from TIME] [--to TIME]"
+           " [--level DEBUG|INFO|ERROR] [--by minute|hour|day] [--stats]\n"
+           "TIME is local \"YYYY-MM-DD HH:MM:SS\" or milliseconds since the"
+           " epoch, records with --from <= time < --to are read. count prints"
+           " records per level, lines not in the default layout as other;"
+           " --level leaves out lower levels and the other lines.\n";
+}
+
+// "YYYY-MM-DD HH:MM:SS" in local time, read like the time of a line, or
+// milliseconds since the epoch
+std::optional<std::int64_t> parse_time_arg(std::string_view text) {
+    if (!text.empty() &&
+        text.find_first_not_of("0123456789") == std::string_view::npos) {
+        return std::stoll(std::string(text));
+    }
+    if (text.size() != 19) {
+        return std::nullopt;
+    }
+    return merge::LineClock().timestamp_ms("[" + std::string(text) + "]");
+}
+
+std::optional<LogLevel> parse_level(std::string_view text) {
+    if (text == "DEBUG") {
+        return LogLevel::DEBUG;
+    }
+    if (text == "INFO") {
+        return LogLevel::INFO;
+    }
+    if (text == "ERROR") {
+        return LogLevel::ERROR;
+    }
+    return std::nullopt;
+}
+
+// Local minutes, hours or days, localtime() once per bucket
+class Buckets {
+public:
+    explicit Buckets(Unit unit) : unit_(unit) {}
+
+    std::int64_t of(std::int64_t timestamp_ms) {
+        if (timestamp_ms >= start_ && timestamp_ms < end_) {
+            return start_;
+        }
+        std::time_t seconds = static_cast<std::time_t>(
+            timestamp_ms / 1000 - (timestamp_ms % 1000 < 0)
+        );
+        std::tm tm;
+        localtime_r(&seconds, &tm);
+        tm.tm_sec = 0;
+        if (unit_ != Unit::MINUTE) {
+            tm.tm_min = 0;
+        }
+        if (unit_ == Unit::DAY) {
+            tm.tm_hour = 0;
+        }
+        tm.tm_isdst = -1;
+        start_ = static_cast<std::int64_t>(std::mktime(&tm)) * 1000;
+        if (unit_ == Unit::MINUTE) {
+            ++tm.tm_min;
+        } else if (unit_ == Unit::HOUR) {
+            ++tm.tm_hour;
+        } else {
+            ++tm.tm_mday;
+        }
+        tm.tm_isdst = -1;
+        end_ = static_cast<std::int64_t>(std::mktime(&tm)) * 1000;
+        return start_;
+    }
+
+private:
+    Unit unit_;
+    std::int64_t start_ = 1;
+    std::int64_t end_ = 0;
+};
+
+struct Totals {
+    std::size_t blocks = 0;
+    std::size_t skipped = 0;
+    std::size_t decoded = 0;
+    std::uint64_t column_bytes = 0;  // of the columns decoded
+};
+
+using Counts = std::array<std::uint64_t, 4>;
+
+int pack(const std::string &archive_path, const std::vector<std::string> &logs,
+         const Options &options) {
+    ArchiveOptions archive_options;
+    archive_options.block_records = options.block_records;
+    archive::Writer writer(archive_path, archive_options);
+
+    for (const auto &path : logs) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st{};
+        if (fd == -1 || fstat(fd, &st) != 0) {
+            std::cerr << "Cannot open log file: " << path << "\n";
+            return 1;
+        }
+        auto size = static_cast<std::size_t>(st.st_size);
+        if (size == 0) {
+            close(fd);
+            continue;
+        }
+        void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Cannot map log file: " << path << "\n";
+            return 1;
+        }
+        madvise(mapped, size, MADV_SEQUENTIAL);
+
+        const char *pos = static_cast<const char *>(mapped);
+        const char *end = pos + size;
+        while (pos < end) {
+            const auto *eol = static_cast<const char *>(
+                std::memchr(pos, '\n', static_cast<std::size_t>(end - pos))
+            );
+            const char *next = eol ? eol + 1 : end;
+            writer.add_line(
+                std::string_view(pos, static_cast<std::size_t>(next - pos))
+            );
+            pos = next;
+        }
+        munmap(mapped, size);
+    }
+    writer.finish();
+    return 0;
+}
+
+// Mask of the level codes --level selects, other lines only without it
+std::uint8_t wanted_levels(const Options &options) {
+    std::uint8_t wanted = 0;
+    for (int level = static_cast<int>(options.level); level < 3; ++level) {
+        wanted |= static_cast<std::uint8_t>(1U << level);
+    }
+    if (!options.has_level) {
+        wanted |= 1U << archive::RAW;
+    }
+    return wanted;
+}
+
+int cat(const archive::Reader &reader, const Options &options, Totals &totals) {
+    // blocks without a level at or above the wanted one are skipped
+    std::uint8_t wanted = wanted_levels(options);
+
+    std::string output;
+    std::vector<bool> keep;
+    for (const auto &block : reader.blocks()) {
+        ++totals.blocks;
+        if (block.max_ms < options.from_ms || block.min_ms >= options.to_ms ||
+            !(block.levels & wanted)) {
+            ++totals.skipped;
+            continue;
+        }
+        ++totals.decoded;
+        for (auto size : block.column_sizes) {
+            totals.column_bytes += size;
+        }
+
+        auto stamps = reader.timestamps(block);
+        auto codes = reader.levels(block);
+        keep.assign(block.records, false);
+        for (std::uint32_t i = 0; i < block.records; ++i) {
+            keep[i] = stamps[i] >= options.from_ms &&
+                      stamps[i] < options.to_ms && (wanted >> codes[i] & 1);
+        }
+        reader.text(block, output, &keep);
+        if (output.size() >= OUTPUT_BUFFER) {
+            write_all(STDOUT_FILENO, output.data(), output.size());
+            output.clear();
+        }
+    }
+    write_all(STDOUT_FILENO, output.data(), output.size());
+    return 0;
+}
+
+void print_counts(const Counts &counts) {
+    std::cout << "DEBUG: " << counts[0] << ", INFO: " << counts[1]
+              << ", ERROR: " << counts[2] << ", other: " << counts[3];
+}
+
+int count(
+    const archive::Reader &reader,
+    const Options &options,
+    Totals &totals
+) {
+    std::uint8_t wanted = wanted_levels(options);
+    Buckets buckets(options.by);
+    Counts counts{};
+    std::map<std::int64_t, Counts> histogram;
+    for (const auto &block : reader.blocks()) {
+        ++totals.blocks;
+        if (block.max_ms < options.from_ms || block.min_ms >= options.to_ms ||
+            !(block.levels & wanted)) {
+            ++totals.skipped;
+            continue;
+        }
+
+        // a block inside the range, and inside one bucket, is counted by
+        // its header
+        bool inside =
+            block.min_ms >= options.from_ms && block.max_ms < options.to_ms;
+        if (inside && (options.by == Unit::NONE ||
+                       buckets.of(block.min_ms) == buckets.of(block.max_ms))) {
+            auto &bucket = options.by == Unit::NONE
+                               ? counts
+                               : histogram[buckets.of(block.min_ms)];
+            for (int i = 0; i < 4; ++i) {
+                if (wanted >> i & 1) {
+                    bucket[i] += block.counts[i];
+                }
+            }
+            continue;
+        }
+
+        ++totals.decoded;
+        totals.column_bytes += block.column_sizes[archive::TIMESTAMPS] +
+                               block.column_sizes[archive::LEVELS];
+        auto stamps = reader.timestamps(block);
+        auto codes = reader.levels(block);
+        for (std::uint32_t i = 0; i < block.records; ++i) {
+            if (stamps[i] < options.from_ms || stamps[i] >= options.to_ms ||
+                !(wanted >> codes[i] & 1)) {
+                continue;
+            }
+            if (options.by == Unit::NONE) {
+                ++counts[codes[i]];
+            } else {
+                ++histogram[buckets.of(stamps[i])][codes[i]];
+            }
+        }
+    }
+
+    for (const auto &[start, bucket] : histogram) {
+        std::time_t seconds = static_cast<std::time_t>(start / 1000);
+        std::tm tm;
+        localtime_r(&seconds, &tm);
+        char text[20];
+        std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &tm);
+        std::cout << text << "  ";
+        print_counts(bucket);
+        std::cout << "\n";
+        for (int i = 0; i < 4; ++i) {
+            counts[i] += bucket[i];
+        }
+    }
+    print_counts(counts);
+    std::cout << ", total: " << counts[0] + counts[1] + counts[2] + counts[3]
+              << "\n";
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+    std::string command = argv[1];
+    std::string archive_path = argv[2];
+
+    Options options;
+    std::vector<std::string> logs;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        std::optional<std::int64_t> time;
+        if ((arg == "--from" || arg == "--to") && has_value) {
+            time = parse_time_arg(argv[++i]);
+            if (!time) {
+                usage(argv[0]);
+                return 1;
+            }
+            (arg == "--from" ? options.from_ms : options.to_ms) = *time;
+        } else if (arg == "--level" && has_value) {
+            auto level = parse_level(argv[++i]);
+            if (!level) {
+                usage(argv[0]);
+                return 1;
+            }
+            options.level = *level;
+            options.has_level = true;
+        } else if (arg == "--by" && has_value) {
+            std::string unit = argv[++i];
+            options.by = unit == "minute" ? Unit::MINUTE
+                         : unit == "hour" ? Unit::HOUR
+                         : unit == "day"  ? Unit::DAY
+                                          : Unit::NONE;
+            if (options.by == Unit::NONE) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--block" && has_value) {
+            options.block_records = std::stoul(argv[++i]);
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (command == "pack" && arg.rfind("--", 0) != 0) {
+            logs.push_back(arg);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    try {
+        if (command == "pack") {
+            return pack(archive_path, logs, options);
+        }
+        if (command != "cat" && command != "count") {
+            usage(argv[0]);
+            return 1;
+        }
+
+        archive::Reader reader(archive_path);
+        Totals totals;
+        int status = command == "cat" ? cat(reader, options, totals)
+                                      : count(reader, options, totals);
+        if (options.stats) {
+            std::cerr << totals.blocks << " blocks, " << totals.skipped
+                      << " skipped, " << totals.decoded << " decoded, "
+                      << totals.column_bytes << " column bytes read\n";
+        }
+        return status;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,52 @@
+#include <signal.h>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <loggerlib/forwarder.hpp>
+#include <string>
+
+namespace {
+
+loggerlib::Forwarder *running = nullptr;
+
+void handle_stop(int /*signal*/) {
+    if (running) {
+        running->stop();
+    }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc != 4 && !(argc == 6 && std::string(argv[4]) == "--state")) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <file> <host> <port> [--state PATH]\n"
+                     "Streams <file> and its rotations to a collector,"
+                     " resuming at the offset saved in PATH (<file>.fwd by"
+                     " default).\n";
+        return 1;
+    }
+
+    loggerlib::ForwarderOptions options;
+    if (argc == 6) {
+        options.state_path = argv[5];
+    }
+
+    try {
+        loggerlib::Forwarder forwarder(
+            argv[1], argv[2], std::atoi(argv[3]), options
+        );
+        running = &forwarder;
+        signal(SIGINT, handle_stop);
+        signal(SIGTERM, handle_stop);
+        signal(SIGPIPE, SIG_IGN);
+
+        forwarder.run();
+        running = nullptr;
+        std::cerr << "Stopped at offset " << forwarder.offset() << "\n";
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,646 @@
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <loggerlib/logger.hpp>
+#include <loggerlib/net.hpp>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace loggerlib;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Embedded in every message: MARKER <connection> <seq> <send time, us>
+constexpr std::string_view MARKER = "loadgen ";
+constexpr auto POLL_INTERVAL = std::chrono::milliseconds(50);
+// Ordering window passed to the collector unless given after "--", every
+// line is held back that long and it adds to the latency measured
+constexpr std::string_view COLLECTOR_WINDOW_MS = "10";
+
+struct Options {
+    std::string collector;  // started locally if set
+    std::vector<std::string> collector_args;
+    std::string host = "127.0.0.1";  // of --target
+    int port = 0;
+    std::size_t connections = 8;
+    std::size_t threads = 0;  // 0 - min(connections, cores)
+    double rate = 0;          // messages/s over all connections, 0 - flat out
+    double duration = 0;      // seconds, 0 - 5 or the replay file once
+    std::uint64_t messages = 0;
+    std::string replay;
+    std::array<double, 3> mix = {10, 80, 10};  // DEBUG:INFO:ERROR weights
+    std::size_t min_size = 64;
+    std::size_t max_size = 64;
+    bool log_sizes = false;  // log-uniform instead of uniform
+    WireFormat format = WireFormat::TEXT;
+    bool async = false;
+    std::chrono::milliseconds drain{3000};
+    std::uint64_t seed = 1;
+};
+
+void usage(const char *name) {
+    std::cerr
+        << "Usage: " << name
+        << " (--collector PATH | --target HOST PORT) [--connections C]"
+           " [--threads T] [--rate R] [--duration S | --messages N]"
+           " [--replay FILE] [--levels D:I:E] [--size MIN[:MAX[:log]]]"
+           " [--binary] [--async] [--drain MS] [--seed N]"
+           " [-- COLLECTOR OPTIONS]\n"
+           "Sends messages through C TCP Loggers, R messages/s in total (flat"
+           " out by default). With --collector, PATH (logger-stats-app) is"
+           " started on a free local port and its output is read back to"
+           " measure latency and loss. The collector gets --window "
+        << COLLECTOR_WINDOW_MS << " unless given another one.\n";
+}
+
+// Whole text as a number, no exceptions on bad input
+template <typename T>
+bool parse_number(std::string_view text, T &value) {
+    auto [end, ec] =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && end == text.data() + text.size();
+}
+
+// "D:I:E" weights
+bool parse_mix(std::string_view text, std::array<double, 3> &mix) {
+    double total = 0;
+    for (int i = 0; i < 3; ++i) {
+        auto colon = text.find(':');
+        if ((colon == std::string_view::npos) != (i == 2)) {
+            return false;
+        }
+        std::size_t weight;
+        if (!parse_number(text.substr(0, colon), weight)) {
+            return false;
+        }
+        mix[i] = static_cast<double>(weight);
+        total += mix[i];
+        text.remove_prefix(i == 2 ? text.size() : colon + 1);
+    }
+    return total > 0;
+}
+
+// "MIN[:MAX[:log]]"
+bool parse_sizes(std::string_view text, Options &options) {
+    auto colon = text.find(':');
+    if (!parse_number(text.substr(0, colon), options.min_size)) {
+        return false;
+    }
+    options.max_size = options.min_size;
+    if (colon == std::string_view::npos) {
+        return true;
+    }
+    text.remove_prefix(colon + 1);
+    colon = text.find(':');
+    if (!parse_number(text.substr(0, colon), options.max_size) ||
+        options.max_size < options.min_size) {
+        return false;
+    }
+    options.log_sizes = colon != std::string_view::npos;
+    return !options.log_sizes || text.substr(colon + 1) == "log";
+}
+
+struct Message {
+    LogLevel level;
+    std::string text;
+};
+
+// Records of a log in the default layout, untagged lines as INFO
+std::vector<Message> load_replay(const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open replay file: " + path);
+    }
+    std::vector<Message> messages;
+    std::string line;
+    while (std::getline(file, line)) {
+        Message message{LogLevel::INFO, line};
+        if (line.size() >= 29 && line[0] == '[' && line[20] == ']') {
+            std::string_view tag(line.data() + 22, 7);
+            if (tag == "DEBUG: " || tag == "INFO:  " || tag == "ERROR: ") {
+                message.level = tag[0] == 'D'   ? LogLevel::DEBUG
+                                : tag[0] == 'I' ? LogLevel::INFO
+                                                : LogLevel::ERROR;
+                message.text = line.substr(29);
+            }
+        }
+        messages.push_back(std::move(message));
+    }
+    if (messages.empty()) {
+        throw std::runtime_error("Empty replay file: " + path);
+    }
+    return messages;
+}
+
+std::int64_t micros(Clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               time.time_since_epoch()
+    )
+        .count();
+}
+
+// Free local port, may be taken again before the collector binds it
+int free_port() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (fd < 0 ||
+        bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) !=
+            0 ||
+        getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length) !=
+            0) {
+        throw std::runtime_error("Cannot find a free port");
+    }
+    close(fd);
+    return ntohs(address.sin_port);
+}
+
+// logger-stats-app with its stdout piped to the returned descriptor
+pid_t start_collector(const Options &options, int &out_fd) {
+    std::vector<std::string> args = {
+        options.collector, options.host, std::to_string(options.port),
+        // no statistics blocks in the output
+        "1000000000000", "3600", "--window", std::string(COLLECTOR_WINDOW_MS)
+    };
+    args.insert(
+        args.end(), options.collector_args.begin(),
+        options.collector_args.end()
+    );
+    std::vector<char *> argv;
+    for (auto &arg : args) {
+        argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        throw std::runtime_error("Cannot create a pipe");
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        throw std::runtime_error("Cannot start the collector");
+    }
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execv(argv[0], argv.data());
+        perror("execv");
+        _exit(127);
+    }
+    close(fds[1]);
+    out_fd = fds[0];
+    return pid;
+}
+
+// The collector process and the thread reading its output, stopped and
+// reaped however run() ends
+struct CollectorProcess {
+    pid_t pid = -1;
+    int fd = -1;
+    std::thread reader;
+
+    CollectorProcess() = default;
+    CollectorProcess(const CollectorProcess &) = delete;
+    CollectorProcess &operator=(const CollectorProcess &) = delete;
+    ~CollectorProcess() {
+        stop();
+    }
+
+    // SIGTERM, the reader sees the end of the output once it exits
+    void stop() {
+        if (pid > 0) {
+            kill(pid, SIGTERM);
+            waitpid(pid, nullptr, 0);
+            pid = -1;
+        }
+        if (reader.joinable()) {
+            reader.join();
+        }
+        if (fd != -1) {
+            close(fd);
+            fd = -1;
+        }
+    }
+};
+
+// Window the collector runs with, the last --window given wins
+std::string_view collector_window(const Options &options) {
+    std::string_view window = COLLECTOR_WINDOW_MS;
+    const auto &args = options.collector_args;
+    for (std::size_t i = 0; i + 1 < args.size(); ++i) {
+        if (args[i] == "--window") {
+            window = args[i + 1];
+        }
+    }
+    return window;
+}
+
+void wait_for_listener(const Options &options) {
+    auto deadline = Clock::now() + std::chrono::seconds(5);
+    while (true) {
+        try {
+            close(connect_tcp(options.host, options.port));
+            return;
+        } catch (const std::runtime_error &) {
+            if (Clock::now() > deadline) {
+                throw std::runtime_error("The collector doesn't listen");
+            }
+            std::this_thread::sleep_for(POLL_INTERVAL);
+        }
+    }
+}
+
+// Reads the collector output back and matches the messages sent
+class Receiver {
+public:
+    explicit Receiver(std::size_t connections) : seen_(connections) {}
+
+    // Until the collector exits
+    void run(int fd) {
+        std::string pending;
+        char buffer[64 * 1024];
+        while (true) {
+            ssize_t len = read(fd, buffer, sizeof(buffer));
+            if (len < 0 && errno == EINTR) {
+                continue;
+            }
+            if (len <= 0) {
+                break;
+            }
+            pending.append(buffer, static_cast<std::size_t>(len));
+            std::size_t start = 0;
+            std::size_t eol;
+            while ((eol = pending.find('\n', start)) != std::string::npos) {
+                match(std::string_view(pending).substr(start, eol - start));
+                start = eol + 1;
+            }
+            pending.erase(0, start);
+        }
+    }
+
+    std::uint64_t received() const {
+        return received_.load();
+    }
+    std::uint64_t duplicates() const {
+        return duplicates_;
+    }
+    // Latencies in us, call once the reader stopped
+    std::vector<std::int64_t> &latencies() {
+        return latencies_;
+    }
+
+private:
+    void match(std::string_view line) {
+        auto pos = line.find(MARKER);
+        if (pos == std::string_view::npos) {
+            return;
+        }
+        const char *begin = line.data() + pos + MARKER.size();
+        const char *end = line.data() + line.size();
+        std::uint64_t fields[3];
+        for (auto &field : fields) {
+            auto [next, ec] = std::from_chars(begin, end, field);
+            if (ec != std::errc()) {
+                return;
+            }
+            begin = next + 1;
+        }
+        if (fields[0] >= seen_.size()) {
+            return;
+        }
+
+        auto &seen = seen_[fields[0]];
+        if (fields[1] >= seen.size()) {
+            seen.resize(std::max<std::size_t>(fields[1] + 1, seen.size() * 2));
+        }
+        if (seen[fields[1]]) {
+            ++duplicates_;
+            return;
+        }
+        seen[fields[1]] = true;
+        latencies_.push_back(
+            micros(Clock::now()) - static_cast<std::int64_t>(fields[2])
+        );
+        received_.fetch_add(1);
+    }
+
+    std::vector<std::vector<bool>> seen_;  // per connection, by seq
+    std::atomic<std::uint64_t> received_{0};
+    std::uint64_t duplicates_ = 0;
+    std::vector<std::int64_t> latencies_;
+};
+
+struct Connection {
+    std::unique_ptr<Logger> logger;
+    std::size_t id = 0;
+    std::uint64_t seq = 0;  // messages sent
+};
+
+// Shared by the sender threads
+struct Load {
+    const Options &options;
+    const std::vector<Message> *replay;  // null for synthetic messages
+    Clock::time_point start;
+    Clock::time_point stop;  // if options.messages is 0
+    std::atomic<std::uint64_t> issued{0};
+};
+
+void append_number(std::string &out, std::uint64_t value) {
+    char digits[20];
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, end);
+}
+
+// Sends from the connections of one thread, paced to rate / threads with
+// each send time taken from the schedule, so that a stall delays the
+// following messages and shows in their latency
+void send_load(
+    Load &load,
+    std::vector<Connection> &connections,
+    std::size_t thread,
+    double rate
+) {
+    const auto &options = load.options;
+    std::mt19937_64 random(options.seed * 1000003 + thread);
+    std::discrete_distribution<int> levels(
+        options.mix.begin(), options.mix.end()
+    );
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::string message;
+    std::uint64_t sent = 0;
+
+    for (std::size_t next = 0;; next = (next + 1) % connections.size()) {
+        auto scheduled = Clock::now();
+        if (rate > 0) {
+            auto due = load.start + std::chrono::duration_cast<Clock::duration>(
+                                        std::chrono::duration<double>(
+                                            static_cast<double>(sent) / rate
+                                        )
+                                    );
+            if (due > scheduled) {
+                std::this_thread::sleep_until(due);
+            }
+            scheduled = due;
+        }
+        // tickets also pick the replay lines, so each is sent once per pass
+        std::uint64_t ticket = load.issued.fetch_add(1);
+        if (options.messages == 0 ? Clock::now() >= load.stop
+                                  : ticket >= options.messages) {
+            break;
+        }
+
+        auto &connection = connections[next];
+        message.assign(MARKER);
+        append_number(message, connection.id);
+        message += ' ';
+        append_number(message, connection.seq);
+        message += ' ';
+        append_number(message, static_cast<std::uint64_t>(micros(scheduled)));
+        message += ' ';
+
+        LogLevel level;
+        if (load.replay) {
+            const auto &record = (*load.replay)[ticket % load.replay->size()];
+            level = record.level;
+            message += record.text;
+        } else {
+            level = static_cast<LogLevel>(levels(random));
+            double size = options.min_size;
+            double span = unit(random);
+            if (options.log_sizes) {
+                size *= std::pow(
+                    static_cast<double>(options.max_size) / options.min_size,
+                    span
+                );
+            } else {
+                size += span * (options.max_size - options.min_size);
+            }
+            auto length = static_cast<std::size_t>(size);
+            if (message.size() < length) {
+                message.append(length - message.size(), 'x');
+            }
+        }
+
+        connection.logger->log(message, level);
+        ++connection.seq;
+        ++sent;
+    }
+}
+
+double percentile(const std::vector<std::int64_t> &sorted, double fraction) {
+    auto index = static_cast<std::size_t>(fraction * (sorted.size() - 1));
+    return static_cast<double>(sorted[index]) / 1000;
+}
+
+int run(Options &options) {
+    std::vector<Message> replay;
+    if (!options.replay.empty()) {
+        replay = load_replay(options.replay);
+        if (options.messages == 0 && options.duration == 0) {
+            options.messages = replay.size();
+        }
+    }
+    if (options.duration == 0) {
+        options.duration = 5;
+    }
+
+    Receiver receiver(options.connections);
+    CollectorProcess collector;
+    if (!options.collector.empty()) {
+        options.port = free_port();
+        collector.pid = start_collector(options, collector.fd);
+        collector.reader = std::thread([&]() { receiver.run(collector.fd); });
+    }
+    wait_for_listener(options);
+
+    // connections dealt to the threads round-robin
+    if (options.threads == 0) {
+        options.threads = std::min<std::size_t>(
+            options.connections,
+            std::max(1U, std::thread::hardware_concurrency())
+        );
+    }
+    options.threads = std::min(options.threads, options.connections);
+    std::vector<std::vector<Connection>> owned(options.threads);
+    for (std::size_t id = 0; id < options.connections; ++id) {
+        Connection connection;
+        connection.logger = std::make_unique<Logger>(
+            options.host, options.port, LogLevel::DEBUG, options.format
+        );
+        if (options.async) {
+            connection.logger->enable_async();
+        }
+        connection.id = id;
+        owned[id % options.threads].push_back(std::move(connection));
+    }
+
+    Load load{options, replay.empty() ? nullptr : &replay, Clock::now(), {}};
+    load.stop = load.start + std::chrono::duration_cast<Clock::duration>(
+                                 std::chrono::duration<double>(options.duration)
+                             );
+    std::vector<std::thread> senders;
+    for (std::size_t t = 0; t < options.threads; ++t) {
+        senders.emplace_back([&, t]() {
+            send_load(
+                load, owned[t], t,
+                options.rate / static_cast<double>(options.threads)
+            );
+        });
+    }
+    for (auto &sender : senders) {
+        sender.join();
+    }
+
+    // closing the loggers flushes their queues
+    std::uint64_t sent = 0;
+    std::uint64_t dropped = 0;
+    for (auto &connections : owned) {
+        for (auto &connection : connections) {
+            sent += connection.seq;
+            for (int level = 0; level < 3; ++level) {
+                dropped += connection.logger->dropped(
+                    static_cast<LogLevel>(level)
+                );
+            }
+            connection.logger.reset();
+        }
+    }
+    double elapsed =
+        std::chrono::duration<double>(Clock::now() - load.start).count();
+
+    std::cout << std::fixed << std::setprecision(2) << "sent: " << sent
+              << " in " << elapsed << " s, "
+              << static_cast<double>(sent) / elapsed << " msgs/s";
+    if (options.rate > 0) {
+        std::cout << " (target " << options.rate << ")";
+    }
+    std::cout << "\ndropped by loggers: " << dropped << "\n";
+    if (collector.pid < 0) {
+        return 0;
+    }
+
+    // the collector holds lines back for its ordering window
+    auto expected = sent - dropped;
+    auto last = receiver.received();
+    auto idle_since = Clock::now();
+    while (receiver.received() < expected &&
+           Clock::now() - idle_since < options.drain) {
+        std::this_thread::sleep_for(POLL_INTERVAL);
+        if (receiver.received() != last) {
+            last = receiver.received();
+            idle_since = Clock::now();
+        }
+    }
+    collector.stop();
+
+    auto received = receiver.received();
+    std::cout << "received: " << received
+              << ", lost: " << (expected > received ? expected - received : 0)
+              << ", duplicated: " << receiver.duplicates() << "\n";
+    auto &latencies = receiver.latencies();
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << "latency ms (collector window "
+                  << collector_window(options)
+                  << "): min " << percentile(latencies, 0)
+                  << ", p50 " << percentile(latencies, 0.5) << ", p90 "
+                  << percentile(latencies, 0.9) << ", p99 "
+                  << percentile(latencies, 0.99) << ", p99.9 "
+                  << percentile(latencies, 0.999) << ", max "
+                  << percentile(latencies, 1) << "\n";
+    }
+    return received + dropped == sent ? 0 : 2;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    bool valid = true;
+    for (int i = 1; i < argc && valid; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--") {
+            options.collector_args.assign(argv + i + 1, argv + argc);
+            break;
+        } else if (arg == "--collector" && has_value) {
+            options.collector = argv[++i];
+        } else if (arg == "--target" && i + 2 < argc) {
+            options.host = argv[++i];
+            valid = parse_number(argv[++i], options.port) &&
+                    options.port > 0;
+        } else if (arg == "--connections" && has_value) {
+            valid = parse_number(argv[++i], options.connections) &&
+                    options.connections > 0;
+        } else if (arg == "--threads" && has_value) {
+            valid = parse_number(argv[++i], options.threads);
+        } else if (arg == "--rate" && has_value) {
+            valid = parse_number(argv[++i], options.rate) && options.rate >= 0;
+        } else if (arg == "--duration" && has_value) {
+            valid = parse_number(argv[++i], options.duration) &&
+                    options.duration >= 0;
+        } else if (arg == "--messages" && has_value) {
+            std::size_t messages;
+            valid = parse_number(argv[++i], messages);
+            options.messages = messages;
+        } else if (arg == "--replay" && has_value) {
+            options.replay = argv[++i];
+        } else if (arg == "--levels" && has_value) {
+            valid = parse_mix(argv[++i], options.mix);
+        } else if (arg == "--size" && has_value) {
+            valid = parse_sizes(argv[++i], options) && options.min_size > 0;
+        } else if (arg == "--binary") {
+            options.format = WireFormat::BINARY;
+        } else if (arg == "--async") {
+            options.async = true;
+        } else if (arg == "--drain" && has_value) {
+            std::size_t drain;
+            valid = parse_number(argv[++i], drain);
+            options.drain = std::chrono::milliseconds(drain);
+        } else if (arg == "--seed" && has_value) {
+            std::size_t seed;
+            valid = parse_number(argv[++i], seed);
+            options.seed = seed;
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid || options.collector.empty() == (options.port == 0)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    try {
+        return run(options);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,121 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <iostream>
+#include <loggerlib/io.hpp>
+#include <loggerlib/merge.hpp>
+#include <string>
+#include <vector>
+
+using namespace loggerlib;
+
+namespace {
+
+constexpr std::size_t READ_SIZE = 1 << 20;
+constexpr std::size_t OUTPUT_BUFFER = 1 << 20;
+
+void usage(const char *name) {
+    std::cerr << "Usage: " << name
+              << " <log file>... [--window MS] [--stats]\n"
+                 "Merges rotated or per-host logs in the default layout by"
+                 " timestamp. Each file may be out of order by up to the"
+                 " window (1000 ms by default).\n";
+}
+
+// Log file read on demand, one stream of the merge
+struct Source {
+    std::string path;
+    int fd = -1;
+    merge::LineSplitter splitter;
+};
+
+// Push the next line of source, false at its end
+bool pull(Source &source, std::vector<char> &buffer, merge::Entry &entry) {
+    while (!source.splitter.next(entry)) {
+        ssize_t len = read(source.fd, buffer.data(), buffer.size());
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (len <= 0) {
+            return source.splitter.finish(entry);
+        }
+        source.splitter.feed(buffer.data(), static_cast<std::size_t>(len));
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    MergeOptions options;
+    bool stats = false;
+    std::vector<Source> sources;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--window" && i + 1 < argc) {
+            options.window = std::chrono::milliseconds(std::stoll(argv[++i]));
+        } else if (arg == "--stats") {
+            stats = true;
+        } else if (arg.rfind("--", 0) == 0) {
+            usage(argv[0]);
+            return 1;
+        } else {
+            sources.emplace_back().path = arg;
+        }
+    }
+    if (sources.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // streams are numbered like the sources, none is closed before all
+    // are added
+    Merger merger(options);
+    for (auto &source : sources) {
+        source.fd = open(source.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (source.fd == -1) {
+            std::cerr << "Cannot open log file: " << source.path << "\n";
+            return 1;
+        }
+        posix_fadvise(source.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        merger.add_stream();
+    }
+
+    std::vector<char> buffer(READ_SIZE);
+    std::string output;
+    output.reserve(OUTPUT_BUFFER + 4096);
+    merge::Entry entry;
+    std::uint64_t lines = 0;
+    auto emit = [&]() {
+        output += entry.text;
+        ++lines;
+        if (output.size() >= OUTPUT_BUFFER) {
+            write_all(STDOUT_FILENO, output.data(), output.size());
+            output.clear();
+        }
+    };
+
+    // read from the file that holds the merge back until a line is free
+    while (auto stream = merger.lagging()) {
+        if (pull(sources[*stream], buffer, entry)) {
+            merger.push(*stream, std::move(entry));
+        } else {
+            merger.close_stream(*stream);
+            close(sources[*stream].fd);
+        }
+        while (merger.pop(entry)) {
+            emit();
+        }
+    }
+    while (merger.pop_any(entry)) {
+        emit();
+    }
+    write_all(STDOUT_FILENO, output.data(), output.size());
+
+    if (stats) {
+        std::cerr << sources.size() << " files, " << lines << " lines, "
+                  << merger.late() << " out of order beyond the window\n";
+    }
+    return 0;
+}
@@ -0,0 +1,248 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <loggerlib/io.hpp>
+#include <loggerlib/merge.hpp>
+#include <loggerlib/time_index.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace loggerlib;
+
+namespace {
+
+constexpr std::size_t OUTPUT_BUFFER = 1 << 20;
+
+struct Query {
+    std::string path;
+    std::int64_t from_ms = std::numeric_limits<std::int64_t>::min();
+    std::int64_t to_ms = std::numeric_limits<std::int64_t>::max();
+    LogLevel level = LogLevel::DEBUG;
+    bool use_index = true;
+    bool stats = false;
+};
+
+void usage(const char *name) {
+    std::cerr
+        << "Usage: " << name
+        << " <log file> [--from TIME] [--to TIME] [--level DEBUG|INFO|ERROR]"
+           " [--no-index] [--stats]\n"
+           "TIME is local \"YYYY-MM-DD HH:MM:SS\" or milliseconds since the"
+           " epoch. Prints the lines with --from <= time < --to.\n";
+}
+
+// "YYYY-MM-DD HH:MM:SS" in local time, read like the time of a line, or
+// milliseconds since the epoch
+std::optional<std::int64_t> parse_time_arg(const std::string &text) {
+    if (!text.empty() &&
+        text.find_first_not_of("0123456789") == std::string::npos) {
+        return std::stoll(text);
+    }
+    if (text.size() != 19) {
+        return std::nullopt;
+    }
+    return merge::LineClock().timestamp_ms("[" + text + "]");
+}
+
+std::optional<LogLevel> parse_level(std::string_view text) {
+    if (text == "DEBUG") {
+        return LogLevel::DEBUG;
+    }
+    if (text == "INFO") {
+        return LogLevel::INFO;
+    }
+    if (text == "ERROR") {
+        return LogLevel::ERROR;
+    }
+    return std::nullopt;
+}
+
+// Lines in the default layout, "[YYYY-MM-DD HH:MM:SS] LEVEL: message".
+// Other lines (continuations, multi-line messages) follow the record
+// they belong to.
+class LineFilter {
+public:
+    explicit LineFilter(const Query &query) : query_(query) {}
+
+    bool matches(std::string_view line) {
+        if (line.size() < 23) {
+            return last_;
+        }
+        auto ms = clock_.timestamp_ms(line);
+        if (!ms) {
+            return last_;
+        }
+
+        auto level = parse_level(level_tag(line.substr(22)));
+        last_ = *ms >= query_.from_ms && *ms < query_.to_ms &&
+                (!level || *level >= query_.level);
+        return last_;
+    }
+
+private:
+    static std::string_view level_tag(std::string_view rest) {
+        auto end = rest.find(':');
+        return end == std::string_view::npos ? std::string_view()
+                                             : rest.substr(0, end);
+    }
+
+    const Query &query_;
+    bool last_ = false;
+    merge::LineClock clock_;
+};
+
+struct Totals {
+    std::size_t ranges = 0;
+    std::uint64_t scanned = 0;
+    std::size_t matched = 0;
+};
+
+void scan(
+    const char *data,
+    const time_index::Range &range,
+    LineFilter &filter,
+    std::string &output,
+    Totals &totals
+) {
+    const char *pos = data + range.offset;
+    const char *end = pos + range.length;
+    while (pos < end) {
+        const auto *eol = static_cast<const char *>(
+            std::memchr(pos, '\n', static_cast<std::size_t>(end - pos))
+        );
+        const char *next = eol ? eol + 1 : end;
+        std::string_view line(pos, static_cast<std::size_t>(next - pos));
+        if (filter.matches(line)) {
+            output.append(line);
+            ++totals.matched;
+            if (output.size() >= OUTPUT_BUFFER) {
+                write_all(STDOUT_FILENO, output.data(), output.size());
+                output.clear();
+            }
+        }
+        pos = next;
+    }
+    ++totals.ranges;
+    totals.scanned += range.length;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Query query;
+    query.path = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--from" && has_value) {
+            auto value = parse_time_arg(argv[++i]);
+            if (!value) {
+                usage(argv[0]);
+                return 1;
+            }
+            query.from_ms = *value;
+        } else if (arg == "--to" && has_value) {
+            auto value = parse_time_arg(argv[++i]);
+            if (!value) {
+                usage(argv[0]);
+                return 1;
+            }
+            query.to_ms = *value;
+        } else if (arg == "--level" && has_value) {
+            auto value = parse_level(argv[++i]);
+            if (!value) {
+                usage(argv[0]);
+                return 1;
+            }
+            query.level = *value;
+        } else if (arg == "--no-index") {
+            query.use_index = false;
+        } else if (arg == "--stats") {
+            query.stats = true;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    int fd = open(query.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        std::cerr << "Cannot open log file: " << query.path << "\n";
+        return 1;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0) {
+        std::cerr << "Cannot stat log file: " << query.path << "\n";
+        close(fd);
+        return 1;
+    }
+    auto size = static_cast<std::uint64_t>(st.st_size);
+    if (size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    // a missing or stale index means a full scan
+    std::vector<time_index::Range> ranges{{0, size}};
+    bool indexed = false;
+    if (query.use_index) {
+        auto entries = time_index::load(query.path);
+        if (entries && (entries->empty() ||
+                        entries->back().offset + entries->back().length <=
+                            size)) {
+            ranges = time_index::lookup(
+                *entries, size, query.from_ms, query.to_ms, query.level
+            );
+            indexed = true;
+        }
+    }
+
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Cannot map log file: " << query.path << "\n";
+        close(fd);
+        return 1;
+    }
+    const char *data = static_cast<const char *>(mapped);
+
+    // start reading every range ahead of the scan
+    long page = sysconf(_SC_PAGESIZE);
+    for (const auto &range : ranges) {
+        auto start = range.offset / page * page;
+        auto length = range.offset + range.length - start;
+        madvise(const_cast<char *>(data) + start, length, MADV_SEQUENTIAL);
+        readahead(fd, static_cast<off64_t>(start), length);
+    }
+
+    LineFilter filter(query);
+    std::string output;
+    output.reserve(OUTPUT_BUFFER + 4096);
+    Totals totals;
+    for (const auto &range : ranges) {
+        scan(data, range, filter, output, totals);
+    }
+    write_all(STDOUT_FILENO, output.data(), output.size());
+
+    if (query.stats) {
+        std::cerr << (indexed ? "index" : "full scan") << ": "
+                  << totals.ranges << " ranges, " << totals.scanned << " of "
+                  << size << " bytes scanned, " << totals.matched
+                  << " lines matched\n";
+    }
+
+    munmap(mapped, size);
+    close(fd);
+    return 0;
+}
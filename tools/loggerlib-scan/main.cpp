@@ -0,0 +1,396 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <loggerlib/io.hpp>
+#include <loggerlib/level.hpp>
+#include <loggerlib/merge.hpp>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "simd.hpp"
+
+using loggerlib::LogLevel;
+
+namespace {
+
+// Files are split into chunks of about this size at line boundaries
+constexpr std::size_t CHUNK_SIZE = 16 << 20;
+
+// "[YYYY-MM-DD HH:MM:SS] " precedes the level tag in the default layout
+constexpr std::size_t LEVEL_OFFSET = 22;
+
+struct Options {
+    std::vector<std::string> files;
+    LogLevel level = LogLevel::DEBUG;
+    std::string needle;
+    bool count = false;
+    bool stats = false;
+    unsigned threads = std::max(1U, std::thread::hardware_concurrency());
+    std::string isa;  // forced kernel, empty - the best supported
+};
+
+// Matching lines of one chunk, as counted by formatStats in
+// logger-stats-app
+struct Totals {
+    std::size_t total = 0;
+    std::array<std::size_t, 3> per_level{};
+    std::size_t last_hour = 0;
+    std::size_t min_length = std::numeric_limits<std::size_t>::max();
+    std::size_t max_length = 0;
+    std::uint64_t sum_length = 0;
+
+    void merge(const Totals &other) {
+        total += other.total;
+        for (std::size_t i = 0; i < per_level.size(); ++i) {
+            per_level[i] += other.per_level[i];
+        }
+        last_hour += other.last_hour;
+        min_length = std::min(min_length, other.min_length);
+        max_length = std::max(max_length, other.max_length);
+        sum_length += other.sum_length;
+    }
+};
+
+struct Chunk {
+    const char *begin;
+    const char *end;
+    std::string output;
+    Totals totals;
+    bool done = false;
+};
+
+void usage(const char *name) {
+    std::cerr << "Usage: " << name
+              << " [--level DEBUG|INFO|ERROR] [--grep TEXT] [--count]"
+                 " [--stats] [--threads N] [--isa avx2|sse2|scalar]"
+                 " <file>...\n"
+                 "Prints the lines at or above the level containing TEXT."
+                 " --count and --stats print per-level counts and"
+                 " length/time stats instead.\n";
+}
+
+std::optional<LogLevel> parse_level(std::string_view text) {
+    if (text == "DEBUG") {
+        return LogLevel::DEBUG;
+    }
+    if (text == "INFO") {
+        return LogLevel::INFO;
+    }
+    if (text == "ERROR") {
+        return LogLevel::ERROR;
+    }
+    return std::nullopt;
+}
+
+// Level tag at its fixed position, one compare of the tag's first byte.
+// Lines without a tag count as INFO, like in logger-stats-app.
+int level_of(const char *line, std::size_t length) {
+    if (length <= LEVEL_OFFSET + 5 || line[0] != '[' ||
+        line[LEVEL_OFFSET - 2] != ']') {
+        return 1;
+    }
+    const char *tag = line + LEVEL_OFFSET;
+    switch (tag[0]) {
+        case 'D':
+            return std::memcmp(tag, "DEBUG:", 6) == 0 ? 0 : 1;
+        case 'E':
+            return std::memcmp(tag, "ERROR:", 6) == 0 ? 2 : 1;
+        default:
+            return 1;
+    }
+}
+
+template <typename Isa>
+void scan_chunk(Chunk &chunk, const Options &options, std::int64_t hour_ago) {
+    const char *match = nullptr;
+    auto min_level = static_cast<int>(options.level);
+    bool collect = !options.count && !options.stats;
+    loggerlib::merge::LineClock clock;
+
+    scan::for_each_line<Isa>(
+        chunk.begin, chunk.end,
+        [&](const char *line, const char *next) {
+            auto length = static_cast<std::size_t>(next - line);
+            int level = level_of(line, length);
+            if (level < min_level) {
+                return;
+            }
+
+            // the next occurrence is searched once for many lines
+            if (!options.needle.empty()) {
+                if (match < line) {
+                    match = scan::find<Isa>(line, chunk.end, options.needle);
+                }
+                if (match + options.needle.size() > next) {
+                    return;
+                }
+            }
+
+            auto &totals = chunk.totals;
+            ++totals.total;
+            ++totals.per_level[level];
+            if (collect) {
+                chunk.output.append(line, length);
+            }
+            if (options.stats) {
+                totals.min_length = std::min(totals.min_length, length);
+                totals.max_length = std::max(totals.max_length, length);
+                totals.sum_length += length;
+                auto ms = clock.timestamp_ms(std::string_view(line, length));
+                totals.last_hour += ms && *ms / 1000 > hour_ago;
+            }
+        }
+    );
+}
+
+using ScanFunction = void (*)(Chunk &, const Options &, std::int64_t);
+
+// Each kernel is compiled for its instruction set with everything inlined
+#ifdef LOGGERLIB_SCAN_X86
+__attribute__((target("avx2"), flatten)) void
+scan_avx2(Chunk &chunk, const Options &options, std::int64_t hour_ago) {
+    scan_chunk<scan::Avx2>(chunk, options, hour_ago);
+}
+
+__attribute__((target("sse2"), flatten)) void
+scan_sse2(Chunk &chunk, const Options &options, std::int64_t hour_ago) {
+    scan_chunk<scan::Sse2>(chunk, options, hour_ago);
+}
+#endif
+
+__attribute__((flatten)) void
+scan_scalar(Chunk &chunk, const Options &options, std::int64_t hour_ago) {
+    scan_chunk<scan::Scalar>(chunk, options, hour_ago);
+}
+
+std::optional<std::pair<ScanFunction, const char *>>
+pick_kernel(const std::string &isa) {
+#ifdef LOGGERLIB_SCAN_X86
+    __builtin_cpu_init();
+    bool avx2 = __builtin_cpu_supports("avx2");
+    if (isa == "avx2" ? avx2 : isa.empty() && avx2) {
+        return std::pair{&scan_avx2, scan::Avx2::name()};
+    }
+    if (isa == "sse2" || isa.empty()) {
+        return std::pair{&scan_sse2, scan::Sse2::name()};
+    }
+#endif
+    if (isa == "scalar" || isa.empty()) {
+        return std::pair{&scan_scalar, scan::Scalar::name()};
+    }
+    return std::nullopt;
+}
+
+// Chunks of about CHUNK_SIZE ending at line boundaries
+std::vector<Chunk> split(const char *data, std::size_t size) {
+    std::vector<Chunk> chunks;
+    const char *end = data + size;
+    const char *pos = data;
+    while (pos < end) {
+        const char *stop =
+            pos + std::min(CHUNK_SIZE, static_cast<std::size_t>(end - pos));
+        if (stop < end) {
+            const auto *eol = static_cast<const char *>(
+                std::memchr(stop, '\n', static_cast<std::size_t>(end - stop))
+            );
+            stop = eol ? eol + 1 : end;
+        }
+        chunks.push_back(Chunk{pos, stop, {}, {}, false});
+        pos = stop;
+    }
+    return chunks;
+}
+
+// Worker threads take chunks in order, the main thread writes the results
+// in the same order. Workers stay at most a few chunks ahead of the output.
+Totals scan_file(
+    const char *data,
+    std::size_t size,
+    const Options &options,
+    ScanFunction kernel,
+    std::int64_t hour_ago
+) {
+    auto chunks = split(data, size);
+    std::atomic<std::size_t> next{0};
+    std::size_t written = 0;
+    std::size_t window = 2 * options.threads;
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    auto worker = [&]() {
+        while (true) {
+            std::size_t index = next.fetch_add(1);
+            if (index >= chunks.size()) {
+                return;
+            }
+            {
+                std::unique_lock lock(mutex);
+                changed.wait(lock, [&] { return index < written + window; });
+            }
+            kernel(chunks[index], options, hour_ago);
+            {
+                std::lock_guard lock(mutex);
+                chunks[index].done = true;
+            }
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < options.threads; ++i) {
+        threads.emplace_back(worker);
+    }
+
+    Totals totals;
+    for (auto &chunk : chunks) {
+        {
+            std::unique_lock lock(mutex);
+            changed.wait(lock, [&] { return chunk.done; });
+        }
+        loggerlib::write_all(
+            STDOUT_FILENO, chunk.output.data(), chunk.output.size()
+        );
+        totals.merge(chunk.totals);
+        std::string().swap(chunk.output);
+        {
+            std::lock_guard lock(mutex);
+            ++written;
+        }
+        changed.notify_all();
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    return totals;
+}
+
+// Same block as formatStats in logger-stats-app
+void print_stats(const Totals &totals) {
+    std::size_t min_length = totals.total ? totals.min_length : 0;
+    double avg_length =
+        totals.total ? static_cast<double>(totals.sum_length) /
+                           static_cast<double>(totals.total)
+                     : 0.0;
+    std::cout << "\n============ Statistics ============\n"
+              << "Total messages: " << totals.total << "\n"
+              << "DEBUG: " << totals.per_level[0]
+              << ", INFO: " << totals.per_level[1]
+              << ", ERROR: " << totals.per_level[2] << "\n"
+              << "Last hour: " << totals.last_hour << "\n"
+              << "Length - min: " << min_length
+              << ", max: " << totals.max_length << ", avg: " << avg_length
+              << "\n"
+              << "====================================\n";
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--level" && has_value) {
+            auto level = parse_level(argv[++i]);
+            if (!level) {
+                usage(argv[0]);
+                return 1;
+            }
+            options.level = *level;
+        } else if (arg == "--grep" && has_value) {
+            options.needle = argv[++i];
+        } else if (arg == "--count") {
+            options.count = true;
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg == "--threads" && has_value) {
+            options.threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--isa" && has_value) {
+            options.isa = argv[++i];
+        } else if (!arg.empty() && arg[0] != '-') {
+            options.files.push_back(arg);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.files.empty() ||
+        options.needle.find('\n') != std::string::npos) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    auto kernel = pick_kernel(options.isa);
+    if (!kernel) {
+        std::cerr << "Unsupported instruction set: " << options.isa << "\n";
+        return 1;
+    }
+
+    auto hour_ago = std::chrono::duration_cast<std::chrono::seconds>(
+                        std::chrono::system_clock::now().time_since_epoch()
+                    )
+                        .count() -
+                    3600;
+
+    Totals totals;
+    int status = 0;
+    for (const auto &path : options.files) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st{};
+        if (fd == -1 || fstat(fd, &st) != 0) {
+            std::cerr << "Cannot open log file: " << path << "\n";
+            if (fd != -1) {
+                close(fd);
+            }
+            status = 1;
+            continue;
+        }
+        auto size = static_cast<std::size_t>(st.st_size);
+        if (size == 0) {
+            close(fd);
+            continue;
+        }
+
+        void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Cannot map log file: " << path << "\n";
+            status = 1;
+            continue;
+        }
+        madvise(mapped, size, MADV_SEQUENTIAL);
+        madvise(mapped, size, MADV_WILLNEED);
+
+        totals.merge(scan_file(
+            static_cast<const char *>(mapped), size, options, kernel->first,
+            hour_ago
+        ));
+        munmap(mapped, size);
+    }
+
+    if (options.count) {
+        std::cout << "DEBUG: " << totals.per_level[0]
+                  << ", INFO: " << totals.per_level[1]
+                  << ", ERROR: " << totals.per_level[2]
+                  << ", total: " << totals.total << " (" << kernel->second
+                  << ")\n";
+    }
+    if (options.stats) {
+        print_stats(totals);
+    }
+    return status;
+}
@@ -0,0 +1,131 @@
+#ifndef LOGGERLIB_TOOLS_SCAN_SIMD_HPP_
+#define LOGGERLIB_TOOLS_SCAN_SIMD_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LOGGERLIB_SCAN_X86 1
+#endif
+
+// Byte-compare kernels of loggerlib-scan. Each instruction set gives
+//   std::uint64_t eq64(const char *p, char ch)
+// - bit i set if p[i] == ch, for the 64 bytes at p. Callers stay 64 bytes
+// away from the end of the mapping and finish the tail byte by byte.
+
+namespace scan {
+
+struct Scalar {
+    static const char *name() {
+        return "scalar";
+    }
+    static std::uint64_t eq64(const char *p, char ch) {
+        std::uint64_t mask = 0;
+        for (int i = 0; i < 64; ++i) {
+            mask |= static_cast<std::uint64_t>(p[i] == ch) << i;
+        }
+        return mask;
+    }
+};
+
+#ifdef LOGGERLIB_SCAN_X86
+
+struct Sse2 {
+    static const char *name() {
+        return "sse2";
+    }
+    __attribute__((target("sse2"))) static std::uint64_t
+    eq64(const char *p, char ch) {
+        __m128i needle = _mm_set1_epi8(ch);
+        std::uint64_t mask = 0;
+        for (int i = 0; i < 4; ++i) {
+            __m128i block = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(p + 16 * i)
+            );
+            auto bits = static_cast<std::uint32_t>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle))
+            );
+            mask |= static_cast<std::uint64_t>(bits) << (16 * i);
+        }
+        return mask;
+    }
+};
+
+struct Avx2 {
+    static const char *name() {
+        return "avx2";
+    }
+    __attribute__((target("avx2"))) static std::uint64_t
+    eq64(const char *p, char ch) {
+        __m256i needle = _mm256_set1_epi8(ch);
+        __m256i low =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i high =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32));
+        auto low_bits = static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(low, needle))
+        );
+        auto high_bits = static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(high, needle))
+        );
+        return static_cast<std::uint64_t>(high_bits) << 32 | low_bits;
+    }
+};
+
+#endif
+
+// Call on_line(begin, end) for every line in [pos, end), '\n' included.
+// Line ends come from one compare per 64 bytes, however short the lines.
+template <typename Isa, typename F>
+void for_each_line(const char *pos, const char *end, F &&on_line) {
+    const char *line = pos;
+    while (end - pos >= 64) {
+        std::uint64_t mask = Isa::eq64(pos, '\n');
+        while (mask) {
+            const char *next = pos + __builtin_ctzll(mask) + 1;
+            on_line(line, next);
+            line = next;
+            mask &= mask - 1;
+        }
+        pos += 64;
+    }
+    for (; pos < end; ++pos) {
+        if (*pos == '\n') {
+            on_line(line, pos + 1);
+            line = pos + 1;
+        }
+    }
+    if (line < end) {
+        on_line(line, end);
+    }
+}
+
+// First occurrence of needle in [pos, end), end if none. Candidates are
+// positions where both the first and the last byte of the needle match,
+// 64 at a time; only those are compared in full.
+template <typename Isa>
+const char *find(const char *pos, const char *end, std::string_view needle) {
+    std::size_t last = needle.size() - 1;
+    while (end - pos >= static_cast<std::ptrdiff_t>(64 + last)) {
+        std::uint64_t mask = Isa::eq64(pos, needle.front()) &
+                             Isa::eq64(pos + last, needle.back());
+        while (mask) {
+            const char *candidate = pos + __builtin_ctzll(mask);
+            if (std::memcmp(candidate + 1, needle.data() + 1, last) == 0) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+        pos += 64;
+    }
+    std::string_view rest(pos, static_cast<std::size_t>(end - pos));
+    auto found = rest.find(needle);
+    return found == std::string_view::npos ? end : pos + found;
+}
+
+}  // namespace scan
+
+#endif  // LOGGERLIB_TOOLS_SCAN_SIMD_HPP_